@@ -0,0 +1,198 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include "AnnexB.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ANNEXB_ENABLE_SSE2 1
+#if defined(_MSC_VER) || defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define ANNEXB_ENABLE_AVX2 1
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__) || defined(_M_ARM64)
+#define ANNEXB_ENABLE_NEON 1
+#endif
+
+#if defined(ANNEXB_ENABLE_SSE2)
+#include <immintrin.h>
+#elif defined(ANNEXB_ENABLE_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define ANNEXB_TARGET_AVX2
+#else
+#define ANNEXB_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace mediakit {
+
+using FindStartCode = const char *(*)(const char *ptr, const char *end);
+
+static inline unsigned countTrailingZero(uint64_t val) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long ret;
+#if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanForward64(&ret, val);
+#else
+    if (!_BitScanForward(&ret, (unsigned long)val)) {
+        _BitScanForward(&ret, (unsigned long)(val >> 32));
+        ret += 32;
+    }
+#endif
+    return ret;
+#else
+    return __builtin_ctzll(val);
+#endif
+}
+
+// 以00 00 01中的0x01为锚点，借助memchr(libc中通常已向量化)跳跃搜索
+static const char *findStartCodeScalar(const char *ptr, const char *end) {
+    if (end - ptr < 3) {
+        return nullptr;
+    }
+    auto pos = ptr + 2;
+    while (pos < end) {
+        pos = (const char *)memchr(pos, 0x01, end - pos);
+        if (!pos) {
+            return nullptr;
+        }
+        if (pos[-1] == 0x00 && pos[-2] == 0x00) {
+            return pos - 2;
+        }
+        ++pos;
+    }
+    return nullptr;
+}
+
+#if defined(ANNEXB_ENABLE_SSE2)
+// 每次比较16个位置: p[i] == 0 && p[i + 1] == 0 && p[i + 2] == 1
+static const char *findStartCodeSSE2(const char *ptr, const char *end) {
+    const auto zero = _mm_setzero_si128();
+    const auto one = _mm_set1_epi8(1);
+    auto pos = ptr;
+    while (end - pos >= 16 + 2) {
+        auto v0 = _mm_loadu_si128((const __m128i *)pos);
+        auto v1 = _mm_loadu_si128((const __m128i *)(pos + 1));
+        auto v2 = _mm_loadu_si128((const __m128i *)(pos + 2));
+        auto hit = _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(v0, v1), zero), _mm_cmpeq_epi8(v2, one));
+        auto mask = (unsigned)_mm_movemask_epi8(hit);
+        if (mask) {
+            return pos + countTrailingZero(mask);
+        }
+        pos += 16;
+    }
+    return findStartCodeScalar(pos, end);
+}
+#endif
+
+#if defined(ANNEXB_ENABLE_AVX2)
+ANNEXB_TARGET_AVX2 static const char *findStartCodeAVX2(const char *ptr, const char *end) {
+    const auto zero = _mm256_setzero_si256();
+    const auto one = _mm256_set1_epi8(1);
+    auto pos = ptr;
+    while (end - pos >= 32 + 2) {
+        auto v0 = _mm256_loadu_si256((const __m256i *)pos);
+        auto v1 = _mm256_loadu_si256((const __m256i *)(pos + 1));
+        auto v2 = _mm256_loadu_si256((const __m256i *)(pos + 2));
+        auto hit = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_or_si256(v0, v1), zero), _mm256_cmpeq_epi8(v2, one));
+        auto mask = (unsigned)_mm256_movemask_epi8(hit);
+        if (mask) {
+            return pos + countTrailingZero(mask);
+        }
+        pos += 32;
+    }
+    // 剩余不足32字节，交给SSE2处理
+    return findStartCodeSSE2(pos, end);
+}
+
+static bool cpuSupportAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // OSXSAVE && AVX
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) {
+        return false;
+    }
+    // 操作系统需要保存ymm寄存器状态
+    if ((_xgetbv(0) & 0x06) != 0x06) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#if defined(ANNEXB_ENABLE_NEON)
+static const char *findStartCodeNEON(const char *ptr, const char *end) {
+    const auto zero = vdupq_n_u8(0);
+    const auto one = vdupq_n_u8(1);
+    auto pos = ptr;
+    while (end - pos >= 16 + 2) {
+        auto v0 = vld1q_u8((const uint8_t *)pos);
+        auto v1 = vld1q_u8((const uint8_t *)(pos + 1));
+        auto v2 = vld1q_u8((const uint8_t *)(pos + 2));
+        auto hit = vandq_u8(vceqq_u8(vorrq_u8(v0, v1), zero), vceqq_u8(v2, one));
+        // 每字节压缩为4bit，得到64位掩码
+        auto mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+        if (mask) {
+            return pos + (countTrailingZero(mask) >> 2);
+        }
+        pos += 16;
+    }
+    return findStartCodeScalar(pos, end);
+}
+#endif
+
+struct AnnexBScanner {
+    FindStartCode find;
+    const char *name;
+};
+
+static const AnnexBScanner &getAnnexBScanner() {
+    static AnnexBScanner s_scanner = []() -> AnnexBScanner {
+#if defined(ANNEXB_ENABLE_AVX2)
+        if (cpuSupportAVX2()) {
+            return { findStartCodeAVX2, "avx2" };
+        }
+#endif
+#if defined(ANNEXB_ENABLE_SSE2)
+        return { findStartCodeSSE2, "sse2" };
+#elif defined(ANNEXB_ENABLE_NEON)
+        return { findStartCodeNEON, "neon" };
+#else
+        return { findStartCodeScalar, "scalar" };
+#endif
+    }();
+    return s_scanner;
+}
+
+const char *findAnnexBStartCode(const char *ptr, const char *end) {
+    return getAnnexBScanner().find(ptr, end);
+}
+
+const char *getAnnexBScannerName() {
+    return getAnnexBScanner().name;
+}
+
+} // namespace mediakit
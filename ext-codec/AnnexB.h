@@ -0,0 +1,34 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_ANNEXB_H
+#define ZLMEDIAKIT_ANNEXB_H
+
+#include <cstddef>
+
+namespace mediakit {
+
+/**
+ * 在[ptr, end)中查找第一个00 00 01起始码
+ * 运行时根据cpu能力选择AVX2/SSE2/NEON实现，不支持时回退到标量实现
+ * @param ptr 搜索起始位置
+ * @param end 搜索结束位置(不包含)
+ * @return 起始码首字节位置，未找到返回nullptr
+ */
+const char *findAnnexBStartCode(const char *ptr, const char *end);
+
+/**
+ * 获取当前使用的起始码搜索实现名称，用于日志和性能测试
+ */
+const char *getAnnexBScannerName();
+
+} // namespace mediakit
+
+#endif // ZLMEDIAKIT_ANNEXB_H
@@ -53,7 +53,7 @@ FFmpegSource::~FFmpegSource() {
     DebugL;
 }
 
-static bool is_local_ip(const string &ip){
+bool is_local_ip(const string &ip){
     if (ip == "127.0.0.1" || ip == "localhost") {
         return true;
     }
@@ -23,6 +23,9 @@ namespace FFmpeg {
     extern const std::string kBin;
 }
 
+// 判断是否为本机ip
+bool is_local_ip(const std::string &ip);
+
 class FFmpegSnap {
 public:
     using onSnap = std::function<void(bool success, const std::string &err_msg)>;
@@ -0,0 +1,341 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#if defined(ENABLE_FFMPEG)
+
+#include "SnapEngine.h"
+#include "FFmpegSource.h"
+#include "Common/config.h"
+#include "Common/MultiMediaSourceMuxer.h"
+#include "Codec/Transcode.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+namespace API {
+const string kSnapInProcess = "api.snapInProcess";
+const string kSnapThreadNum = "api.snapThreadNum";
+const string kSnapWidth = "api.snapWidth";
+
+static onceToken token([]() {
+    mINI::Instance()[kSnapInProcess] = 1;
+    mINI::Instance()[kSnapThreadNum] = 2;
+    mINI::Instance()[kSnapWidth] = 0;
+});
+} // namespace API
+
+// 每个截图线程最多排队的任务数，超过后拒绝截图，防止任务堆积
+static constexpr size_t kMaxTaskPerThread = 64;
+// 内存中的截图最长保留时间，单位毫秒
+static constexpr uint64_t kMaxCacheMS = 5 * 60 * 1000;
+// 截图后帧级环形缓存最短保留时间，单位毫秒，期间再次截图无需等待关键帧
+static constexpr uint64_t kMinKeepRingMS = 30 * 1000;
+
+/**
+ * 在流的归属线程中从gop缓存收集最近的关键帧
+ * 收集到关键帧之后的第一个视频帧时，说明关键帧已经完整
+ * 优先读取按需转协议共享的帧级gop缓存，不存在或不完整时才读取帧级环形缓存
+ * 环形缓存在一段时间内无截图请求后才释放，避免周期性截图每次都要等待一个gop
+ */
+class KeyFrameCollector : public std::enable_shared_from_this<KeyFrameCollector> {
+public:
+    using Ptr = std::shared_ptr<KeyFrameCollector>;
+    using onCollect = std::function<void(std::vector<Frame::Ptr> frames, const string &err_msg)>;
+
+    KeyFrameCollector(Track::Ptr track, uint64_t keep_ring_ms, onCollect cb)
+        : _keep_ring_ms(keep_ring_ms), _track(std::move(track)), _cb(std::move(cb)) {}
+
+    // 请在流的归属线程调用
+    void start(const std::shared_ptr<MultiMediaSourceMuxer> &muxer, const EventPoller::Ptr &poller, float timeout_sec) {
+        auto self = shared_from_this();
+        replay(muxer->getGopFrames());
+        if (_complete) {
+            onDone("");
+            return;
+        }
+        reset();
+
+        _muxer = muxer;
+        auto reader = muxer->getFrameRing()->attach(poller, true);
+        reader->setDetachCB([self]() { self->onDone("media source released"); });
+        // 设置回调时会同步输出环形缓存中的gop
+        _replaying = true;
+        reader->setReadCB([self](const Frame::Ptr &frame) { self->onFrame(frame); });
+        _replaying = false;
+        if (_complete) {
+            reader = nullptr;
+            onDone("");
+            return;
+        }
+        if (!_cb) {
+            return;
+        }
+        _reader = std::move(reader);
+        _timer = poller->doDelayTask((uint64_t)(timeout_sec * 1000), [self]() {
+            self->onDone("wait key frame timeout");
+            return 0;
+        });
+    }
+
+private:
+    void replay(const std::vector<Frame::Ptr> &frames) {
+        _replaying = true;
+        for (auto &frame : frames) {
+            onFrame(frame);
+        }
+        _replaying = false;
+    }
+
+    void reset() {
+        _complete = false;
+        _key_frame = nullptr;
+        _frames.clear();
+    }
+
+    void onFrame(const Frame::Ptr &frame) {
+        if (frame->getIndex() != _track->getIndex()) {
+            return;
+        }
+        auto gop_start = frame->keyFrame() || frame->configFrame();
+        if (_key_frame && frame->dts() != _key_frame->dts()) {
+            if (gop_start && _replaying) {
+                // 回放的缓存中存在多个关键帧，以最新的为准
+                reset();
+            } else {
+                if (!_complete) {
+                    // 多收集的这一帧用于触发解码器合帧输出
+                    _frames.emplace_back(frame);
+                    _complete = true;
+                }
+                if (!_replaying) {
+                    onDone("");
+                }
+                return;
+            }
+        }
+        if (!_key_frame) {
+            if (frame->configFrame() || frame->dropAble()) {
+                _frames.emplace_back(frame);
+                return;
+            }
+            if (!frame->keyFrame()) {
+                // 等待关键帧
+                _frames.clear();
+                return;
+            }
+            _key_frame = frame;
+        }
+        _frames.emplace_back(frame);
+    }
+
+    void onDone(const string &err_msg) {
+        if (!_cb) {
+            return;
+        }
+        _reader = nullptr;
+        if (auto muxer = _muxer.lock()) {
+            // 截图不需要一直缓存gop，但是短时间内可能再次截图
+            muxer->releaseFrameRing(_keep_ring_ms);
+        }
+        if (_timer) {
+            _timer->cancel();
+            _timer = nullptr;
+        }
+        auto cb = std::move(_cb);
+        _cb = nullptr;
+        cb(err_msg.empty() ? std::move(_frames) : std::vector<Frame::Ptr>(), err_msg);
+    }
+
+private:
+    bool _complete = false;
+    bool _replaying = false;
+    uint64_t _keep_ring_ms;
+    Frame::Ptr _key_frame;
+    Track::Ptr _track;
+    onCollect _cb;
+    std::vector<Frame::Ptr> _frames;
+    EventPoller::DelayTask::Ptr _timer;
+    std::weak_ptr<MultiMediaSourceMuxer> _muxer;
+    MultiMediaSourceMuxer::RingType::RingReader::Ptr _reader;
+};
+
+static Buffer::Ptr encodeSnap(const Track::Ptr &track, const std::vector<Frame::Ptr> &frames) {
+    GET_CONFIG(int, snap_width, API::kSnapWidth);
+
+    FFmpegFrame::Ptr picture;
+    FFmpegDecoder decoder(track, 1);
+    decoder.setOnDecode([&](const FFmpegFrame::Ptr &frame) {
+        if (!picture) {
+            picture = frame;
+        }
+    });
+    for (auto &frame : frames) {
+        decoder.inputFrame(frame, false, false);
+        if (picture) {
+            break;
+        }
+    }
+    if (!picture) {
+        decoder.flush();
+    }
+    if (!picture) {
+        throw std::runtime_error("decode key frame failed");
+    }
+
+    auto width = picture->get()->width;
+    auto height = picture->get()->height;
+    if (snap_width > 0 && snap_width < width) {
+        // 按比例缩放，jpeg编码要求宽高为偶数
+        height = (height * snap_width / width) & ~1;
+        width = snap_width & ~1;
+    }
+    FFmpegSws sws(AV_PIX_FMT_YUVJ420P, width, height);
+    auto yuv = sws.inputFrame(picture);
+    if (!yuv) {
+        throw std::runtime_error("convert picture to yuvj420p failed");
+    }
+    auto jpeg = FFmpegJpegEncoder().inputFrame(yuv);
+    if (!jpeg) {
+        throw std::runtime_error("encode jpeg failed");
+    }
+    return jpeg;
+}
+
+INSTANCE_IMP(SnapEngine)
+
+MediaSource::Ptr SnapEngine::findLocalSource(const string &play_url) {
+    MediaInfo info;
+    try {
+        info.parse(play_url);
+    } catch (std::exception &ex) {
+        return nullptr;
+    }
+    if (!is_local_ip(info.host)) {
+        return nullptr;
+    }
+    // 各协议共享同一个复用器，不区分协议
+    return MediaSource::find(info.vhost, info.app, info.stream);
+}
+
+bool SnapEngine::makeSnap(const MediaSource::Ptr &src, float timeout_sec, int expire_sec, onSnap cb) {
+    auto muxer = src->getMuxer();
+    if (!muxer) {
+        return false;
+    }
+    Track::Ptr video;
+    for (auto &track : src->getTracks(true)) {
+        if (track->getTrackType() == TrackVideo) {
+            video = track;
+            break;
+        }
+    }
+    if (!video) {
+        return false;
+    }
+
+    auto key = src->getMediaTuple().shortUrl();
+    Buffer::Ptr cached;
+    {
+        lock_guard<mutex> lck(_mtx);
+        auto it = _cache.find(key);
+        if (it != _cache.end() && it->second.ticker.elapsedTime() <= (uint64_t)expire_sec * 1000) {
+            // 内存中的截图未过期
+            cached = it->second.jpeg;
+        } else {
+            auto &cbs = _pending[key];
+            cbs.emplace_back(std::move(cb));
+            if (cbs.size() > 1) {
+                // 该流已经在截图中，合并请求
+                return true;
+            }
+        }
+    }
+    if (cached) {
+        cb(cached, "");
+        return true;
+    }
+
+    auto keep_ring_ms = MAX(kMinKeepRingMS, (uint64_t)expire_sec * 2 * 1000);
+    auto collector = std::make_shared<KeyFrameCollector>(video, keep_ring_ms, [key, video](std::vector<Frame::Ptr> frames, const string &err_msg) {
+        if (!err_msg.empty()) {
+            SnapEngine::Instance().onSnapResult(key, nullptr, err_msg);
+            return;
+        }
+        auto frames_ptr = std::make_shared<std::vector<Frame::Ptr>>(std::move(frames));
+        auto added = SnapEngine::Instance().addTask([key, video, frames_ptr]() {
+            Buffer::Ptr jpeg;
+            string err;
+            try {
+                jpeg = encodeSnap(video, *frames_ptr);
+            } catch (std::exception &ex) {
+                err = ex.what();
+            }
+            SnapEngine::Instance().onSnapResult(key, jpeg, err);
+        });
+        if (!added) {
+            SnapEngine::Instance().onSnapResult(key, nullptr, "snap threads are too busy");
+        }
+    });
+
+    auto poller = src->getOwnerPoller();
+    poller->async([collector, muxer, poller, timeout_sec]() { collector->start(muxer, poller, timeout_sec); });
+    return true;
+}
+
+bool SnapEngine::addTask(std::function<void()> task) {
+    GET_CONFIG(int, thread_num, API::kSnapThreadNum);
+    std::shared_ptr<ThreadPool> pool;
+    {
+        lock_guard<mutex> lck(_mtx);
+        if (!_pool) {
+            _pool = std::make_shared<ThreadPool>(MAX(thread_num, 1), ThreadPool::PRIORITY_LOWEST, true);
+        }
+        pool = _pool;
+    }
+    if (pool->size() > kMaxTaskPerThread * MAX(thread_num, 1)) {
+        return false;
+    }
+    pool->async(std::move(task), false);
+    return true;
+}
+
+void SnapEngine::onSnapResult(const string &key, const Buffer::Ptr &jpeg, const string &err_msg) {
+    std::vector<onSnap> cbs;
+    {
+        lock_guard<mutex> lck(_mtx);
+        auto it = _pending.find(key);
+        if (it != _pending.end()) {
+            cbs = std::move(it->second);
+            _pending.erase(it);
+        }
+        if (jpeg) {
+            // 清理长时间未更新的截图
+            for (auto it = _cache.begin(); it != _cache.end();) {
+                if (it->second.ticker.elapsedTime() > kMaxCacheMS) {
+                    it = _cache.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            auto &cache = _cache[key];
+            cache.jpeg = jpeg;
+            cache.ticker.resetTime();
+        }
+    }
+    if (!err_msg.empty()) {
+        WarnL << "make snap of " << key << " failed:" << err_msg;
+    }
+    for (auto &cb : cbs) {
+        cb(jpeg, err_msg);
+    }
+}
+
+#endif // ENABLE_FFMPEG
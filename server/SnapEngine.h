@@ -0,0 +1,83 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_SNAPENGINE_H
+#define ZLMEDIAKIT_SNAPENGINE_H
+
+#if defined(ENABLE_FFMPEG)
+
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include "Network/Buffer.h"
+#include "Util/TimeTicker.h"
+#include "Thread/ThreadPool.h"
+#include "Common/MediaSource.h"
+
+namespace API {
+// 本机流是否在进程内截图(从gop缓存解码最近的关键帧)，否则启动FFmpeg进程截图
+extern const std::string kSnapInProcess;
+// 进程内截图的解码编码线程数
+extern const std::string kSnapThreadNum;
+// 进程内截图的宽度，高度按比例缩放，0为原始分辨率
+extern const std::string kSnapWidth;
+} // namespace API
+
+/**
+ * 进程内截图，从本机媒体源的gop缓存中获取最近的关键帧，解码、缩放后编码为jpeg
+ * 同一个流的并发截图请求合并为一次解码，截图结果缓存在内存中
+ */
+class SnapEngine {
+public:
+    using onSnap = std::function<void(const toolkit::Buffer::Ptr &jpeg, const std::string &err_msg)>;
+
+    static SnapEngine &Instance();
+
+    /**
+     * 根据播放url查找本机的媒体源
+     * @param play_url 播放url地址
+     * @return 非本机地址或者流不存在时返回nullptr
+     */
+    static mediakit::MediaSource::Ptr findLocalSource(const std::string &play_url);
+
+    /**
+     * 创建截图
+     * @param src 本机媒体源
+     * @param timeout_sec 等待关键帧超时时间
+     * @param expire_sec 内存中的截图未超过该时间时直接返回
+     * @param cb 截图结果回调，可能在其他线程触发
+     * @return 该媒体源不支持进程内截图(无视频或非复用器产生的流)时返回false且不会触发回调
+     */
+    bool makeSnap(const mediakit::MediaSource::Ptr &src, float timeout_sec, int expire_sec, onSnap cb);
+
+private:
+    SnapEngine() = default;
+
+    void onSnapResult(const std::string &key, const toolkit::Buffer::Ptr &jpeg, const std::string &err_msg);
+    bool addTask(std::function<void()> task);
+
+private:
+    struct SnapCache {
+        toolkit::Buffer::Ptr jpeg;
+        toolkit::Ticker ticker;
+    };
+
+    std::mutex _mtx;
+    // 截图中的流及其等待中的请求
+    std::unordered_map<std::string, std::vector<onSnap>> _pending;
+    // 最近一次截图结果
+    std::unordered_map<std::string, SnapCache> _cache;
+    std::shared_ptr<toolkit::ThreadPool> _pool;
+};
+
+#endif // ENABLE_FFMPEG
+#endif // ZLMEDIAKIT_SNAPENGINE_H
@@ -39,9 +39,11 @@
 #include "WebApi.h"
 #include "WebHook.h"
 #include "FFmpegSource.h"
+#include "SnapEngine.h"
 
 #include "Common/config.h"
 #include "Common/MediaSource.h"
+#include "Common/UdpBatchSender.h"
 #include "Http/HttpSession.h"
 #include "Http/HttpRequester.h"
 #include "Player/PlayerProxy.h"
@@ -57,6 +59,11 @@
 #include "../webrtc/WebRtcPlayer.h"
 #include "../webrtc/WebRtcPusher.h"
 #include "../webrtc/WebRtcEchoTest.h"
+#include "../webrtc/WebRtcSession.h"
+#endif
+
+#if defined(ENABLE_SRT)
+#include "../srt/SrtSession.hpp"
 #endif
 
 #if defined(ENABLE_VERSION)
@@ -404,6 +411,11 @@ Value makeMediaSourceJson(MediaSource &media){
     item["createStamp"] = (Json::UInt64) media.getCreateStamp();
     item["aliveSecond"] = (Json::UInt64) media.getAliveSecond();
     item["bytesSpeed"] = media.getBytesSpeed();
+    // 本协议环形缓冲gop缓存占用的内存
+    item["cacheBytes"] = (Json::UInt64) media.getCacheBytes();
+    auto muxer = media.getMuxer();
+    // 所有协议共享的帧级gop缓存占用的内存
+    item["gopCacheBytes"] = (Json::UInt64) (muxer ? muxer->getGopCacheBytes() : 0);
     item["readerCount"] = media.readerCount();
     item["totalReaderCount"] = media.totalReaderCount();
     item["originType"] = (int) media.getOriginType();
@@ -470,6 +482,23 @@ Value makeMediaSourceJson(MediaSource &media){
         }
         item["tracks"].append(obj);
     }
+
+    if (current_thread) {
+        // 开启parallel_mux时，各协议复用器线程的队列深度与延时
+        if (auto muxer = media.getMuxer()) {
+            muxer->getMuxerStatistic([&](const std::string &name, const MultiMediaSourceMuxer::MuxerStatistic &stat) {
+                Value obj;
+                obj["name"] = name;
+                obj["thread"] = stat.thread_name;
+                obj["queue_depth"] = (Json::UInt64)stat.queue_depth;
+                obj["max_queue_depth"] = (Json::UInt64)stat.max_queue_depth;
+                obj["frames"] = (Json::UInt64)stat.frames;
+                obj["avg_latency_ms"] = stat.avg_latency_ms;
+                obj["max_latency_ms"] = (Json::UInt64)stat.max_latency_ms;
+                item["muxer"].append(obj);
+            });
+        }
+    }
     return item;
 }
 
@@ -518,6 +547,21 @@ void getStatisticJson(const function<void(Value &val)> &cb) {
 
     val["RtpPacket"] = (Json::UInt64)(ObjectStatistic<RtpPacket>::count());
     val["RtmpPacket"] = (Json::UInt64)(ObjectStatistic<RtmpPacket>::count());
+
+    // udp rtp批量发送统计，用于计算平均每次系统调用发送的包数
+    auto udp_batch_syscalls = UdpBatchSender::getTotalSyscalls();
+    auto udp_batch_packets = UdpBatchSender::getTotalPackets();
+    val["UdpBatchSyscalls"] = (Json::UInt64)udp_batch_syscalls;
+    val["UdpBatchPackets"] = (Json::UInt64)udp_batch_packets;
+    val["UdpPacketsPerSyscall"] = udp_batch_syscalls ? (double)udp_batch_packets / udp_batch_syscalls : 0;
+#ifdef ENABLE_WEBRTC
+    // rtc播放器共享rtp缓存命中统计
+    auto rtp_cache_hit = SharedRtpCache::getTotalHit();
+    auto rtp_cache_miss = SharedRtpCache::getTotalMiss();
+    val["RtcRtpCacheHit"] = (Json::UInt64)rtp_cache_hit;
+    val["RtcRtpCacheMiss"] = (Json::UInt64)rtp_cache_miss;
+    val["RtcRtpCacheHitRate"] = rtp_cache_hit + rtp_cache_miss ? (double)rtp_cache_hit / (rtp_cache_hit + rtp_cache_miss) : 0;
+#endif
 #ifdef ENABLE_MEM_DEBUG
     auto bytes = getTotalMemUsage();
     val["totalMemUsage"] = (Json::UInt64) bytes;
@@ -903,6 +947,40 @@ void installWebApi() {
                 auto &sock = info.get<SockInfo>();
                 fillSockInfo(*obj, &sock);
                 (*obj)["typeid"] = toolkit::demangle(typeid(sock).name());
+#ifdef ENABLE_WEBRTC
+                // 该转换函数在播放器所在poller线程执行
+                auto session = dynamic_cast<WebRtcSession *>(&sock);
+                auto transport = session ? session->getTransport() : nullptr;
+                if (transport && transport->getSendBwe()) {
+                    auto &bwe = (*obj)["rtc_bwe"];
+                    bwe["estimate_bitrate"] = transport->getSendBwe()->getEstimateBitrate();
+                    bwe["acked_bitrate"] = transport->getSendBwe()->getAckedBitrate();
+                    bwe["loss_rate"] = transport->getSendBwe()->getLossRate();
+                    bwe["delay_trend"] = transport->getSendBwe()->getDelayTrend();
+                    bwe["pacer_queue_bytes"] = (Json::UInt64)transport->getPacer()->getQueueBytes();
+                    bwe["pacer_queue_ms"] = (Json::UInt64)transport->getPacer()->getQueueDelayMS();
+                }
+                auto player = dynamic_pointer_cast<WebRtcPlayer>(transport);
+                if (player && !player->getLayer().empty()) {
+                    (*obj)["rtc_layer"] = player->getLayer();
+                }
+#endif
+#if defined(ENABLE_SRT)
+                auto srt_session = dynamic_cast<SRT::SrtSession *>(&sock);
+                auto srt_transport = srt_session ? srt_session->getTransport() : nullptr;
+                if (srt_transport && srt_transport->getLiveCC()) {
+                    auto &cc = srt_transport->getLiveCC();
+                    auto &obj_cc = (*obj)["srt_cc"];
+                    obj_cc["input_rate"] = (Json::UInt64)cc->getInputRate();
+                    obj_cc["send_rate"] = (Json::UInt64)cc->getSendRate();
+                    obj_cc["queue_bytes"] = (Json::UInt64)cc->getQueueBytes();
+                    obj_cc["queue_ms"] = (Json::UInt64)cc->getQueueDelayMS();
+                    obj_cc["send_packets"] = (Json::UInt64)cc->getSendPackets();
+                    obj_cc["send_bytes"] = (Json::UInt64)cc->getSendBytes();
+                    obj_cc["retransmit_packets"] = (Json::UInt64)cc->getRetransmitPackets();
+                    obj_cc["retransmit_bytes"] = (Json::UInt64)cc->getRetransmitBytes();
+                }
+#endif
                 toolkit::Any ret;
                 ret.set(obj);
                 return ret;
@@ -1727,11 +1805,11 @@ void installWebApi() {
         val["data"]["paths"] = paths;
     });
 
+    static bool s_snap_success_once = false;
     static auto responseSnap = [](const string &snap_path,
                                   const HttpSession::KeyValue &headerIn,
                                   const HttpSession::HttpResponseInvoker &invoker,
                                   const string &err_msg = "") {
-        static bool s_snap_success_once = false;
         StrCaseMap headerOut;
         GET_CONFIG(string, defaultSnap, API::kDefaultSnap);
         if (!File::fileSize(snap_path)) {
@@ -1762,6 +1840,27 @@ void installWebApi() {
 
         bool have_old_snap = false, res_old_snap = false;
         int expire_sec = allArgs["expire_sec"];
+
+#if defined(ENABLE_FFMPEG)
+        GET_CONFIG(bool, snap_in_process, API::kSnapInProcess);
+        auto src = snap_in_process ? SnapEngine::findLocalSource(allArgs["url"]) : nullptr;
+        if (src && SnapEngine::Instance().makeSnap(src, allArgs["timeout_sec"], expire_sec, [invoker, allArgs](const Buffer::Ptr &jpeg, const string &err_msg) {
+                if (!jpeg) {
+                    //截图失败，返回默认截图或错误信息
+                    string snap_path;
+                    responseSnap(snap_path, allArgs.parser.getHeader(), invoker, err_msg);
+                    return;
+                }
+                s_snap_success_once = true;
+                StrCaseMap headerOut;
+                headerOut["Content-Type"] = HttpFileManager::getContentType(".jpeg");
+                invoker.responseFile(allArgs.parser.getHeader(), headerOut, jpeg->toString(), false, false);
+            })) {
+            //本机流，进程内截图
+            return;
+        }
+#endif
+
         auto scan_path = File::absolutePath(MD5(allArgs["url"]).hexdigest(), snap_root) + "/";
         string new_snap = StrPrinter << scan_path << time(NULL) << ".jpeg";
 
@@ -1878,6 +1977,26 @@ void installWebApi() {
         });
     });
 
+    // 切换rtc播放器播放的simulcast层
+    // 测试url http://127.0.0.1/index/api/setWebRtcPlayerLayer?id=xxx&rid=h
+    api_regist("/index/api/setWebRtcPlayerLayer", [](API_ARGS_MAP_ASYNC) {
+        CHECK_SECRET();
+        CHECK_ARGS("id");
+        auto player = dynamic_pointer_cast<WebRtcPlayer>(WebRtcTransportManager::Instance().getItem(allArgs["id"]));
+        if (!player) {
+            throw ApiRetException("can not find the webrtc player", API::NotFound);
+        }
+        // rid为空时恢复根据带宽自动切换
+        auto rid = allArgs["rid"];
+        player->getPoller()->async([=]() mutable {
+            if (!player->setLayer(rid)) {
+                val["code"] = API::NotFound;
+                val["msg"] = "can not find the simulcast layer";
+            }
+            invoker(200, headerOut, val.toStyledString());
+        });
+    });
+
     static constexpr char delete_webrtc_url [] = "/index/api/delete_webrtc";
     static auto whip_whep_func = [](const char *type, API_ARGS_STRING_ASYNC) {
         auto offer = allArgs.args;
@@ -30,11 +30,13 @@
 #if defined(ENABLE_WEBRTC)
 #include "../webrtc/WebRtcTransport.h"
 #include "../webrtc/WebRtcSession.h"
+#include "../webrtc/WebRtcUdpSteering.h"
 #endif
 
 #if defined(ENABLE_SRT)
 #include "../srt/SrtSession.hpp"
 #include "../srt/SrtTransport.hpp"
+#include "../srt/SrtCaller.hpp"
 #endif
 
 #if defined(ENABLE_VERSION)
@@ -323,11 +325,15 @@ int start_main(int argc,char *argv[]) {
         auto rtcSrv_tcp = std::make_shared<TcpServer>();
         //webrtc udp服务器
         auto rtcSrv_udp = std::make_shared<UdpServer>();
-        rtcSrv_udp->setOnCreateSocket([](const EventPoller::Ptr &poller, const Buffer::Ptr &buf, struct sockaddr *, int) {
+        rtcSrv_udp->setOnCreateSocket([](const EventPoller::Ptr &poller, const Buffer::Ptr &buf, struct sockaddr *addr, int) {
             if (!buf) {
                 return Socket::createSocket(poller, false);
             }
-            auto new_poller = WebRtcSession::queryPoller(buf);
+            if (WebRtcUdpSteering::Instance().onProbe(buf)) {
+                //udp分发校准探测包，丢弃之
+                return Socket::Ptr();
+            }
+            auto new_poller = WebRtcSession::queryPoller(buf, addr);
             if (!new_poller) {
                 //该数据对应的webrtc对象未找到，丢弃之
                 return Socket::Ptr();
@@ -354,6 +360,8 @@ int start_main(int argc,char *argv[]) {
         });
 
         uint16_t srtPort = mINI::Instance()[SRT::kPort];
+        // 支持通过addStreamProxy/addStreamPusherProxy拉取或推送srt流
+        SRT::registerSrtCaller();
 #endif //defined(ENABLE_SRT)
 
         installWebApi();
@@ -387,7 +395,11 @@ int start_main(int argc,char *argv[]) {
 
 #if defined(ENABLE_WEBRTC)
             //webrtc udp服务器
-            if (rtcPort) { rtcSrv_udp->start<WebRtcSession>(rtcPort, listen_ip);}
+            if (rtcPort) {
+                rtcSrv_udp->start<WebRtcSession>(rtcPort, listen_ip);
+                //按ufrag中的poller标记分发udp数据
+                WebRtcUdpSteering::Instance().start(rtcPort, listen_ip);
+            }
 
             if (rtcTcpPort) { rtcSrv_tcp->start<WebRtcSession>(rtcTcpPort, listen_ip);}
              
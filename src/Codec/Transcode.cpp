@@ -694,5 +694,61 @@ FFmpegFrame::Ptr FFmpegSws::inputFrame(const FFmpegFrame::Ptr &frame, int &ret,
     return nullptr;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FFmpegJpegEncoder::FFmpegJpegEncoder(int qscale) {
+    setupFFmpeg();
+    _qscale = qscale;
+}
+
+Buffer::Ptr FFmpegJpegEncoder::inputFrame(const FFmpegFrame::Ptr &frame) {
+    TimeTicker2(30, TraceL);
+    auto av_frame = frame->get();
+    if (_context && (_context->width != av_frame->width || _context->height != av_frame->height)) {
+        //输入分辨率发生变化了
+        _context = nullptr;
+    }
+    if (!_context) {
+        auto codec = getCodec<false>({AV_CODEC_ID_MJPEG});
+        if (!codec) {
+            throw std::runtime_error("未找到jpeg编码器");
+        }
+        _context.reset(avcodec_alloc_context3(codec), [](AVCodecContext *ctx) {
+            avcodec_free_context(&ctx);
+        });
+        if (!_context) {
+            throw std::runtime_error("创建jpeg编码器失败");
+        }
+        _context->width = av_frame->width;
+        _context->height = av_frame->height;
+        _context->pix_fmt = AV_PIX_FMT_YUVJ420P;
+        _context->time_base = AVRational{1, 1000};
+        //固定质量编码
+        _context->flags |= AV_CODEC_FLAG_QSCALE;
+        _context->global_quality = FF_QP2LAMBDA * _qscale;
+        auto ret = avcodec_open2(_context.get(), codec, nullptr);
+        if (ret < 0) {
+            _context = nullptr;
+            throw std::runtime_error(StrPrinter << "打开jpeg编码器失败:" << ffmpeg_err(ret));
+        }
+    }
+
+    av_frame->quality = _context->global_quality;
+    auto ret = avcodec_send_frame(_context.get(), av_frame);
+    if (ret < 0) {
+        WarnL << "avcodec_send_frame failed:" << ffmpeg_err(ret);
+        return nullptr;
+    }
+    auto pkt = alloc_av_packet();
+    ret = avcodec_receive_packet(_context.get(), pkt.get());
+    if (ret < 0) {
+        WarnL << "avcodec_receive_packet failed:" << ffmpeg_err(ret);
+        return nullptr;
+    }
+    auto buffer = BufferRaw::create();
+    buffer->assign((char *) pkt->data, pkt->size);
+    return buffer;
+}
+
 } //namespace mediakit
 #endif//ENABLE_FFMPEG
@@ -144,6 +144,26 @@ private:
     AVPixelFormat _target_format = AV_PIX_FMT_NONE;
 };
 
+class FFmpegJpegEncoder {
+public:
+    using Ptr = std::shared_ptr<FFmpegJpegEncoder>;
+
+    /**
+     * @param qscale jpeg质量，取值2~31，值越小质量越高
+     */
+    FFmpegJpegEncoder(int qscale = 5);
+
+    /**
+     * 编码一帧图像为jpeg，输入图像须为AV_PIX_FMT_YUVJ420P格式
+     * @return 编码失败时返回nullptr
+     */
+    toolkit::Buffer::Ptr inputFrame(const FFmpegFrame::Ptr &frame);
+
+private:
+    int _qscale;
+    std::shared_ptr<AVCodecContext> _context;
+};
+
 }//namespace mediakit
 #endif// ENABLE_FFMPEG
 #endif //ZLMEDIAKIT_TRANSCODE_H
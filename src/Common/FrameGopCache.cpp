@@ -0,0 +1,91 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "FrameGopCache.h"
+
+using namespace std;
+
+namespace mediakit {
+
+FrameGopCache::FrameGopCache(size_t max_frames) {
+    _max_frames = max_frames;
+}
+
+void FrameGopCache::inputFrame(const Frame::Ptr &frame, bool have_video) {
+    lock_guard<mutex> lck(_mtx);
+    if (!have_video) {
+        // 没有视频时，没有缓存gop的意义
+        _frames.clear();
+        _bytes = 0;
+        return;
+    }
+
+    if (frame->getTrackType() == TrackVideo) {
+        // 与MultiMediaSourceMuxer::_ring一致，遇到第一帧配置帧或关键帧则标记为gop开始处
+        auto video_key_pos = frame->keyFrame() || frame->configFrame();
+        auto gop_start = video_key_pos && !_video_key_pos;
+        if (!frame->dropAble()) {
+            _video_key_pos = video_key_pos;
+        }
+        if (gop_start) {
+            _frames.clear();
+            _bytes = 0;
+            _wait_gop = false;
+        }
+    }
+
+    if (_wait_gop) {
+        return;
+    }
+    if (_frames.size() >= _max_frames) {
+        // gop太大，放弃缓存直到下一个gop
+        _frames.clear();
+        _bytes = 0;
+        _wait_gop = true;
+        return;
+    }
+    _bytes += frame->size();
+    _frames.emplace_back(frame);
+}
+
+void FrameGopCache::clear() {
+    lock_guard<mutex> lck(_mtx);
+    _frames.clear();
+    _bytes = 0;
+    _wait_gop = true;
+}
+
+vector<Frame::Ptr> FrameGopCache::getFramesBefore(const Frame::Ptr &frame) const {
+    lock_guard<mutex> lck(_mtx);
+    // 复用器线程落后于归属线程的帧数有限，从后往前查找
+    for (auto i = _frames.size(); i > 0; --i) {
+        if (_frames[i - 1] == frame) {
+            return vector<Frame::Ptr>(_frames.begin(), _frames.begin() + (i - 1));
+        }
+    }
+    return vector<Frame::Ptr>();
+}
+
+vector<Frame::Ptr> FrameGopCache::getFrames() const {
+    lock_guard<mutex> lck(_mtx);
+    return _frames;
+}
+
+size_t FrameGopCache::getBytes() const {
+    lock_guard<mutex> lck(_mtx);
+    return _bytes;
+}
+
+size_t FrameGopCache::getFrameCount() const {
+    lock_guard<mutex> lck(_mtx);
+    return _frames.size();
+}
+
+} // namespace mediakit
@@ -0,0 +1,119 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_FRAMEGOPCACHE_H
+#define ZLMEDIAKIT_FRAMEGOPCACHE_H
+
+#include <mutex>
+#include <vector>
+#include "Extension/Frame.h"
+
+namespace mediakit {
+
+/**
+ * 帧级gop缓存，每个MultiMediaSourceMuxer只保存一份
+ * 开启按需转协议时，协议复用器在无人观看时不再复用且清空各自的gop缓存，
+ * 重新有人观看时从该缓存重新复用出当前gop，播放器依然可以秒开
+ * 写入在归属线程，读取可能在复用器线程(parallel_mux)，所以加锁
+ */
+class FrameGopCache {
+public:
+    using Ptr = std::shared_ptr<FrameGopCache>;
+
+    FrameGopCache(size_t max_frames = 1024);
+
+    /**
+     * 输入帧，遇到gop开始处时清空之前的缓存
+     * @param frame 可缓存的帧(Frame::getCacheAbleFrame)
+     * @param have_video 是否存在视频，不存在视频时不缓存
+     */
+    void inputFrame(const Frame::Ptr &frame, bool have_video);
+
+    /**
+     * 清空缓存
+     */
+    void clear();
+
+    /**
+     * 获取当前gop中位于frame之前的帧，frame不在当前gop中时返回空
+     */
+    std::vector<Frame::Ptr> getFramesBefore(const Frame::Ptr &frame) const;
+
+    /**
+     * 获取当前gop中的所有帧
+     */
+    std::vector<Frame::Ptr> getFrames() const;
+
+    /**
+     * 缓存占用的字节数
+     */
+    size_t getBytes() const;
+
+    /**
+     * 缓存的帧数
+     */
+    size_t getFrameCount() const;
+
+private:
+    bool _video_key_pos = false;
+    // 缓存溢出后需要等待下一个gop
+    bool _wait_gop = true;
+    size_t _max_frames;
+    size_t _bytes = 0;
+    mutable std::mutex _mtx;
+    std::vector<Frame::Ptr> _frames;
+};
+
+/**
+ * 协议复用器因无人观看跳过帧后，重新输入帧前先从FrameGopCache补齐当前gop
+ * 该对象只能在协议复用器线程访问
+ */
+class FrameGopReplayer {
+public:
+    void setGopCache(const FrameGopCache::Ptr &cache) { _gop_cache = cache; }
+
+    /**
+     * 帧因无人观看未输入协议复用器
+     */
+    void onSkip() { _skipped = true; }
+
+    /**
+     * 帧输入协议复用器前调用
+     * @param frame 即将输入的帧
+     * @param input 输入帧至协议复用器的函数，原型为void(const Frame::Ptr &frame)
+     */
+    template <typename FUNC>
+    void onInput(const Frame::Ptr &frame, FUNC &&input) {
+        if (_skipped) {
+            _skipped = false;
+            auto cache = _gop_cache.lock();
+            auto frames = cache ? cache->getFramesBefore(frame) : std::vector<Frame::Ptr>();
+            // 该gop部分帧已经输入过复用器时不补齐，防止时间戳回退
+            if (!frames.empty() && (!_have_dts || frames.front()->dts() > _max_dts)) {
+                for (auto &item : frames) {
+                    input(item);
+                }
+            }
+        }
+        if (!_have_dts || frame->dts() > _max_dts) {
+            _have_dts = true;
+            _max_dts = frame->dts();
+        }
+    }
+
+private:
+    bool _skipped = false;
+    bool _have_dts = false;
+    uint64_t _max_dts = 0;
+    std::weak_ptr<FrameGopCache> _gop_cache;
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_FRAMEGOPCACHE_H
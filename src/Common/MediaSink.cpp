@@ -323,6 +323,10 @@ bool MediaSink::haveVideo() const {
     return _have_video;
 }
 
+bool MediaSink::haveMuteAudio() const {
+    return (bool)_mute_audio_maker;
+}
+
 ///////////////////////////DemuxerSink//////////////////////////////
 
 void MediaSinkDelegate::setTrackListener(TrackListener *listener) {
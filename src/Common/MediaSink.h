@@ -128,6 +128,11 @@ public:
      */
     bool haveVideo() const;
 
+    /**
+     * 是否添加了静音音频track
+     */
+    bool haveMuteAudio() const;
+
 protected:
     /**
      * 某track已经准备好，其ready()状态返回true，
@@ -28,12 +28,59 @@ namespace toolkit {
 
 namespace mediakit {
 
-static recursive_mutex s_media_source_mtx;
-using StreamMap = unordered_map<string/*strema_id*/, weak_ptr<MediaSource> >;
-using AppStreamMap = unordered_map<string/*app*/, StreamMap>;
-using VhostAppStreamMap = unordered_map<string/*vhost*/, AppStreamMap>;
-using SchemaVhostAppStreamMap = unordered_map<string/*schema*/, VhostAppStreamMap>;
-static SchemaVhostAppStreamMap s_media_source_map;
+/**
+ * MediaSource注册表分片
+ * 按vhost/app/stream哈希分片，同一路流的各协议位于同一分片
+ * 写时复制：注册/注销在分片锁内复制并替换整个map，查找与遍历只需原子获取当前快照，不阻塞写入
+ */
+class MediaSourceShard {
+public:
+    // key: schema + '\0' + vhost + '\0' + app + '\0' + stream
+    using Map = unordered_map<string, weak_ptr<MediaSource>>;
+    using MapPtr = shared_ptr<const Map>;
+
+    MapPtr snapshot() const { return atomic_load(&_map); }
+
+    /**
+     * 在分片锁内修改map
+     * @param cb 修改回调，返回false代表未修改
+     */
+    bool modify(const function<bool(Map &map)> &cb) {
+        lock_guard<mutex> lck(_mtx);
+        auto map = std::make_shared<Map>(*_map);
+        if (!cb(*map)) {
+            return false;
+        }
+        atomic_store(&_map, MapPtr(std::move(map)));
+        return true;
+    }
+
+private:
+    mutex _mtx;
+    MapPtr _map = std::make_shared<Map>();
+};
+
+// 分片个数，2的幂
+static constexpr size_t kMediaSourceShards = 256;
+static MediaSourceShard s_media_source_shards[kMediaSourceShards];
+
+static MediaSourceShard &getMediaSourceShard(const string &vhost, const string &app, const string &stream) {
+    std::hash<string> hasher;
+    auto hash = hasher(vhost);
+    hash = hash * 31 + hasher(app);
+    hash = hash * 31 + hasher(stream);
+    return s_media_source_shards[hash & (kMediaSourceShards - 1)];
+}
+
+static string getMediaSourceKey(const string &schema, const string &vhost, const string &app, const string &stream) {
+    string key;
+    key.reserve(schema.size() + vhost.size() + app.size() + stream.size() + 3);
+    key.append(schema).push_back('\0');
+    key.append(vhost).push_back('\0');
+    key.append(app).push_back('\0');
+    key.append(stream);
+    return key;
+}
 
 string getOriginTypeString(MediaOriginType type){
 #define SWITCH_CASE(type) case MediaOriginType::type : return #type
@@ -291,39 +338,29 @@ bool MediaSource::stopSendRtp(const string &ssrc) {
     return listener->stopSendRtp(*this, ssrc);
 }
 
-template<typename MAP, typename LIST, typename First, typename ...KeyTypes>
-static void for_each_media_l(const MAP &map, LIST &list, const First &first, const KeyTypes &...keys) {
-    if (first.empty()) {
-        for (auto &pr : map) {
-            for_each_media_l(pr.second, list, keys...);
+static void for_each_media_l(const MediaSourceShard::Map &map, deque<MediaSource::Ptr> &list, const string &schema,
+                             const string &vhost, const string &app, const string &stream) {
+    if (!schema.empty() && !vhost.empty() && !app.empty() && !stream.empty()) {
+        // 精确查找
+        auto it = map.find(getMediaSourceKey(schema, vhost, app, stream));
+        if (it != map.end()) {
+            if (auto src = it->second.lock()) {
+                list.emplace_back(std::move(src));
+            }
         }
         return;
     }
-    auto it = map.find(first);
-    if (it != map.end()) {
-        for_each_media_l(it->second, list, keys...);
-    }
-}
-
-template<typename LIST, typename Ptr>
-static void emplace_back(LIST &list, const Ptr &ptr) {
-    auto src = ptr.lock();
-    if (src) {
-        list.emplace_back(std::move(src));
-    }
-}
-
-template<typename MAP, typename LIST, typename First>
-static void for_each_media_l(const MAP &map, LIST &list, const First &first) {
-    if (first.empty()) {
-        for (auto &pr : map) {
-            emplace_back(list, pr.second);
+    // 按条件过滤，空字符串代表不过滤
+    for (auto &pr : map) {
+        auto src = pr.second.lock();
+        if (!src) {
+            continue;
+        }
+        auto &tuple = src->getMediaTuple();
+        if ((schema.empty() || schema == src->getSchema()) && (vhost.empty() || vhost == tuple.vhost)
+            && (app.empty() || app == tuple.app) && (stream.empty() || stream == tuple.stream)) {
+            list.emplace_back(std::move(src));
         }
-        return;
-    }
-    auto it = map.find(first);
-    if (it != map.end()) {
-        emplace_back(list, it->second);
     }
 }
 
@@ -333,9 +370,14 @@ void MediaSource::for_each_media(const function<void(const Ptr &src)> &cb,
                                  const string &app,
                                  const string &stream) {
     deque<Ptr> src_list;
-    {
-        lock_guard<recursive_mutex> lock(s_media_source_mtx);
-        for_each_media_l(s_media_source_map, src_list, schema, vhost, app, stream);
+    if (!vhost.empty() && !app.empty() && !stream.empty()) {
+        // 只需查找一个分片
+        for_each_media_l(*getMediaSourceShard(vhost, app, stream).snapshot(), src_list, schema, vhost, app, stream);
+    } else {
+        // 遍历所有分片的快照
+        for (auto &shard : s_media_source_shards) {
+            for_each_media_l(*shard.snapshot(), src_list, schema, vhost, app, stream);
+        }
     }
     for (auto &src : src_list) {
         cb(src);
@@ -477,54 +519,54 @@ void MediaSource::emitEvent(bool regist){
 }
 
 void MediaSource::regist() {
-    {
-        //减小互斥锁临界区
-        lock_guard<recursive_mutex> lock(s_media_source_mtx);
-        auto &ref = s_media_source_map[_schema][_tuple.vhost][_tuple.app][_tuple.stream];
-        auto src = ref.lock();
-        if (src) {
-            if (src.get() == this) {
-                return;
+    auto key = getMediaSourceKey(_schema, _tuple.vhost, _tuple.app, _tuple.stream);
+    // 在分片锁外析构，防止MediaSource析构时重入分片锁
+    Ptr old;
+    auto self = shared_from_this();
+    auto changed = getMediaSourceShard(_tuple.vhost, _tuple.app, _tuple.stream).modify([&](MediaSourceShard::Map &map) {
+        auto &ref = map[key];
+        old = ref.lock();
+        if (old) {
+            if (old.get() == this) {
+                return false;
             }
             //增加判断, 防止当前流已注册时再次注册
             throw std::invalid_argument("media source already existed:" + getUrl());
         }
-        ref = shared_from_this();
-    }
-    emitEvent(true);
-}
-
-template<typename MAP, typename First, typename ...KeyTypes>
-static bool erase_media_source(bool &hit, const MediaSource *thiz, MAP &map, const First &first, const KeyTypes &...keys) {
-    auto it = map.find(first);
-    if (it != map.end() && erase_media_source(hit, thiz, it->second, keys...)) {
-        map.erase(it);
-    }
-    return map.empty();
-}
-
-template<typename MAP, typename First>
-static bool erase_media_source(bool &hit, const MediaSource *thiz, MAP &map, const First &first) {
-    auto it = map.find(first);
-    if (it != map.end()) {
-        auto src = it->second.lock();
-        if (!src || src.get() == thiz) {
-            //对象已经销毁或者对象就是自己，那么移除之
-            map.erase(it);
-            hit = true;
-        }
+        ref = self;
+        return true;
+    });
+    if (changed) {
+        emitEvent(true);
     }
-    return map.empty();
 }
 
 //反注册该源
 bool MediaSource::unregist() {
-    bool ret = false;
+    auto key = getMediaSourceKey(_schema, _tuple.vhost, _tuple.app, _tuple.stream);
+    auto &shard = getMediaSourceShard(_tuple.vhost, _tuple.app, _tuple.stream);
     {
-        //减小互斥锁临界区
-        lock_guard<recursive_mutex> lock(s_media_source_mtx);
-        erase_media_source(ret, this, s_media_source_map, _schema, _tuple.vhost, _tuple.app, _tuple.stream);
+        // 先检查快照，未注册时无需加锁复制
+        auto map = shard.snapshot();
+        if (map->find(key) == map->end()) {
+            return false;
+        }
     }
+    // 在分片锁外析构，防止MediaSource析构时重入分片锁
+    Ptr src;
+    auto ret = shard.modify([&](MediaSourceShard::Map &map) {
+        auto it = map.find(key);
+        if (it == map.end()) {
+            return false;
+        }
+        src = it->second.lock();
+        if (src && src.get() != this) {
+            return false;
+        }
+        //对象已经销毁或者对象就是自己，那么移除之
+        map.erase(it);
+        return true;
+    });
 
     if (ret) {
         emitEvent(false);
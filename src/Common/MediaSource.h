@@ -199,6 +199,9 @@ public:
     // 该配置开启后可以解决一些流发送不平滑导致zlmediakit转发也不平滑的问题
     uint32_t paced_sender_ms;
 
+    // 是否让各协议复用器在独立线程并行执行，开启后单个高码率流可以利用多个cpu核心
+    bool parallel_mux;
+
     //是否开启转换为hls(mpegts)
     bool enable_hls;
     //是否开启转换为hls(fmp4)
@@ -255,6 +258,7 @@ public:
         GET_OPT_VALUE(auto_close);
         GET_OPT_VALUE(continue_push_ms);
         GET_OPT_VALUE(paced_sender_ms);
+        GET_OPT_VALUE(parallel_mux);
 
         GET_OPT_VALUE(enable_hls);
         GET_OPT_VALUE(enable_hls_fmp4);
@@ -367,6 +371,8 @@ public:
 
     // 获取数据速率，单位bytes/s
     int getBytesSpeed(TrackType type = TrackInvalid);
+    // 获取环形缓冲中gop缓存占用的字节数(估算值)
+    virtual size_t getCacheBytes() const { return 0; }
     // 获取流创建GMT unix时间戳，单位秒
     uint64_t getCreateStamp() const { return _create_stamp; }
     // 获取流上线时间，单位秒
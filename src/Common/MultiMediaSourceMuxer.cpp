@@ -9,6 +9,7 @@
 */
 
 #include <math.h>
+#include <atomic>
 #include "Common/config.h"
 #include "MultiMediaSourceMuxer.h"
 
@@ -117,6 +118,161 @@ private:
     std::list<std::pair<uint64_t, Frame::Ptr>> _cache;
 };
 
+// 单生产者单消费者无锁队列，生产者为流归属线程，消费者为协议复用器线程
+template <typename T>
+class SPSCQueue {
+public:
+    SPSCQueue() { _head = _tail = new Node; }
+
+    ~SPSCQueue() {
+        T value;
+        while (pop(value)) {}
+        delete _head;
+    }
+
+    void push(T value) {
+        auto node = new Node;
+        node->value = std::move(value);
+        _tail->next.store(node, std::memory_order_release);
+        _tail = node;
+    }
+
+    bool pop(T &value) {
+        auto next = _head->next.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+        value = std::move(next->value);
+        delete _head;
+        _head = next;
+        return true;
+    }
+
+private:
+    struct Node {
+        T value;
+        std::atomic<Node *> next { nullptr };
+    };
+    // 仅消费者访问
+    Node *_head;
+    // 仅生产者访问
+    Node *_tail;
+};
+
+// 把某个协议复用器放在独立的线程执行，每个复用器内部的帧顺序保持不变
+class MuxerWorker : public std::enable_shared_from_this<MuxerWorker> {
+public:
+    using Ptr = std::shared_ptr<MuxerWorker>;
+
+    MuxerWorker(MediaSinkInterface::Ptr sink, EventPoller::Ptr poller) {
+        _sink = std::move(sink);
+        _poller = std::move(poller);
+    }
+
+    const MediaSinkInterface::Ptr &getSink() const { return _sink; }
+    const EventPoller::Ptr &getPoller() const { return _poller; }
+
+    // 跨线程传递，frame须为可缓存的帧；复用器异步处理，返回其处理上一帧的结果
+    bool inputFrame(const Frame::Ptr &frame) {
+        Item item;
+        item.stamp = getCurrentMillisecond();
+        item.frame = frame;
+        push(std::move(item));
+        return _last_ret;
+    }
+
+    // 在复用器线程异步执行任务，任务排在已缓存的帧之后，不阻塞调用线程
+    void async(std::function<void()> task) {
+        Item item;
+        item.task = std::move(task);
+        push(std::move(item));
+    }
+
+    // 不再输入该复用器，消费完队列中的帧后在复用器线程释放之(录制文件在此时关闭)
+    void release() {
+        // 任务持有自身强引用，移出调度表后依然能消费完队列
+        auto self = shared_from_this();
+        async([self]() { self->_sink = nullptr; });
+    }
+
+    size_t getQueueDepth() const { return std::max<int64_t>(_depth.load(), 0); }
+    size_t getMaxQueueDepth() const { return _max_depth; }
+    uint64_t getTotalFrames() const { return _total_frames; }
+    uint64_t getMaxLatencyMS() const { return _max_latency_ms; }
+    float getAvgLatencyMS() const {
+        auto frames = _total_frames.load();
+        return frames ? (float)_total_latency_ms / frames : 0;
+    }
+
+private:
+    struct Item {
+        uint64_t stamp = 0;
+        Frame::Ptr frame;
+        std::function<void()> task;
+    };
+
+    void push(Item item) {
+        _queue.push(std::move(item));
+        auto depth = ++_depth;
+        if (depth > _max_depth) {
+            _max_depth = depth;
+        }
+        if (!_scheduled.exchange(true)) {
+            std::weak_ptr<MuxerWorker> weak_self = shared_from_this();
+            _poller->async([weak_self]() {
+                if (auto strong_self = weak_self.lock()) {
+                    strong_self->onDrain();
+                }
+            }, false);
+        }
+    }
+
+    void onDrain() {
+        while (true) {
+            flush();
+            _scheduled = false;
+            // 生产者可能在清除调度标记前写入了数据，此时需要继续消费
+            if (_depth <= 0 || _scheduled.exchange(true)) {
+                break;
+            }
+        }
+    }
+
+    void flush() {
+        Item item;
+        while (_queue.pop(item)) {
+            --_depth;
+            if (item.task) {
+                item.task();
+                item.task = nullptr;
+                continue;
+            }
+            if (!_sink) {
+                continue;
+            }
+            auto latency = getCurrentMillisecond() - item.stamp;
+            _last_ret = _sink->inputFrame(item.frame);
+            ++_total_frames;
+            _total_latency_ms += latency;
+            if (latency > _max_latency_ms) {
+                _max_latency_ms = latency;
+            }
+        }
+    }
+
+private:
+    std::atomic<bool> _scheduled { false };
+    std::atomic<bool> _last_ret { true };
+    std::atomic<int64_t> _depth { 0 };
+    std::atomic<int64_t> _max_depth { 0 };
+    std::atomic<uint64_t> _total_frames { 0 };
+    std::atomic<uint64_t> _total_latency_ms { 0 };
+    std::atomic<uint64_t> _max_latency_ms { 0 };
+    MediaSinkInterface::Ptr _sink;
+    EventPoller::Ptr _poller;
+    SPSCQueue<Item> _queue;
+};
+
 static std::shared_ptr<MediaSinkInterface> makeRecorder(MediaSource &sender, const vector<Track::Ptr> &tracks, Recorder::type type, const ProtocolOption &option){
     auto recorder = Recorder::createRecorder(type, sender.getMediaTuple(), option);
     for (auto &track : tracks) {
@@ -211,6 +367,7 @@ MultiMediaSourceMuxer::MultiMediaSourceMuxer(const MediaTuple& tuple, float dur_
     if (option.enable_fmp4) {
         _fmp4 = dynamic_pointer_cast<FMP4MediaSourceMuxer>(Recorder::createRecorder(Recorder::type_fmp4, _tuple, option));
     }
+    setGopCacheForMuxer();
 
     //音频相关设置
     enableAudio(option.enable_audio);
@@ -254,7 +411,8 @@ int MultiMediaSourceMuxer::totalReaderCount() const {
            (_mp4 ? _option.mp4_as_player : 0) +
            (_hls ? _hls->readerCount() : 0) +
            (_hls_fmp4 ? _hls_fmp4->readerCount() : 0) +
-           (_ring ? _ring->readerCount() : 0);
+           (_ring ? _ring->readerCount() : 0) +
+           (_ps_rtp_ring ? _ps_rtp_ring->readerCount() : 0);
 }
 
 void MultiMediaSourceMuxer::setTimeStamp(uint32_t stamp) {
@@ -301,6 +459,7 @@ bool MultiMediaSourceMuxer::setupRecord(MediaSource &sender, Recorder::type type
                 _hls = hls;
             } else if (!start && _hls) {
                 //停止录制
+                releaseMuxerWorker("hls");
                 _hls = nullptr;
             }
             return true;
@@ -313,6 +472,7 @@ bool MultiMediaSourceMuxer::setupRecord(MediaSource &sender, Recorder::type type
                 _mp4 = makeRecorder(sender, getTracks(), type, _option);
             } else if (!start && _mp4) {
                 //停止录制
+                releaseMuxerWorker("mp4");
                 _mp4 = nullptr;
             }
             return true;
@@ -329,6 +489,7 @@ bool MultiMediaSourceMuxer::setupRecord(MediaSource &sender, Recorder::type type
                 _hls_fmp4 = hls;
             } else if (!start && _hls_fmp4) {
                 //停止录制
+                releaseMuxerWorker("hls_fmp4");
                 _hls_fmp4 = nullptr;
             }
             return true;
@@ -340,7 +501,9 @@ bool MultiMediaSourceMuxer::setupRecord(MediaSource &sender, Recorder::type type
                     fmp4->setListener(shared_from_this());
                 }
                 _fmp4 = fmp4;
+                setGopCacheForMuxer();
             } else if (!start && _fmp4) {
+                releaseMuxerWorker("fmp4");
                 _fmp4 = nullptr;
             }
             return true;
@@ -352,7 +515,9 @@ bool MultiMediaSourceMuxer::setupRecord(MediaSource &sender, Recorder::type type
                     ts->setListener(shared_from_this());
                 }
                 _ts = ts;
+                setGopCacheForMuxer();
             } else if (!start && _ts) {
+                releaseMuxerWorker("ts");
                 _ts = nullptr;
             }
             return true;
@@ -375,9 +540,18 @@ bool MultiMediaSourceMuxer::isRecording(MediaSource &sender, Recorder::type type
 
 void MultiMediaSourceMuxer::startSendRtp(MediaSource &sender, const MediaSourceEvent::SendRtpArgs &args, const std::function<void(uint16_t, const toolkit::SockException &)> cb) {
 #if defined(ENABLE_RTPPROXY)
-    createGopCacheIfNeed();
+    RingType::Ptr ring;
+    PSRtpRingType::Ptr ps_ring;
+    if (isPSPassthroughAble(args)) {
+        // 源为ps over rtp，直接透传原始rtp
+        createPSRtpRingIfNeed();
+        ps_ring = _ps_rtp_ring;
+        InfoL << "stream:" << shortUrl() << " send ps rtp by passthrough, ssrc:" << args.ssrc;
+    } else {
+        createGopCacheIfNeed();
+        ring = _ring;
+    }
 
-    auto ring = _ring;
     auto ssrc = args.ssrc;
     auto ssrc_multi_send = args.ssrc_multi_send;
     auto tracks = getTracks(false);
@@ -397,22 +571,32 @@ void MultiMediaSourceMuxer::startSendRtp(MediaSource &sender, const MediaSourceE
         }
     });
 
-    rtp_sender->startSend(args, [ssrc,ssrc_multi_send, weak_self, rtp_sender, cb, tracks, ring, poller](uint16_t local_port, const SockException &ex) mutable {
+    rtp_sender->startSend(args, [ssrc,ssrc_multi_send, weak_self, rtp_sender, cb, tracks, ring, ps_ring, poller](uint16_t local_port, const SockException &ex) mutable {
         cb(local_port, ex);
         auto strong_self = weak_self.lock();
         if (!strong_self || ex) {
             return;
         }
 
-        for (auto &track : tracks) {
-            rtp_sender->addTrack(track);
-        }
-        rtp_sender->addTrackCompleted();
+        std::shared_ptr<void> reader;
+        if (ps_ring) {
+            auto ps_reader = ps_ring->attach(poller);
+            ps_reader->setReadCB([rtp_sender](const RtpPacket::Ptr &rtp) {
+                rtp_sender->inputPSRtp(rtp);
+            });
+            reader = std::move(ps_reader);
+        } else {
+            for (auto &track : tracks) {
+                rtp_sender->addTrack(track);
+            }
+            rtp_sender->addTrackCompleted();
 
-        auto reader = ring->attach(poller);
-        reader->setReadCB([rtp_sender](const Frame::Ptr &frame) {
-            rtp_sender->inputFrame(frame);
-        });
+            auto frame_reader = ring->attach(poller);
+            frame_reader->setReadCB([rtp_sender](const Frame::Ptr &frame) {
+                rtp_sender->inputFrame(frame);
+            });
+            reader = std::move(frame_reader);
+        }
 
         // 可能归属线程发生变更
         strong_self->getOwnerPoller(MediaSource::NullMediaSource())->async([=]() {
@@ -578,30 +762,170 @@ void MultiMediaSourceMuxer::createGopCacheIfNeed() {
     });
 }
 
-void MultiMediaSourceMuxer::resetTracks() {
-    MediaSink::resetTracks();
+MultiMediaSourceMuxer::RingType::Ptr MultiMediaSourceMuxer::getFrameRing() {
+    createGopCacheIfNeed();
+    _ring_ticker.resetTime();
+    return _ring;
+}
 
-    if (_rtmp) {
-        _rtmp->resetTracks();
+void MultiMediaSourceMuxer::releaseFrameRing(uint64_t delay_ms) {
+    if (delay_ms) {
+        weak_ptr<MultiMediaSourceMuxer> weak_self = shared_from_this();
+        getOwnerPoller(MediaSource::NullMediaSource())->doDelayTask(delay_ms, [weak_self, delay_ms]() {
+            auto strong_self = weak_self.lock();
+            if (strong_self && strong_self->_ring_ticker.elapsedTime() >= delay_ms) {
+                // 延时期间未再次使用
+                strong_self->releaseFrameRing();
+            }
+            return 0;
+        });
+        return;
     }
-    if (_rtsp) {
-        _rtsp->resetTracks();
+    // 其他地方持有环形缓存时(例如startSendRtp正在连接对端，尚未attach)不能释放
+    if (!_ring || _ring->readerCount() || _ring.use_count() > 1) {
+        return;
     }
-    if (_ts) {
-        _ts->resetTracks();
+#if defined(ENABLE_RTPPROXY)
+    GET_CONFIG(bool, gop_cache, RtpProxy::kGopCache);
+    if (gop_cache) {
+        // 开启了级联秒开，需要一直缓存gop
+        return;
     }
-    if (_fmp4) {
-        _fmp4->resetTracks();
+#endif
+    _ring = nullptr;
+    _video_key_pos = false;
+}
+
+void MultiMediaSourceMuxer::createPSRtpRingIfNeed() {
+    if (_ps_rtp_ring) {
+        return;
     }
-    if (_hls_fmp4) {
-        _hls_fmp4->resetTracks();
+    weak_ptr<MultiMediaSourceMuxer> weak_self = shared_from_this();
+    auto src = std::make_shared<MediaSourceForMuxer>(weak_self.lock());
+    // 一个gop的rtp包个数远多于帧数
+    _ps_rtp_ring = std::make_shared<PSRtpRingType>(4096, [weak_self, src](int size) {
+        if (auto strong_self = weak_self.lock()) {
+            // 切换到归属线程
+            strong_self->getOwnerPoller(MediaSource::NullMediaSource())->async([=]() {
+                strong_self->onReaderChanged(*src, strong_self->totalReaderCount());
+            });
+        }
+    });
+}
+
+bool MultiMediaSourceMuxer::isPSPassthroughAble(const MediaSourceEvent::SendRtpArgs &args) const {
+    GET_CONFIG(bool, ps_passthrough, RtpProxy::kPSPassthrough);
+    if (!ps_passthrough || args.data_type != MediaSourceEvent::SendRtpArgs::kRtpPS || args.only_audio) {
+        return false;
     }
-    if (_hls) {
-        _hls->resetTracks();
+    if (!_ps_rtp_max_size || _ps_rtp_ticker.elapsedTime() > 3 * 1000) {
+        // 源不是ps over rtp，或者已经不再收到ps rtp
+        return false;
     }
-    if (_mp4) {
-        _mp4->resetTracks();
+    if (!_ps_key_count || _ps_key_ticker.elapsedTime() > 30 * 1000 || _ps_key_count * 2 > _ps_frame_count) {
+        // 关键帧标记从未出现或者几乎每帧都出现，说明无法从ps包识别关键帧，gop缓存不可用，改为帧级复用
+        return false;
+    }
+    if (!_option.enable_audio || haveMuteAudio()) {
+        // 复用器的track与源ps包内容不一致
+        return false;
+    }
+    if (args.con_type == MediaSourceEvent::SendRtpArgs::kUdpActive || args.con_type == MediaSourceEvent::SendRtpArgs::kUdpPassive) {
+        GET_CONFIG(uint32_t, video_mtu, Rtp::kVideoMtuSize);
+        if (_ps_rtp_max_size > video_mtu) {
+            // 源rtp包大于udp打包大小(一般源为tcp推流)，透传可能导致ip分片
+            return false;
+        }
+    }
+    return true;
+}
+
+void MultiMediaSourceMuxer::inputPSRtp(const RtpPacket::Ptr &rtp, bool key_pos) {
+    _ps_rtp_ticker.resetTime();
+    _ps_rtp_max_size = MAX(_ps_rtp_max_size, rtp->getPayloadSize());
+    if (rtp->getStamp() != _ps_last_stamp) {
+        _ps_last_stamp = rtp->getStamp();
+        if (++_ps_frame_count > 1000) {
+            // 只统计最近的帧
+            _ps_frame_count /= 2;
+            _ps_key_count /= 2;
+        }
+    }
+    if (key_pos) {
+        ++_ps_key_count;
+        _ps_key_ticker.resetTime();
+    }
+    if (!_ps_rtp_ring) {
+        GET_CONFIG(bool, ps_passthrough, RtpProxy::kPSPassthrough);
+        GET_CONFIG(bool, gop_cache, RtpProxy::kGopCache);
+        if (!ps_passthrough || !gop_cache || !isAllTrackReady()) {
+            return;
+        }
+        // 提前开启gop缓存，优化级联秒开体验
+        createPSRtpRingIfNeed();
+    }
+    _ps_rtp_ring->write(rtp, key_pos);
+}
+
+void MultiMediaSourceMuxer::setGopCacheForMuxer() {
+    // 按需转协议的复用器无人观看时不保留gop缓存，所有协议共享一份帧级gop缓存用于秒开
+    auto rtmp = _rtmp && _option.rtmp_demand;
+    auto rtsp = _rtsp && _option.rtsp_demand;
+    auto ts = _ts && _option.ts_demand;
+    auto fmp4 = _fmp4 && _option.fmp4_demand;
+    if (!rtmp && !rtsp && !ts && !fmp4) {
+        return;
+    }
+    if (!_gop_cache) {
+        _gop_cache = std::make_shared<FrameGopCache>();
+    }
+    if (rtmp) {
+        _rtmp->setGopCache(_gop_cache);
+    }
+    if (rtsp) {
+        _rtsp->setGopCache(_gop_cache);
+    }
+    if (ts) {
+        _ts->setGopCache(_gop_cache);
     }
+    if (fmp4) {
+        _fmp4->setGopCache(_gop_cache);
+    }
+}
+
+size_t MultiMediaSourceMuxer::getGopCacheBytes() const {
+    return _gop_cache ? _gop_cache->getBytes() : 0;
+}
+
+std::vector<Frame::Ptr> MultiMediaSourceMuxer::getGopFrames() const {
+    return _gop_cache ? _gop_cache->getFrames() : std::vector<Frame::Ptr>();
+}
+
+void MultiMediaSourceMuxer::resetTracks() {
+    MediaSink::resetTracks();
+    if (_gop_cache) {
+        _gop_cache->clear();
+    }
+
+    auto reset = [this](const MediaSinkInterface::Ptr &muxer, const char *name) {
+        if (!muxer) {
+            return;
+        }
+        auto it = _muxer_workers.find(name);
+        if (it != _muxer_workers.end() && it->second->getSink() == muxer) {
+            // 排在已缓存的帧之后重置，不能同步等待其他线程，否则多个流之间可能互相死锁
+            it->second->async([muxer]() { muxer->resetTracks(); });
+            return;
+        }
+        muxer->resetTracks();
+    };
+    reset(_rtmp, "rtmp");
+    reset(_rtsp, "rtsp");
+    reset(_ts, "ts");
+    reset(_fmp4, "fmp4");
+    reset(_hls_fmp4, "hls_fmp4");
+    reset(_hls, "hls");
+    reset(_mp4, "mp4");
 }
 
 bool MultiMediaSourceMuxer::onTrackFrame(const Frame::Ptr &frame_in) {
@@ -613,32 +937,77 @@ bool MultiMediaSourceMuxer::onTrackFrame(const Frame::Ptr &frame_in) {
     return _paced_sender ? _paced_sender->inputFrame(frame) : onTrackFrame_l(frame);
 }
 
+void MultiMediaSourceMuxer::releaseMuxerWorker(const char *name) {
+    auto it = _muxer_workers.find(name);
+    if (it == _muxer_workers.end()) {
+        return;
+    }
+    it->second->release();
+    _muxer_workers.erase(it);
+}
+
+bool MultiMediaSourceMuxer::inputFrameToMuxer(const MediaSinkInterface::Ptr &muxer, const char *name, const Frame::Ptr &frame) {
+    if (!_option.parallel_mux) {
+        return muxer->inputFrame(frame);
+    }
+    auto &worker = _muxer_workers[name];
+    if (!worker || worker->getSink() != muxer) {
+        // 首次使用或该复用器已被重新创建(开启关闭录制)
+        if (worker) {
+            worker->release();
+        }
+        worker = std::make_shared<MuxerWorker>(muxer, EventPollerPool::Instance().getPoller(false));
+    }
+    return worker->inputFrame(frame);
+}
+
+void MultiMediaSourceMuxer::getMuxerStatistic(const std::function<void(const std::string &name, const MuxerStatistic &stat)> &cb) const {
+    for (auto &pr : _muxer_workers) {
+        auto &worker = pr.second;
+        MuxerStatistic stat;
+        stat.thread_name = worker->getPoller()->getThreadName();
+        stat.queue_depth = worker->getQueueDepth();
+        stat.max_queue_depth = worker->getMaxQueueDepth();
+        stat.frames = worker->getTotalFrames();
+        stat.avg_latency_ms = worker->getAvgLatencyMS();
+        stat.max_latency_ms = worker->getMaxLatencyMS();
+        cb(pr.first, stat);
+    }
+}
+
 bool MultiMediaSourceMuxer::onTrackFrame_l(const Frame::Ptr &frame_in) {
     auto frame = frame_in;
     bool ret = false;
+    if (_gop_cache || _option.parallel_mux) {
+        // 复用器通过帧指针定位gop中的位置，多线程复用时帧需要跨线程传递，所以各复用器须输入同一个可缓存帧
+        frame = Frame::getCacheAbleFrame(frame);
+    }
+    if (_gop_cache) {
+        _gop_cache->inputFrame(frame, haveVideo());
+    }
     if (_rtmp) {
-        ret = _rtmp->inputFrame(frame) ? true : ret;
+        ret = inputFrameToMuxer(_rtmp, "rtmp", frame) ? true : ret;
     }
     if (_rtsp) {
-        ret = _rtsp->inputFrame(frame) ? true : ret;
+        ret = inputFrameToMuxer(_rtsp, "rtsp", frame) ? true : ret;
     }
     if (_ts) {
-        ret = _ts->inputFrame(frame) ? true : ret;
+        ret = inputFrameToMuxer(_ts, "ts", frame) ? true : ret;
     }
 
     if (_hls) {
-        ret = _hls->inputFrame(frame) ? true : ret;
+        ret = inputFrameToMuxer(_hls, "hls", frame) ? true : ret;
     }
 
     if (_hls_fmp4) {
-        ret = _hls_fmp4->inputFrame(frame) ? true : ret;
+        ret = inputFrameToMuxer(_hls_fmp4, "hls_fmp4", frame) ? true : ret;
     }
 
     if (_mp4) {
-        ret = _mp4->inputFrame(frame) ? true : ret;
+        ret = inputFrameToMuxer(_mp4, "mp4", frame) ? true : ret;
     }
     if (_fmp4) {
-        ret = _fmp4->inputFrame(frame) ? true : ret;
+        ret = inputFrameToMuxer(_fmp4, "fmp4", frame) ? true : ret;
     }
     if (_ring) {
         // 此场景由于直接转发，可能存在切换线程引起的数据被缓存在管道，所以需要CacheAbleFrame
@@ -668,6 +1037,7 @@ bool MultiMediaSourceMuxer::isEnabled(){
                      (_ts ? _ts->isEnabled() : false) ||
                      (_fmp4 ? _fmp4->isEnabled() : false) ||
                      (_ring ? (bool)_ring->readerCount() : false)  ||
+                     (_ps_rtp_ring ? (bool)_ps_rtp_ring->readerCount() : false)  ||
                      (_hls ? _hls->isEnabled() : false) ||
                      (_hls_fmp4 ? _hls_fmp4->isEnabled() : false) ||
                      _mp4;
@@ -675,6 +1045,9 @@ bool MultiMediaSourceMuxer::isEnabled(){
         if (_is_enable) {
             //无人观看时，不刷新计时器,因为无人观看时每次都会检查一遍，所以刷新计数器无意义且浪费cpu
             _last_check.resetTime();
+        } else if (_gop_cache) {
+            //不再输入帧，gop缓存已经过期
+            _gop_cache->clear();
         }
     }
     return _is_enable;
@@ -14,6 +14,7 @@
 #include "Common/Stamp.h"
 #include "Common/MediaSource.h"
 #include "Common/MediaSink.h"
+#include "Common/FrameGopCache.h"
 #include "Record/Recorder.h"
 #include "Rtp/RtpSender.h"
 #include "Record/HlsRecorder.h"
@@ -29,6 +30,7 @@ class MultiMediaSourceMuxer : public MediaSourceEventInterceptor, public MediaSi
 public:
     using Ptr = std::shared_ptr<MultiMediaSourceMuxer>;
     using RingType = toolkit::RingBuffer<Frame::Ptr>;
+    using PSRtpRingType = toolkit::RingBuffer<RtpPacket::Ptr>;
 
     class Listener {
     public:
@@ -135,6 +137,59 @@ public:
 
     void forEachRtpSender(const std::function<void(const std::string &ssrc)> &cb) const;
 
+    struct MuxerStatistic {
+        // 复用器所在线程名
+        std::string thread_name;
+        // 当前队列中未处理的帧数
+        size_t queue_depth = 0;
+        // 队列历史最大深度
+        size_t max_queue_depth = 0;
+        // 已处理帧数
+        uint64_t frames = 0;
+        // 帧从入队到被复用器处理的平均延时与最大延时
+        float avg_latency_ms = 0;
+        uint64_t max_latency_ms = 0;
+    };
+
+    /**
+     * 获取各协议复用器独立线程的统计信息，仅在开启parallel_mux时有数据
+     * 请在归属线程调用
+     */
+    void getMuxerStatistic(const std::function<void(const std::string &name, const MuxerStatistic &stat)> &cb) const;
+
+    /**
+     * 获取帧级gop缓存占用的字节数，仅在开启按需转协议时存在该缓存
+     */
+    size_t getGopCacheBytes() const;
+
+    /**
+     * 获取帧级gop缓存中当前gop的所有帧，未开启按需转协议时返回空
+     * 此函数可跨线程调用
+     */
+    std::vector<Frame::Ptr> getGopFrames() const;
+
+    /**
+     * 获取帧级环形缓存，不存在时创建，创建后会缓存最近一个gop
+     * 截图等场景attach后可立即获取最近的关键帧
+     * 请在归属线程调用
+     */
+    RingType::Ptr getFrameRing();
+
+    /**
+     * 释放getFrameRing创建的帧级环形缓存，仍有读取者或其他用途时不释放
+     * 请在归属线程调用
+     * @param delay_ms 延时释放，期间再次调用getFrameRing则取消本次释放，用于周期性截图时保持gop缓存
+     */
+    void releaseFrameRing(uint64_t delay_ms = 0);
+
+    /**
+     * 输入排序后的ps负载原始rtp，用于startSendRtp(ps)时透传转发
+     * 请在归属线程调用
+     * @param rtp 原始rtp
+     * @param key_pos 是否为关键帧所在ps包的开始处
+     */
+    void inputPSRtp(const RtpPacket::Ptr &rtp, bool key_pos);
+
 protected:
     /////////////////////////////////MediaSink override/////////////////////////////////
 
@@ -159,6 +214,11 @@ protected:
 
 private:
     void createGopCacheIfNeed();
+    void createPSRtpRingIfNeed();
+    bool isPSPassthroughAble(const MediaSourceEvent::SendRtpArgs &args) const;
+    void setGopCacheForMuxer();
+    bool inputFrameToMuxer(const MediaSinkInterface::Ptr &muxer, const char *name, const Frame::Ptr &frame);
+    void releaseMuxerWorker(const char *name);
 
 private:
     bool _is_enable = false;
@@ -171,7 +231,8 @@ private:
     toolkit::Ticker _last_check;
     std::unordered_map<int, Stamp> _stamps;
     std::weak_ptr<Listener> _track_listener;
-    std::unordered_multimap<std::string, RingType::RingReader::Ptr> _rtp_sender;
+    // 持有环形缓存读取器(帧或ps rtp)，释放后停止发送
+    std::unordered_multimap<std::string, std::shared_ptr<void> > _rtp_sender;
     FMP4MediaSourceMuxer::Ptr _fmp4;
     RtmpMediaSourceMuxer::Ptr _rtmp;
     RtspMediaSourceMuxer::Ptr _rtsp;
@@ -181,6 +242,22 @@ private:
     HlsFMP4Recorder::Ptr _hls_fmp4;
     toolkit::EventPoller::Ptr _poller;
     RingType::Ptr _ring;
+    // 最近一次调用getFrameRing的时间，用于延时释放帧级环形缓存
+    toolkit::Ticker _ring_ticker;
+    // 源为ps over rtp时，startSendRtp(ps)透传使用的原始rtp环形缓存
+    PSRtpRingType::Ptr _ps_rtp_ring;
+    // 收到的ps rtp负载最大长度，为0说明源不是ps over rtp
+    size_t _ps_rtp_max_size = 0;
+    toolkit::Ticker _ps_rtp_ticker;
+    // 统计ps rtp的帧数与关键帧数，用于判断能否从ps包识别关键帧
+    uint32_t _ps_frame_count = 0;
+    uint32_t _ps_key_count = 0;
+    uint32_t _ps_last_stamp = 0;
+    toolkit::Ticker _ps_key_ticker;
+    // 按需转协议的复用器共享的帧级gop缓存
+    FrameGopCache::Ptr _gop_cache;
+    // 开启parallel_mux时，每个协议复用器对应的独立线程
+    std::unordered_map<std::string, std::shared_ptr<class MuxerWorker>> _muxer_workers;
 
     //对象个数统计
     toolkit::ObjectStatistic<MultiMediaSourceMuxer> _statistic;
@@ -11,6 +11,7 @@
 #ifndef ZLMEDIAKIT_PACKET_CACHE_H_
 #define ZLMEDIAKIT_PACKET_CACHE_H_
 
+#include <atomic>
 #include "Common/config.h"
 #include "Util/List.h"
 
@@ -68,6 +69,25 @@ public:
 
     virtual void onFlush(std::shared_ptr<packet_list>, bool key_pos) = 0;
 
+protected:
+    /**
+     * 统计写入环形缓冲的字节数，用于估算gop缓存大小
+     * @param list 本次写入的包列表
+     * @param key_pos 是否为gop开始处，环形缓冲在此处丢弃之前的gop
+     */
+    void updateCacheBytes(packet_list &list, bool key_pos) {
+        size_t bytes = 0;
+        list.for_each([&](const std::shared_ptr<packet> &pkt) { bytes += pkt->size(); });
+        if (key_pos) {
+            _cache_bytes = bytes;
+        } else {
+            _cache_bytes += bytes;
+        }
+    }
+
+    // 在归属线程写入，统计接口可能跨线程读取
+    std::atomic<size_t> _cache_bytes { 0 };
+
 private:
     bool flushImmediatelyWhenCloseMerge() {
         // 一般的协议关闭合并写时，立即刷新缓存，这样可以减少一帧的延时，但是rtp例外
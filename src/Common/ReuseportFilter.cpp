@@ -0,0 +1,74 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "ReuseportFilter.h"
+#include "Util/logger.h"
+#include "Util/uv_errno.h"
+#include "Network/sockutil.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <linux/filter.h>
+#endif
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+void ReuseportFilter::stmt(uint16_t code, uint32_t k) {
+    _insns.push_back({ code, 0, 0, k });
+}
+
+void ReuseportFilter::jump(uint16_t code, uint32_t k, int jt, int jf) {
+    // 跳转偏移相对下一条指令
+    int next = (int)_insns.size() + 1;
+    _insns.push_back({ code, (uint8_t)(jt < 0 ? 0 : jt - next), (uint8_t)(jf < 0 ? 0 : jf - next), k });
+}
+
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+
+bool ReuseportFilter::attach(int fd) const {
+    static_assert(sizeof(Instruction) == sizeof(sock_filter), "cbpf instruction size mismatch");
+    sock_fprog prog;
+    prog.len = (unsigned short)_insns.size();
+    prog.filter = (sock_filter *)_insns.data();
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) != 0) {
+        WarnL << "Attach reuseport cbpf failed: " << get_uv_errmsg(true);
+        return false;
+    }
+    return true;
+}
+
+bool ReuseportFilter::attach(uint16_t port, const string &local_ip) const {
+    // 挂载前后极短时间内可能有少量数据包被hash到该socket而丢弃，由对端重传
+    auto fd = SockUtil::bindUdpSock(port, local_ip.data(), true);
+    if (fd == -1) {
+        WarnL << "Bind reuseport udp port failed: " << port;
+        return false;
+    }
+    auto attached = attach(fd);
+    close(fd);
+    return attached;
+}
+
+#else
+
+bool ReuseportFilter::attach(int fd) const {
+    return false;
+}
+
+bool ReuseportFilter::attach(uint16_t port, const string &local_ip) const {
+    return false;
+}
+
+#endif // defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+
+} // namespace mediakit
@@ -0,0 +1,73 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_REUSEPORTFILTER_H
+#define ZLMEDIAKIT_REUSEPORTFILTER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace mediakit {
+
+/**
+ * SO_REUSEPORT组的cbpf分发程序(仅linux)
+ * 程序输入为udp负载，返回值为组内socket下标，越界时内核回退到四元组hash分发
+ * 指令码使用<linux/filter.h>中的BPF_*宏
+ */
+class ReuseportFilter {
+public:
+    /**
+     * 添加非条件跳转指令
+     */
+    void stmt(uint16_t code, uint32_t k);
+
+    /**
+     * 添加条件跳转指令
+     * @param jt 条件成立时跳转到的指令下标，-1表示顺序执行
+     * @param jf 条件不成立时跳转到的指令下标，-1表示顺序执行
+     */
+    void jump(uint16_t code, uint32_t k, int jt, int jf);
+
+    /**
+     * 当前指令个数，即下一条指令的下标
+     */
+    size_t size() const { return _insns.size(); }
+
+    /**
+     * 在fd所在的reuseport组上挂载该程序，程序属于整个组
+     * @param fd 已绑定端口的SO_REUSEPORT udp socket
+     * @return 是否成功
+     */
+    bool attach(int fd) const;
+
+    /**
+     * 临时绑定端口加入reuseport组并挂载该程序，关闭临时socket后程序依然生效
+     * 组内前n个socket为已经绑定的socket，之后创建的socket下标都大于等于n
+     * @param port 已被reuseport组绑定的udp端口
+     * @param local_ip 监听ip
+     * @return 是否成功
+     */
+    bool attach(uint16_t port, const std::string &local_ip) const;
+
+private:
+    // 与struct sock_filter内存布局一致
+    struct Instruction {
+        uint16_t code;
+        uint8_t jt;
+        uint8_t jf;
+        uint32_t k;
+    };
+    std::vector<Instruction> _insns;
+};
+
+} // namespace mediakit
+
+#endif // ZLMEDIAKIT_REUSEPORTFILTER_H
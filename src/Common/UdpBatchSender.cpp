@@ -0,0 +1,182 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include "UdpBatchSender.h"
+#include "Common/config.h"
+#include "Network/sockutil.h"
+#include "Network/uv_errno.h"
+
+#if defined(__linux__) || defined(__linux)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#define ENABLE_UDP_BATCH_SEND
+#endif
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+// sendmmsg单次最多发送的消息个数
+static constexpr size_t kMaxBatchMsg = 64;
+// 单个GSO消息最多合并的包个数(内核限制为64)
+static constexpr size_t kMaxGSOSegments = 64;
+// 单个GSO消息最大字节数
+static constexpr size_t kMaxGSOBytes = 65000;
+// 单次系统调用最多发送的包个数
+static constexpr size_t kMaxBatchPackets = 256;
+
+static atomic<uint64_t> s_total_syscalls { 0 };
+static atomic<uint64_t> s_total_packets { 0 };
+// 内核或网卡不支持GSO时，后续不再尝试
+static atomic<bool> s_gso_unsupported { false };
+
+uint64_t UdpBatchSender::getTotalSyscalls() {
+    return s_total_syscalls;
+}
+
+uint64_t UdpBatchSender::getTotalPackets() {
+    return s_total_packets;
+}
+
+UdpBatchSender::UdpBatchSender(Socket::Ptr sock) {
+    _sock = std::move(sock);
+    _packets.reserve(kMaxBatchMsg);
+}
+
+void UdpBatchSender::input(Buffer::Ptr buf) {
+    _packets.emplace_back(std::move(buf));
+}
+
+void UdpBatchSender::fallback(size_t offset) {
+    for (auto i = offset; i < _packets.size(); ++i) {
+        _sock->send(std::move(_packets[i]), nullptr, 0, false);
+    }
+    _sock->flushAll();
+    _packets.clear();
+}
+
+void UdpBatchSender::flush() {
+    if (_packets.empty()) {
+        return;
+    }
+    GET_CONFIG(int, mode, Rtp::kUdpBatchSend);
+#if defined(ENABLE_UDP_BATCH_SEND)
+    // socket发送缓存中还有数据未发送时，为了保证包的顺序，只能继续排队
+    if (mode == kModeOff || _sock->isSocketBusy()) {
+        fallback(0);
+        return;
+    }
+    auto peer_ip = _sock->get_peer_ip();
+    auto peer_port = _sock->get_peer_port();
+    if (peer_ip.empty() || !peer_port) {
+        // 尚未绑定目标地址
+        fallback(0);
+        return;
+    }
+    auto addr = SockUtil::make_sockaddr(peer_ip.data(), peer_port);
+    auto addr_len = SockUtil::get_sock_len((struct sockaddr *)&addr);
+    size_t offset = 0;
+    while (offset < _packets.size()) {
+        auto sent = sendBatch((struct sockaddr *)&addr, addr_len, offset, mode == kModeGSO && !s_gso_unsupported);
+        if (!sent) {
+            break;
+        }
+        offset += sent;
+    }
+    // 未发送成功的部分交给Socket处理(等待可写事件或触发错误回调)
+    fallback(offset);
+#else
+    fallback(0);
+#endif
+}
+
+size_t UdpBatchSender::sendBatch(const struct sockaddr *addr, int addr_len, size_t offset, bool gso) {
+#if defined(ENABLE_UDP_BATCH_SEND)
+    struct mmsghdr msgs[kMaxBatchMsg];
+    // 每个消息携带的包个数
+    size_t msg_packets[kMaxBatchMsg];
+    char cmsg_buf[kMaxBatchMsg][CMSG_SPACE(sizeof(uint16_t))];
+    struct iovec iovs[kMaxBatchPackets];
+
+    size_t msg_count = 0;
+    size_t iov_count = 0;
+    auto i = offset;
+    while (i < _packets.size() && msg_count < kMaxBatchMsg && iov_count < kMaxBatchPackets) {
+        auto &msg = msgs[msg_count];
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_hdr.msg_name = (void *)addr;
+        msg.msg_hdr.msg_namelen = addr_len;
+        msg.msg_hdr.msg_iov = &iovs[iov_count];
+
+        auto seg_size = _packets[i]->size();
+        size_t bytes = 0;
+        size_t count = 0;
+        do {
+            auto &pkt = _packets[i];
+            iovs[iov_count].iov_base = pkt->data();
+            iovs[iov_count].iov_len = pkt->size();
+            ++iov_count;
+            ++count;
+            bytes += pkt->size();
+            ++i;
+            if (!gso || pkt->size() < seg_size) {
+                // 未开启GSO或者最后一个切片较短，该消息结束
+                break;
+            }
+        } while (i < _packets.size() && count < kMaxGSOSegments && iov_count < kMaxBatchPackets
+                 && bytes + _packets[i]->size() <= kMaxGSOBytes && _packets[i]->size() <= seg_size);
+
+        msg.msg_hdr.msg_iovlen = count;
+        if (count > 1) {
+            // 多个等长包合并成一个消息，由内核按seg_size切片
+            msg.msg_hdr.msg_control = cmsg_buf[msg_count];
+            msg.msg_hdr.msg_controllen = sizeof(cmsg_buf[msg_count]);
+            auto cm = CMSG_FIRSTHDR(&msg.msg_hdr);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            *((uint16_t *)CMSG_DATA(cm)) = (uint16_t)seg_size;
+        }
+        msg_packets[msg_count++] = count;
+    }
+
+    auto ret = ::sendmmsg(_sock->rawFD(), msgs, msg_count, 0);
+    ++s_total_syscalls;
+    if (ret <= 0) {
+        auto err = get_uv_error(true);
+        if (gso && (err == UV_EIO || err == UV_EINVAL)) {
+            // 不支持GSO，关闭后重试
+            WarnL << "udp gso not supported, fallback to sendmmsg: " << uv_strerror(err);
+            s_gso_unsupported = true;
+            return sendBatch(addr, addr_len, offset, false);
+        }
+        return 0;
+    }
+
+    size_t sent = 0;
+    for (int j = 0; j < ret; ++j) {
+        sent += msg_packets[j];
+    }
+    s_total_packets += sent;
+    return sent;
+#else
+    return 0;
+#endif
+}
+
+} // namespace mediakit
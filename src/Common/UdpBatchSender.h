@@ -0,0 +1,68 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_UDPBATCHSENDER_H
+#define ZLMEDIAKIT_UDPBATCHSENDER_H
+
+#include <vector>
+#include "Network/Socket.h"
+
+namespace mediakit {
+
+/**
+ * udp批量发送器
+ * 把一次flush的多个udp包通过一次sendmmsg系统调用发送出去，
+ * 如果多个包长度相同且发往同一个目标，还可以通过UDP GSO合并成一个消息交由内核切片
+ * 发送失败(socket缓存满等)的部分将回退到Socket::send
+ */
+class UdpBatchSender {
+public:
+    using Ptr = std::shared_ptr<UdpBatchSender>;
+
+    enum {
+        // 关闭批量发送，采用Socket::send
+        kModeOff = 0,
+        // 采用sendmmsg批量发送
+        kModeMMsg = 1,
+        // 采用sendmmsg批量发送，等长包采用UDP GSO合并
+        kModeGSO = 2,
+    };
+
+    UdpBatchSender(toolkit::Socket::Ptr sock);
+
+    const toolkit::Socket::Ptr &getSock() const { return _sock; }
+
+    /**
+     * 缓存一个待发送的udp包
+     */
+    void input(toolkit::Buffer::Ptr buf);
+
+    /**
+     * 批量发送所有缓存的udp包
+     */
+    void flush();
+
+    /**
+     * 全局统计，用于计算每次系统调用发送的平均包数
+     */
+    static uint64_t getTotalSyscalls();
+    static uint64_t getTotalPackets();
+
+private:
+    void fallback(size_t offset);
+    size_t sendBatch(const struct sockaddr *addr, int addr_len, size_t offset, bool gso);
+
+private:
+    toolkit::Socket::Ptr _sock;
+    std::vector<toolkit::Buffer::Ptr> _packets;
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_UDPBATCHSENDER_H
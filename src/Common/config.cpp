@@ -114,6 +114,7 @@ const string kAddMuteAudio = string(kFieldName) + "add_mute_audio";
 const string kAutoClose = string(kFieldName) + "auto_close";
 const string kContinuePushMS = string(kFieldName) + "continue_push_ms";
 const string kPacedSenderMS = string(kFieldName) + "paced_sender_ms";
+const string kParallelMux = string(kFieldName) + "parallel_mux";
 
 const string kEnableHls = string(kFieldName) + "enable_hls";
 const string kEnableHlsFmp4 = string(kFieldName) + "enable_hls_fmp4";
@@ -141,6 +142,7 @@ static onceToken token([]() {
     mINI::Instance()[kAddMuteAudio] = 1;
     mINI::Instance()[kContinuePushMS] = 15000;
     mINI::Instance()[kPacedSenderMS] = 0;
+    mINI::Instance()[kParallelMux] = 0;
     mINI::Instance()[kAutoClose] = 0;
 
     mINI::Instance()[kEnableHls] = 1;
@@ -263,6 +265,7 @@ const string kAudioMtuSize = RTP_FIELD "audioMtuSize";
 const string kRtpMaxSize = RTP_FIELD "rtpMaxSize";
 const string kLowLatency = RTP_FIELD "lowLatency";
 const string kH264StapA = RTP_FIELD "h264_stap_a";
+const string kUdpBatchSend = RTP_FIELD "udp_batch_send";
 
 static onceToken token([]() {
     mINI::Instance()[kVideoMtuSize] = 1400;
@@ -270,6 +273,7 @@ static onceToken token([]() {
     mINI::Instance()[kRtpMaxSize] = 10;
     mINI::Instance()[kLowLatency] = 0;
     mINI::Instance()[kH264StapA] = 1;
+    mINI::Instance()[kUdpBatchSend] = 0;
 });
 } // namespace Rtp
 
@@ -322,6 +326,8 @@ const string kFileBufSize = HLS_FIELD "fileBufSize";
 const string kBroadcastRecordTs = HLS_FIELD "broadcastRecordTs";
 const string kDeleteDelaySec = HLS_FIELD "deleteDelaySec";
 const string kFastRegister = HLS_FIELD "fastRegister";
+const string kMemoryCache = HLS_FIELD "memoryCache";
+const string kPartDuration = HLS_FIELD "partDur";
 
 static onceToken token([]() {
     mINI::Instance()[kSegmentDuration] = 2;
@@ -333,6 +339,8 @@ static onceToken token([]() {
     mINI::Instance()[kBroadcastRecordTs] = false;
     mINI::Instance()[kDeleteDelaySec] = 10;
     mINI::Instance()[kFastRegister] = false;
+    mINI::Instance()[kMemoryCache] = false;
+    mINI::Instance()[kPartDuration] = 0;
 });
 } // namespace Hls
 
@@ -349,6 +357,8 @@ const string kOpusPT = RTP_PROXY_FIELD "opus_pt";
 const string kGopCache = RTP_PROXY_FIELD "gop_cache";
 const string kRtpG711DurMs = RTP_PROXY_FIELD "rtp_g711_dur_ms";
 const string kUdpRecvSocketBuffer = RTP_PROXY_FIELD "udp_recv_socket_buffer";
+const string kPSPassthrough = RTP_PROXY_FIELD "ps_passthrough";
+const string kUdpSteering = RTP_PROXY_FIELD "udp_steering";
 
 static onceToken token([]() {
     mINI::Instance()[kDumpDir] = "";
@@ -361,6 +371,8 @@ static onceToken token([]() {
     mINI::Instance()[kGopCache] = 1;
     mINI::Instance()[kRtpG711DurMs] = 100;
     mINI::Instance()[kUdpRecvSocketBuffer] = 4 * 1024 * 1024;
+    mINI::Instance()[kPSPassthrough] = 1;
+    mINI::Instance()[kUdpSteering] = 0;
 });
 } // namespace RtpProxy
 
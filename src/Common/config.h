@@ -226,6 +226,8 @@ extern const std::string kContinuePushMS;
 // 平滑发送定时器间隔，单位毫秒，置0则关闭；开启后影响cpu性能同时增加内存
 // 该配置开启后可以解决一些流发送不平滑导致zlmediakit转发也不平滑的问题
 extern const std::string kPacedSenderMS;
+// 是否让各协议复用器在独立线程并行执行，开启后单个高码率流可以利用多个cpu核心
+extern const std::string kParallelMux;
 
 //是否开启转换为hls(mpegts)
 extern const std::string kEnableHls;
@@ -342,6 +344,8 @@ extern const std::string kRtpMaxSize;
 extern const std::string kLowLatency;
 //H264 rtp打包模式是否采用stap-a模式(为了在老版本浏览器上兼容webrtc)还是采用Single NAL unit packet per H.264 模式
 extern const std::string kH264StapA;
+// udp方式发送rtp时是否批量发送，0:关闭，1:采用sendmmsg批量发送，2:采用sendmmsg并对等长包开启UDP GSO(仅linux有效)
+extern const std::string kUdpBatchSend;
 } // namespace Rtp
 
 ////////////组播配置///////////
@@ -390,6 +394,10 @@ extern const std::string kBroadcastRecordTs;
 extern const std::string kDeleteDelaySec;
 // 如果设置为1，则第一个切片长度强制设置为1个GOP
 extern const std::string kFastRegister;
+// hls直播切片是否只保存在内存中(不写磁盘)，点播、保留切片、切片完成广播时仍然写磁盘
+extern const std::string kMemoryCache;
+// LL-HLS分片时长，单位秒，0则关闭LL-HLS，开启LL-HLS需要同时开启memoryCache
+extern const std::string kPartDuration;
 } // namespace Hls
 
 ////////////Rtp代理相关配置///////////
@@ -416,6 +424,10 @@ extern const std::string kGopCache;
 extern const std::string kRtpG711DurMs;
 // udp recv socket buffer size
 extern const std::string kUdpRecvSocketBuffer;
+// 收到的是ps over rtp时，startSendRtp(ps)是否直接透传原始rtp(只改写ssrc、seq、时间戳)，不再解复用后重新复用
+extern const std::string kPSPassthrough;
+// 单端口udp rtp服务器是否根据ssrc把数据直接分发到固定poller的SO_REUSEPORT socket(仅linux)
+extern const std::string kUdpSteering;
 } // namespace RtpProxy
 
 /**
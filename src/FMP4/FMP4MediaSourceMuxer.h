@@ -11,8 +11,10 @@
 #ifndef ZLMEDIAKIT_FMP4MEDIASOURCEMUXER_H
 #define ZLMEDIAKIT_FMP4MEDIASOURCEMUXER_H
 
+#include <atomic>
 #include "FMP4MediaSource.h"
 #include "Record/MP4Muxer.h"
+#include "Common/FrameGopCache.h"
 
 namespace mediakit {
 
@@ -39,6 +41,13 @@ public:
         _media_src->setListener(shared_from_this());
     }
 
+    /**
+     * 设置帧级gop缓存，按需转协议无人观看后重新有人观看时，从该缓存补齐当前gop
+     */
+    void setGopCache(const FrameGopCache::Ptr &cache) {
+        _gop_replayer.setGopCache(cache);
+    }
+
     int readerCount() const{
         return _media_src->readerCount();
     }
@@ -52,13 +61,14 @@ public:
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
-        if (_clear_cache && _option.fmp4_demand) {
-            _clear_cache = false;
+        if (_option.fmp4_demand && _clear_cache.exchange(false)) {
             _media_src->clearCache();
         }
         if (_enabled || !_option.fmp4_demand) {
+            _gop_replayer.onInput(frame, [this](const Frame::Ptr &cached) { MP4MuxerMemory::inputFrame(cached); });
             return MP4MuxerMemory::inputFrame(frame);
         }
+        _gop_replayer.onSkip();
         return false;
     }
 
@@ -83,9 +93,11 @@ protected:
     }
 
 private:
-    bool _enabled = true;
-    bool _clear_cache = false;
+    // 开启多线程复用时，由归属线程修改，复用器线程读取
+    std::atomic<bool> _enabled { true };
+    std::atomic<bool> _clear_cache { false };
     ProtocolOption _option;
+    FrameGopReplayer _gop_replayer;
     FMP4MediaSource::Ptr _media_src;
 };
 
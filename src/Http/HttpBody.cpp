@@ -363,16 +363,49 @@ string HttpMultiFormBody::multiFormBodyPrefix(const HttpArgs &args, const string
     return std::move(body);
 }
 
+// 引用原buffer的部分数据，避免拷贝
+class BufferSlice : public Buffer {
+public:
+    BufferSlice(Buffer::Ptr buffer, size_t offset, size_t size) {
+        _buffer = std::move(buffer);
+        _offset = offset;
+        _size = size;
+    }
+
+    char *data() const override { return _buffer->data() + _offset; }
+    size_t size() const override { return _size; }
+
+private:
+    size_t _offset;
+    size_t _size;
+    Buffer::Ptr _buffer;
+};
+
 HttpBufferBody::HttpBufferBody(Buffer::Ptr buffer) {
     _buffer = std::move(buffer);
+    _max_size = _buffer ? _buffer->size() : 0;
+}
+
+void HttpBufferBody::setRange(size_t offset, size_t max_size) {
+    auto total = _buffer ? _buffer->size() : 0;
+    _offset = MIN(offset, total);
+    _max_size = MIN(max_size, total - _offset);
 }
 
 int64_t HttpBufferBody::remainSize() {
-    return _buffer ? _buffer->size() : 0;
+    return _buffer ? _max_size : 0;
 }
 
 Buffer::Ptr HttpBufferBody::readData(size_t size) {
-    return Buffer::Ptr(std::move(_buffer));
+    if (!_buffer) {
+        return nullptr;
+    }
+    if (_offset == 0 && _max_size == _buffer->size()) {
+        return Buffer::Ptr(std::move(_buffer));
+    }
+    auto ret = std::make_shared<BufferSlice>(std::move(_buffer), _offset, _max_size);
+    _buffer = nullptr;
+    return ret;
 }
 
 } // namespace mediakit
@@ -90,10 +90,19 @@ public:
     using Ptr = std::shared_ptr<HttpBufferBody>;
     HttpBufferBody(toolkit::Buffer::Ptr buffer);
 
+    /**
+     * 设置读取范围，用于分节下载
+     * @param offset 相对buffer起始位置的偏移量
+     * @param max_size 最大读取字节数
+     */
+    void setRange(size_t offset, size_t max_size);
+
     int64_t remainSize() override;
     toolkit::Buffer::Ptr readData(size_t size) override;
 
 private:
+    size_t _offset = 0;
+    size_t _max_size = 0;
     toolkit::Buffer::Ptr _buffer;
 };
 
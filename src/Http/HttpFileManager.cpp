@@ -328,6 +328,27 @@ public:
     uint16_t _peer_port;
 };
 
+/**
+ * 获取用户唯一id，LL-HLS的_HLS_msn等参数每次请求都会变化，需要忽略
+ */
+static string getUid(const Parser &parser) {
+    auto &params = parser.params();
+    if (params.find("_HLS_") == string::npos) {
+        return params;
+    }
+    string ret;
+    for (auto &arg : split(params, "&")) {
+        if (start_with(arg, "_HLS_")) {
+            continue;
+        }
+        if (!ret.empty()) {
+            ret.push_back('&');
+        }
+        ret.append(arg);
+    }
+    return ret;
+}
+
 /**
  * 判断http客户端是否有权限访问文件的逻辑步骤
  * 1、根据http请求头查找cookie，找到进入步骤3
@@ -339,7 +360,7 @@ public:
 static void canAccessPath(Session &sender, const Parser &parser, const MediaInfo &media_info, bool is_dir,
                           const function<void(const string &err_msg, const HttpServerCookie::Ptr &cookie)> &callback) {
     //获取用户唯一id
-    auto uid = parser.params();
+    auto uid = getUid(parser);
     auto path = parser.url();
 
     //先根据http头中的cookie字段获取cookie
@@ -367,7 +388,7 @@ static void canAccessPath(Session &sender, const Parser &parser, const MediaInfo
                 return;
             }
             //上次鉴权失败，但是如果url参数发生变更，那么也重新鉴权下
-            if (parser.params().empty() || parser.params() == cookie->getUid()) {
+            if (uid.empty() || uid == cookie->getUid()) {
                 //url参数未变，或者本来就没有url参数，那么判断本次请求为重复请求，无访问权限
                 callback(attach._err_msg, update_cookie ? cookie : nullptr);
                 return;
@@ -447,6 +468,10 @@ static string pathCat(const string &a, const string &b){
     return a + '/' + b;
 }
 
+static bool isHlsSegment(const string &file_path) {
+    return end_with(file_path, ".ts") || end_with(file_path, ".mp4") || end_with(file_path, ".m4s");
+}
+
 /**
  * 访问文件
  * @param sender 事件触发者
@@ -457,10 +482,41 @@ static string pathCat(const string &a, const string &b){
  */
 static void accessFile(Session &sender, const Parser &parser, const MediaInfo &media_info, const string &file_path, const HttpFileManager::invoker &cb) {
     bool is_hls = end_with(file_path, kHlsSuffix) || end_with(file_path, kHlsFMP4Suffix);
-    if (!is_hls && !File::fileExist(file_path)) {
-        //文件不存在且不是hls,那么直接返回404
-        sendNotFound(cb);
-        return;
+    Buffer::Ptr memory_file;
+    if (!is_hls) {
+        GET_CONFIG(bool, memoryCache, Hls::kMemoryCache);
+        // 只有hls切片(ts/fmp4)可能存在于内存中，其他静态文件不必加锁查找
+        bool hlsMemoryCache = memoryCache && isHlsSegment(file_path);
+        if (hlsMemoryCache) {
+            // 优先从内存中查找hls切片
+            memory_file = HlsMediaSource::findMemoryFile(file_path);
+        }
+        if (!memory_file && !File::fileExist(file_path)) {
+            if (hlsMemoryCache) {
+                // LL-HLS预加载提示的分片尚未生成，等待分片生成后再回复
+                weak_ptr<Session> weak_session = static_pointer_cast<Session>(sender.shared_from_this());
+                auto waiting = HlsMediaSource::waitMemoryFile(file_path, [weak_session, parser, media_info, file_path, cb](const Buffer::Ptr &buffer) {
+                    auto strong_session = weak_session.lock();
+                    if (!strong_session) {
+                        return;
+                    }
+                    if (!buffer) {
+                        // 超时或流已注销
+                        sendNotFound(cb);
+                        return;
+                    }
+                    strong_session->async([strong_session, parser, media_info, file_path, cb]() {
+                        accessFile(*strong_session, parser, media_info, file_path, cb);
+                    }, false);
+                });
+                if (waiting) {
+                    return;
+                }
+            }
+            //文件不存在且不是hls,那么直接返回404
+            sendNotFound(cb);
+            return;
+        }
     }
     if (is_hls) {
         // hls，那么移除掉后缀获取真实的stream_id并且修改协议为HLS
@@ -475,7 +531,7 @@ static void accessFile(Session &sender, const Parser &parser, const MediaInfo &m
 
     weak_ptr<Session> weakSession = static_pointer_cast<Session>(sender.shared_from_this());
     //判断是否有权限访问该文件
-    canAccessPath(sender, parser, media_info, false, [cb, file_path, parser, is_hls, media_info, weakSession](const string &err_msg, const HttpServerCookie::Ptr &cookie) {
+    canAccessPath(sender, parser, media_info, false, [cb, file_path, parser, is_hls, media_info, weakSession, memory_file](const string &err_msg, const HttpServerCookie::Ptr &cookie) {
         auto strongSession = weakSession.lock();
         if (!strongSession) {
             // http客户端已经断开，不需要回复
@@ -491,7 +547,7 @@ static void accessFile(Session &sender, const Parser &parser, const MediaInfo &m
             return;
         }
 
-        auto response_file = [is_hls](const HttpServerCookie::Ptr &cookie, const HttpFileManager::invoker &cb, const string &file_path, const Parser &parser, const string &file_content = "") {
+        auto response_file = [is_hls, memory_file](const HttpServerCookie::Ptr &cookie, const HttpFileManager::invoker &cb, const string &file_path, const Parser &parser, const string &file_content = "") {
             StrCaseMap httpHeader;
             if (cookie) {
                 httpHeader["Set-Cookie"] = cookie->getCookie(cookie->getAttach<HttpCookieAttachment>()._path);
@@ -505,6 +561,19 @@ static void accessFile(Session &sender, const Parser &parser, const MediaInfo &m
                 }
                 cb(code, HttpFileManager::getContentType(file_path.data()), headerOut, body);
             };
+            auto buffer = memory_file;
+            if (!buffer && is_hls && file_content.empty()) {
+                GET_CONFIG(bool, hlsMemoryCache, Hls::kMemoryCache);
+                if (hlsMemoryCache) {
+                    // m3u8文件可能只存在于内存中
+                    buffer = HlsMediaSource::findMemoryFile(file_path);
+                }
+            }
+            if (buffer) {
+                // 直接回复内存中的hls文件，不经过文件系统，同样支持分节下载
+                invoker.responseBuffer(parser.getHeader(), httpHeader, std::move(buffer), file_path);
+                return;
+            }
             GET_CONFIG_FUNC(vector<string>, forbidCacheSuffix, Http::kForbidCacheSuffix, [](const string &str) {
                 return split(str, ",");
             });
@@ -530,6 +599,20 @@ static void accessFile(Session &sender, const Parser &parser, const MediaInfo &m
         auto &attach = cookie->getAttach<HttpCookieAttachment>();
         auto src = attach._hls_data->getMediaSource();
         if (src) {
+            auto &args = parser.getUrlArgs();
+            auto it = args.find("_HLS_msn");
+            if (it != args.end()) {
+                // LL-HLS阻塞式请求，等待m3u8包含指定切片或分片后再回复
+                auto part = args.find("_HLS_part");
+                auto ok = src->getIndexFile(atoll(it->second.data()), part == args.end() ? -1 : atoi(part->second.data()),
+                                            [response_file, cookie, cb, file_path, parser](const string &file) {
+                                                response_file(cookie, cb, file_path, parser, file);
+                                            });
+                if (!ok) {
+                    cb(400, "text/html", StrCaseMap(), std::make_shared<HttpStringBody>("invalid _HLS_msn"));
+                }
+                return;
+            }
             // 直接从内存获取m3u8索引文件(而不是从文件系统)
             response_file(cookie, cb, file_path, parser, src->getIndexFile());
             return;
@@ -719,27 +802,50 @@ void HttpResponseInvokerImp::responseFile(const StrCaseMap &requestHeader,
     // 尝试添加Content-Type
     httpHeader.emplace("Content-Type", HttpConst::getHttpContentType(file.data()) + "; charset=" + charSet);
 
-    auto &strRange = const_cast<StrCaseMap &>(requestHeader)["Range"];
-    int code = 200;
-    if (!strRange.empty()) {
-        //分节下载
-        code = 206;
-        auto iRangeStart = atoll(findSubString(strRange.data(), "bytes=", "-").data());
-        auto iRangeEnd = atoll(findSubString(strRange.data(), "-", nullptr).data());
-        auto fileSize = fileBody->remainSize();
-        if (iRangeEnd == 0) {
-            iRangeEnd = fileSize - 1;
-        }
+    int code = parseRange(requestHeader, httpHeader, fileBody->remainSize(), [&](int64_t offset, int64_t size) {
         //设置文件范围
-        fileBody->setRange(iRangeStart, iRangeEnd - iRangeStart + 1);
-        //分节下载返回Content-Range头
-        httpHeader.emplace("Content-Range", StrPrinter << "bytes " << iRangeStart << "-" << iRangeEnd << "/" << fileSize << endl);
-    }
+        fileBody->setRange(offset, size);
+    });
 
     //回复文件
     (*this)(code, httpHeader, fileBody);
 }
 
+void HttpResponseInvokerImp::responseBuffer(const StrCaseMap &requestHeader,
+                                            const StrCaseMap &responseHeader,
+                                            Buffer::Ptr buffer,
+                                            const string &file_path) const {
+    GET_CONFIG(string, charSet, Http::kCharSet);
+    StrCaseMap &httpHeader = const_cast<StrCaseMap &>(responseHeader);
+    // 尝试添加Content-Type
+    httpHeader.emplace("Content-Type", HttpConst::getHttpContentType(file_path.data()) + "; charset=" + charSet);
+
+    auto total_size = (int64_t)buffer->size();
+    auto body = std::make_shared<HttpBufferBody>(std::move(buffer));
+    int code = parseRange(requestHeader, httpHeader, total_size, [&](int64_t offset, int64_t size) {
+        body->setRange(offset, size);
+    });
+    (*this)(code, httpHeader, body);
+}
+
+int HttpResponseInvokerImp::parseRange(const StrCaseMap &requestHeader, StrCaseMap &responseHeader, int64_t total_size,
+                                       const function<void(int64_t offset, int64_t size)> &set_range) {
+    auto &strRange = const_cast<StrCaseMap &>(requestHeader)["Range"];
+    if (strRange.empty()) {
+        return 200;
+    }
+    //分节下载
+    auto iRangeStart = atoll(findSubString(strRange.data(), "bytes=", "-").data());
+    auto iRangeEnd = atoll(findSubString(strRange.data(), "-", nullptr).data());
+    if (iRangeEnd == 0) {
+        iRangeEnd = total_size - 1;
+    }
+    set_range(iRangeStart, iRangeEnd - iRangeStart + 1);
+    //分节下载返回Content-Range头
+    responseHeader.emplace("Content-Range", StrPrinter << "bytes " << iRangeStart << "-" << iRangeEnd << "/" << total_size << endl);
+    return 206;
+}
+
 HttpResponseInvokerImp::operator bool(){
     return _lambad.operator bool();
 }
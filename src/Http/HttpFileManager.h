@@ -34,7 +34,13 @@ public:
     void operator()(int code, const StrCaseMap &headerOut, const std::string &body) const;
 
     void responseFile(const StrCaseMap &requestHeader,const StrCaseMap &responseHeader,const std::string &file, bool use_mmap = true, bool is_path = true) const;
+    void responseBuffer(const StrCaseMap &requestHeader, const StrCaseMap &responseHeader, toolkit::Buffer::Ptr buffer, const std::string &file_path) const;
     operator bool();
+private:
+    // 解析Range请求头，返回200或206，并通过set_range设置读取范围
+    static int parseRange(const StrCaseMap &requestHeader, StrCaseMap &responseHeader, int64_t total_size,
+                          const std::function<void(int64_t offset, int64_t size)> &set_range);
+
 private:
     HttpResponseInvokerLambda0 _lambad;
 };
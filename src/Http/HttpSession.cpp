@@ -770,6 +770,26 @@ void HttpSession::onWrite(const Buffer::Ptr &buffer, bool flush) {
     }
 }
 
+void HttpSession::onWriteSharedFlvTag(const Buffer::Ptr &header, const Buffer::Ptr &body, const Buffer::Ptr &trailer, const Buffer::Ptr &ws_header, bool flush) {
+    if (!_live_over_websocket) {
+        FlvMuxer::onWriteSharedFlvTag(header, body, trailer, ws_header, flush);
+        return;
+    }
+    // ws-flv: 整个flv tag作为一个websocket帧发送，帧头也是所有播放器共享的
+    _ticker.resetTime();
+    _total_bytes_usage += ws_header->size() + header->size() + body->size() + trailer->size();
+    send(ws_header);
+    send(header);
+    send(body);
+    if (flush) {
+        HttpSession::setSendFlushFlag(true);
+    }
+    send(trailer);
+    if (flush) {
+        HttpSession::setSendFlushFlag(false);
+    }
+}
+
 void HttpSession::onWebSocketEncodeData(Buffer::Ptr buffer) {
     _total_bytes_usage += buffer->size();
     send(std::move(buffer));
@@ -52,6 +52,8 @@ protected:
     void onWrite(const toolkit::Buffer::Ptr &data, bool flush) override ;
     void onDetach() override;
     std::shared_ptr<FlvMuxer> getSharedPtr() override;
+    void onWriteSharedFlvTag(const toolkit::Buffer::Ptr &header, const toolkit::Buffer::Ptr &body,
+                             const toolkit::Buffer::Ptr &trailer, const toolkit::Buffer::Ptr &ws_header, bool flush) override;
 
     //HttpRequestSplitter override
     ssize_t onRecvHeader(const char *data,size_t len) override;
@@ -99,6 +99,14 @@ public:
      */
     void encode(const WebSocketHeader &header,const toolkit::Buffer::Ptr &buffer);
 
+    /**
+     * 生成数据包头
+     * @param header 数据头
+     * @param len 负载数据长度
+     * @return 序列化后的数据包头(包含掩码)
+     */
+    static std::string encodeHeader(const WebSocketHeader &header, uint64_t len);
+
 protected:
     /**
      * 收到一个webSocket数据包包头，后续将继续触发onWebSocketDecodePayload回调
@@ -8,6 +8,7 @@
  * may be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <mutex>
 #include <algorithm>
 #include "PlayerBase.h"
 #include "Rtsp/RtspPlayerImp.h"
@@ -21,6 +22,14 @@ using namespace toolkit;
 
 namespace mediakit {
 
+static std::mutex s_player_mtx;
+static std::map<std::string, PlayerBase::onCreatePlayer, StrCaseCompare> s_player_creator;
+
+void PlayerBase::registerPlayer(const string &schema, onCreatePlayer cb) {
+    std::lock_guard<std::mutex> lck(s_player_mtx);
+    s_player_creator[schema] = std::move(cb);
+}
+
 PlayerBase::Ptr PlayerBase::createPlayer(const EventPoller::Ptr &in_poller, const string &url_in) {
     auto poller = in_poller ? in_poller : EventPollerPool::Instance().getPoller();
     std::weak_ptr<EventPoller> weak_poller = poller;
@@ -69,6 +78,14 @@ PlayerBase::Ptr PlayerBase::createPlayer(const EventPoller::Ptr &in_poller, cons
         }
     }
 
+    {
+        std::lock_guard<std::mutex> lck(s_player_mtx);
+        auto it = s_player_creator.find(prefix);
+        if (it != s_player_creator.end()) {
+            return it->second(poller);
+        }
+    }
+
     throw std::invalid_argument("not supported play schema:" + url_in);
 }
 
@@ -28,9 +28,17 @@ class PlayerBase : public TrackSource, public toolkit::mINI {
 public:
     using Ptr = std::shared_ptr<PlayerBase>;
     using Event = std::function<void(const toolkit::SockException &ex)>;
+    using onCreatePlayer = std::function<Ptr(const toolkit::EventPoller::Ptr &poller)>;
 
     static Ptr createPlayer(const toolkit::EventPoller::Ptr &poller, const std::string &strUrl);
 
+    /**
+     * 注册其他模块(例如srt)实现的播放器，供createPlayer根据url协议创建
+     * @param schema url协议，不区分大小写
+     * @param cb 创建播放器对象的函数，返回的对象应在poller线程析构
+     */
+    static void registerPlayer(const std::string &schema, onCreatePlayer cb);
+
     PlayerBase();
 
     /**
@@ -8,6 +8,7 @@
  * may be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <mutex>
 #include <algorithm>
 #include "PusherBase.h"
 #include "Rtsp/RtspPusher.h"
@@ -17,6 +18,14 @@ using namespace toolkit;
 
 namespace mediakit {
 
+static std::mutex s_pusher_mtx;
+static std::map<std::string, PusherBase::onCreatePusher, StrCaseCompare> s_pusher_creator;
+
+void PusherBase::registerPusher(const std::string &schema, onCreatePusher cb) {
+    std::lock_guard<std::mutex> lck(s_pusher_mtx);
+    s_pusher_creator[schema] = std::move(cb);
+}
+
 PusherBase::Ptr PusherBase::createPusher(const EventPoller::Ptr &in_poller,
                                          const MediaSource::Ptr &src,
                                          const std::string & url) {
@@ -50,6 +59,14 @@ PusherBase::Ptr PusherBase::createPusher(const EventPoller::Ptr &in_poller,
         return PusherBase::Ptr(new RtmpPusherImp(poller, std::dynamic_pointer_cast<RtmpMediaSource>(src)), release_func);
     }
 
+    {
+        std::lock_guard<std::mutex> lck(s_pusher_mtx);
+        auto it = s_pusher_creator.find(prefix);
+        if (it != s_pusher_creator.end()) {
+            return it->second(poller, src);
+        }
+    }
+
     throw std::invalid_argument("not supported push schema:" + url);
 }
 
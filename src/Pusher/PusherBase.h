@@ -25,11 +25,19 @@ class PusherBase : public toolkit::mINI {
 public:
     using Ptr = std::shared_ptr<PusherBase>;
     using Event = std::function<void(const toolkit::SockException &ex)>;
+    using onCreatePusher = std::function<Ptr(const toolkit::EventPoller::Ptr &poller, const MediaSource::Ptr &src)>;
 
     static Ptr createPusher(const toolkit::EventPoller::Ptr &poller,
                             const MediaSource::Ptr &src,
                             const std::string &strUrl);
 
+    /**
+     * 注册其他模块(例如srt)实现的推流器，供createPusher根据url协议创建
+     * @param schema url协议，不区分大小写
+     * @param cb 创建推流器对象的函数，返回的对象应在poller线程析构
+     */
+    static void registerPusher(const std::string &schema, onCreatePusher cb);
+
     PusherBase();
     virtual ~PusherBase() = default;
 
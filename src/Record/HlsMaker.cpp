@@ -9,6 +9,7 @@
  */
 
 #include <iomanip>
+#include <algorithm>
 #include "HlsMaker.h"
 #include "Common/config.h"
 
@@ -27,6 +28,8 @@ HlsMaker::HlsMaker(bool is_fmp4, float seg_duration, uint32_t seg_number, bool s
 void HlsMaker::makeIndexFile(bool include_delay, bool eof) {
     GET_CONFIG(uint32_t, segDelay, Hls::kSegmentDelay);
     GET_CONFIG(uint32_t, segRetain, Hls::kSegmentRetain);
+    // 只有直播的实时m3u8才输出LL-HLS分片
+    bool low_latency = _part_duration > 0 && _seg_number && !include_delay;
     std::deque<std::tuple<int, std::string>> temp(_seg_dur_list);
     if (!include_delay && _seg_number) {
         while (temp.size() > _seg_number) {
@@ -40,17 +43,19 @@ void HlsMaker::makeIndexFile(bool include_delay, bool eof) {
             maxSegmentDuration = dur;
         }
     }
+    // 已完成的切片个数，LL-HLS在切片生成过程中也会更新m3u8
+    auto seg_count = _last_file_name.empty() ? _file_index : _file_index - 1;
     uint64_t index_seq;
     if (_seg_number) {
         if (include_delay) {
-            if (_file_index > _seg_number + segDelay) {
-                index_seq = _file_index - _seg_number - segDelay;
+            if (seg_count > _seg_number + segDelay) {
+                index_seq = seg_count - _seg_number - segDelay;
             } else {
                 index_seq = 0LL;
             }
         } else {
-            if (_file_index > _seg_number) {
-                index_seq = _file_index - _seg_number;
+            if (seg_count > _seg_number) {
+                index_seq = seg_count - _seg_number;
             } else {
                 index_seq = 0LL;
             }
@@ -75,9 +80,40 @@ void HlsMaker::makeIndexFile(bool include_delay, bool eof) {
     }
 
     stringstream ss;
+    if (low_latency) {
+        // 播放器至少落后3个分片，并支持_HLS_msn/_HLS_part阻塞式请求m3u8
+        ss << "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=" << std::setprecision(3) << _part_duration * 3 << "\n";
+        ss << "#EXT-X-PART-INF:PART-TARGET=" << std::setprecision(3) << _part_duration << "\n";
+    }
+    auto write_part = [&](const Part &part) {
+        ss << "#EXT-X-PART:DURATION=" << std::setprecision(3) << part.duration / 1000.0 << ",URI=\"" << part.url << "\"";
+        if (part.independent) {
+            ss << ",INDEPENDENT=YES";
+        }
+        ss << "\n";
+    };
+    // 只有最后几个切片输出分片信息
+    size_t part_offset = temp.size() - (low_latency ? _seg_parts.size() : 0);
+    size_t index = 0;
     for (auto &tp : temp) {
+        if (index >= part_offset) {
+            for (auto &part : _seg_parts[index - part_offset]) {
+                write_part(part);
+            }
+        }
+        ++index;
         ss << "#EXTINF:" << std::setprecision(3) << std::get<0>(tp) / 1000.0 << ",\n" << std::get<1>(tp) << "\n";
     }
+    if (low_latency && !eof) {
+        // 正在生成的切片的分片，以及下一个分片的预加载提示
+        for (auto &part : _cur_parts) {
+            write_part(part);
+        }
+        uint64_t msn;
+        uint32_t part;
+        getPartState(msn, part);
+        ss << "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"" << getPartUrl(msn, part) << "\"\n";
+    }
     index_str += ss.str();
 
     if (eof) {
@@ -105,6 +141,10 @@ void HlsMaker::inputData(const char *data, size_t len, uint64_t timestamp, bool
             addNewSegment(timestamp);
         }
         if (!_last_file_name.empty()) {
+            if (_part_duration > 0) {
+                // 尝试切分LL-HLS分片
+                addNewPart(timestamp, is_idr_fast_packet);
+            }
             // 存在切片才写入ts数据
             onWriteSegment(data, len);
             _last_timestamp = timestamp;
@@ -150,18 +190,61 @@ void HlsMaker::addNewSegment(uint64_t stamp) {
     _last_seg_timestamp = _last_timestamp ? _last_timestamp : stamp;
 }
 
+void HlsMaker::addNewPart(uint64_t stamp, bool independent) {
+    if (_part_started) {
+        // 预估再写入一帧后是否超过分片时长，分片时长不得超过PART-TARGET
+        auto next_stamp = stamp + (stamp > _last_timestamp ? stamp - _last_timestamp : 0);
+        if (next_stamp - _last_part_timestamp <= _part_duration * 1000) {
+            // 分片时长不够
+            return;
+        }
+        flushLastPart(stamp, true);
+    }
+    //新增分片
+    _part_started = true;
+    _part_independent = independent;
+    _last_part_timestamp = stamp;
+}
+
+void HlsMaker::flushLastPart(uint64_t stamp, bool update_index) {
+    if (!_part_started) {
+        return;
+    }
+    _part_started = false;
+    auto part_dur = stamp > _last_part_timestamp ? stamp - _last_part_timestamp : 1;
+    auto seg_index = _file_index - 1;
+    auto part_index = (uint32_t)_cur_parts.size();
+    //先保存分片数据，然后写m3u8文件
+    onFlushPart(seg_index, part_index);
+    _cur_parts.emplace_back(Part { part_dur, getPartUrl(seg_index, part_index), _part_independent });
+    if (update_index) {
+        makeIndexFile(false);
+    }
+}
+
 void HlsMaker::flushLastSegment(bool eof){
     GET_CONFIG(uint32_t, segDelay, Hls::kSegmentDelay);
     if (_last_file_name.empty()) {
         //不存在上个切片
         return;
     }
+    //关闭本切片最后一个分片
+    flushLastPart(_last_timestamp, false);
     //文件创建到最后一次数据写入的时间即为切片长度
     auto seg_dur = _last_timestamp - _last_seg_timestamp;
     if (seg_dur <= 0) {
         seg_dur = 100;
     }
     _seg_dur_list.emplace_back(seg_dur, std::move(_last_file_name));
+    _last_file_name.clear();
+    if (_part_duration > 0) {
+        //m3u8中最多保留最近3个切片的分片信息
+        _seg_parts.emplace_back(std::move(_cur_parts));
+        _cur_parts.clear();
+        while (_seg_parts.size() > std::min<size_t>(3, _seg_number)) {
+            _seg_parts.pop_front();
+        }
+    }
     delOldSegment();
     //先flush ts切片，否则可能存在ts文件未写入完毕就被访问的情况
     onFlushLastSegment(seg_dur);
@@ -173,6 +256,21 @@ void HlsMaker::flushLastSegment(bool eof){
     }
 }
 
+void HlsMaker::setPartDuration(float part_duration) {
+    _part_duration = part_duration;
+}
+
+void HlsMaker::getPartState(uint64_t &msn, uint32_t &part) const {
+    if (_last_file_name.empty()) {
+        //当前没有正在生成的切片，等待生成下一个切片
+        msn = _file_index;
+        part = 0;
+    } else {
+        msn = _file_index - 1;
+        part = (uint32_t)_cur_parts.size();
+    }
+}
+
 bool HlsMaker::isLive() const {
     return _seg_number != 0;
 }
@@ -191,6 +289,9 @@ void HlsMaker::clear() {
     _last_seg_timestamp = 0;
     _seg_dur_list.clear();
     _last_file_name.clear();
+    _part_started = false;
+    _cur_parts.clear();
+    _seg_parts.clear();
 }
 
 }//namespace mediakit
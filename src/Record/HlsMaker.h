@@ -14,6 +14,7 @@
 #include <string>
 #include <deque>
 #include <tuple>
+#include <vector>
 #include <cstdint>
 
 namespace mediakit {
@@ -65,6 +66,24 @@ public:
      */
     void clear();
 
+    /**
+     * 设置LL-HLS分片(EXT-X-PART)时长
+     * @param part_duration 分片时长，单位秒，0则不生成分片
+     */
+    void setPartDuration(float part_duration);
+
+    /**
+     * 获取LL-HLS分片时长，单位秒，0代表不生成分片
+     */
+    float getPartDuration() const { return _part_duration; }
+
+    /**
+     * 获取m3u8对应的LL-HLS状态
+     * @param msn 正在生成的切片序号
+     * @param part 该切片已完成的分片个数
+     */
+    void getPartState(uint64_t &msn, uint32_t &part) const;
+
 protected:
     /**
      * 创建ts切片文件回调
@@ -104,6 +123,20 @@ protected:
      */
     virtual void onFlushLastSegment(uint64_t duration_ms) {};
 
+    /**
+     * 获取LL-HLS分片的url(相对m3u8文件)，分片完成前该url可能已经作为EXT-X-PRELOAD-HINT输出
+     * @param seg_index 所属切片序号
+     * @param part_index 分片在切片中的序号
+     */
+    virtual std::string getPartUrl(uint64_t seg_index, uint32_t part_index) { return ""; }
+
+    /**
+     * LL-HLS分片完成回调，分片数据为本切片中上个分片完成后写入的全部数据
+     * @param seg_index 所属切片序号
+     * @param part_index 分片在切片中的序号
+     */
+    virtual void onFlushPart(uint64_t seg_index, uint32_t part_index) {};
+
     /**
      * 关闭上个ts切片并且写入m3u8索引
      * @param eof HLS直播是否已结束
@@ -128,7 +161,27 @@ private:
      */
     void addNewSegment(uint64_t timestamp);
 
+    /**
+     * 尝试开始新的LL-HLS分片
+     * @param timestamp 本次写入数据的时间戳
+     * @param independent 是否以关键帧开始
+     */
+    void addNewPart(uint64_t timestamp, bool independent);
+
+    /**
+     * 关闭当前LL-HLS分片
+     * @param timestamp 分片结束时间戳
+     * @param update_index 是否更新m3u8
+     */
+    void flushLastPart(uint64_t timestamp, bool update_index);
+
 private:
+    struct Part {
+        uint64_t duration;
+        std::string url;
+        bool independent;
+    };
+
     bool _is_fmp4 = false;
     float _seg_duration = 0;
     uint32_t _seg_number = 0;
@@ -138,6 +191,17 @@ private:
     uint64_t _file_index = 0;
     std::string _last_file_name;
     std::deque<std::tuple<int,std::string> > _seg_dur_list;
+
+    // LL-HLS分片时长，单位秒
+    float _part_duration = 0;
+    // 当前分片是否已经开始
+    bool _part_started = false;
+    bool _part_independent = false;
+    uint64_t _last_part_timestamp = 0;
+    // 当前切片已完成的分片
+    std::vector<Part> _cur_parts;
+    // 最近完成的几个切片的分片，与_seg_dur_list尾部对齐
+    std::deque<std::vector<Part>> _seg_parts;
 };
 
 }//namespace mediakit
@@ -39,6 +39,16 @@ HlsMakerImp::HlsMakerImp(bool is_fmp4, const string &m3u8_file, const string &pa
     _buf_size = bufSize;
     _file_buf.reset(new char[bufSize], [](char *ptr) { delete[] ptr; });
     _info.folder = _path_prefix;
+
+    GET_CONFIG(bool, memoryCache, Hls::kMemoryCache);
+    GET_CONFIG(bool, broadcastRecordTs, Hls::kBroadcastRecordTs);
+    // 点播、保留切片、切片完成广播都需要文件落盘
+    _memory_only = memoryCache && isLive() && !isKeep() && !broadcastRecordTs;
+    if (_memory_only) {
+        // LL-HLS分片只保存在内存中
+        GET_CONFIG(float, partDuration, Hls::kPartDuration);
+        setPartDuration(partDuration);
+    }
 }
 
 HlsMakerImp::~HlsMakerImp() {
@@ -68,7 +78,12 @@ void HlsMakerImp::clearCache(bool immediately, bool eof) {
         return;
     }
 
-    {
+    if (_memory_only) {
+        // 切片未落盘，清空内存即可
+        if (_media_src) {
+            _media_src->clearMemoryFile();
+        }
+    } else {
         std::list<std::string> lst;
         lst.emplace_back(_path_hls);
         lst.emplace_back(_path_hls_delay);
@@ -93,6 +108,9 @@ void HlsMakerImp::clearCache(bool immediately, bool eof) {
 
     clear();
     _file = nullptr;
+    _segment_data.clear();
+    _part_offset = 0;
+    _segment_parts.clear();
     _segment_file_paths.clear();
 }
 
@@ -108,7 +126,13 @@ string HlsMakerImp::onOpenSegment(uint64_t index) {
             _segment_file_paths.emplace(index, segment_path);
         }
     }
-    _file = makeFile(segment_path, true);
+    _segment_index = index;
+    if (_memory_only) {
+        _segment_data.clear();
+        _part_offset = 0;
+    } else {
+        _file = makeFile(segment_path, true);
+    }
 
     // 保存本切片的元数据
     _info.start_time = ::time(NULL);
@@ -116,7 +140,7 @@ string HlsMakerImp::onOpenSegment(uint64_t index) {
     _info.file_path = segment_path;
     _info.url = _info.app + "/" + _info.stream + "/" + segment_name;
 
-    if (!_file) {
+    if (!_file && !_memory_only) {
         WarnL << "Create file failed," << segment_path << " " << get_uv_errmsg();
     }
     if (_params.empty()) {
@@ -126,16 +150,29 @@ string HlsMakerImp::onOpenSegment(uint64_t index) {
 }
 
 void HlsMakerImp::onDelSegment(uint64_t index) {
+    delPart(index);
     auto it = _segment_file_paths.find(index);
     if (it == _segment_file_paths.end()) {
         return;
     }
-    File::delete_file(it->second.data(), true);
+    if (_memory_only) {
+        if (_media_src) {
+            _media_src->setMemoryFile(getMemoryFileName(it->second), nullptr);
+        }
+    } else {
+        File::delete_file(it->second.data(), true);
+    }
     _segment_file_paths.erase(it);
 }
 
 void HlsMakerImp::onWriteInitSegment(const char *data, size_t len) {
     string init_seg_path = _path_prefix + "/init.mp4";
+    if (_memory_only) {
+        if (_media_src) {
+            _media_src->setMemoryFile(getMemoryFileName(init_seg_path), std::make_shared<BufferString>(string(data, len)));
+        }
+        return;
+    }
     _file = makeFile(init_seg_path);
 
     if (_file) {
@@ -148,7 +185,9 @@ void HlsMakerImp::onWriteInitSegment(const char *data, size_t len) {
 }
 
 void HlsMakerImp::onWriteSegment(const char *data, size_t len) {
-    if (_file) {
+    if (_memory_only) {
+        _segment_data.append(data, len);
+    } else if (_file) {
         fwrite(data, len, 1, _file.get());
     }
     if (_media_src) {
@@ -158,12 +197,31 @@ void HlsMakerImp::onWriteSegment(const char *data, size_t len) {
 
 void HlsMakerImp::onWriteHls(const std::string &data, bool include_delay) {
     auto path = include_delay ? _path_hls_delay : _path_hls;
+    if (_memory_only) {
+        if (_media_src) {
+            if (!include_delay) {
+                uint64_t msn;
+                uint32_t part;
+                getPartState(msn, part);
+                _media_src->setIndexFile(data, msn, part);
+                if (getPartDuration() > 0) {
+                    // 请求预加载提示的分片时阻塞至分片生成
+                    _media_src->setPreloadHint(getPartName(msn, part));
+                }
+            }
+            _media_src->setMemoryFile(getMemoryFileName(path), std::make_shared<BufferString>(data));
+        }
+        return;
+    }
     auto hls = makeFile(path);
     if (hls) {
         fwrite(data.data(), data.size(), 1, hls.get());
         hls.reset();
         if (_media_src && !include_delay) {
-            _media_src->setIndexFile(data);
+            uint64_t msn;
+            uint32_t part;
+            getPartState(msn, part);
+            _media_src->setIndexFile(data, msn, part);
         }
     } else {
         WarnL << "Create hls file failed," << path << " " << get_uv_errmsg();
@@ -171,6 +229,22 @@ void HlsMakerImp::onWriteHls(const std::string &data, bool include_delay) {
 }
 
 void HlsMakerImp::onFlushLastSegment(uint64_t duration_ms) {
+    if (_memory_only) {
+        // 切片完成后才可被访问，先于m3u8更新
+        auto size = _segment_data.size();
+        if (_media_src) {
+            _media_src->setMemoryFile(_info.file_name, std::make_shared<BufferString>(std::move(_segment_data)));
+        }
+        // 按上个切片大小预分配内存
+        _segment_data = std::string();
+        _segment_data.reserve(size);
+        _part_offset = 0;
+        // m3u8只列出最近3个切片的分片，再多保留1个切片的分片以便播放器下载完毕
+        while (!_segment_parts.empty() && _segment_parts.begin()->first + 4 <= _segment_index) {
+            delPart(_segment_parts.begin()->first);
+        }
+        return;
+    }
     // 关闭并flush文件到磁盘
     _file = nullptr;
 
@@ -198,6 +272,46 @@ std::shared_ptr<FILE> HlsMakerImp::makeFile(const string &file, bool setbuf) {
 void HlsMakerImp::setMediaSource(const MediaTuple& tuple) {
     static_cast<MediaTuple &>(_info) = tuple;
     _media_src = std::make_shared<HlsMediaSource>(isFmp4() ? HLS_FMP4_SCHEMA : HLS_SCHEMA, _info);
+    if (_memory_only) {
+        _media_src->setMemoryDir(_path_prefix);
+    }
+}
+
+std::string HlsMakerImp::getMemoryFileName(const std::string &file_path) const {
+    return file_path.substr(_path_prefix.size() + 1);
+}
+
+std::string HlsMakerImp::getPartName(uint64_t seg_index, uint32_t part_index) const {
+    return StrPrinter << "part_" << seg_index << "_" << part_index << (isFmp4() ? ".mp4" : ".ts");
+}
+
+string HlsMakerImp::getPartUrl(uint64_t seg_index, uint32_t part_index) {
+    auto name = getPartName(seg_index, part_index);
+    if (_params.empty()) {
+        return name;
+    }
+    return name + "?" + _params;
+}
+
+void HlsMakerImp::onFlushPart(uint64_t seg_index, uint32_t part_index) {
+    if (_media_src) {
+        _media_src->setMemoryFile(getPartName(seg_index, part_index), std::make_shared<BufferString>(_segment_data.substr(_part_offset)));
+    }
+    _part_offset = _segment_data.size();
+    _segment_parts[seg_index] = part_index + 1;
+}
+
+void HlsMakerImp::delPart(uint64_t seg_index) {
+    auto it = _segment_parts.find(seg_index);
+    if (it == _segment_parts.end()) {
+        return;
+    }
+    if (_media_src) {
+        for (uint32_t i = 0; i < it->second; ++i) {
+            _media_src->setMemoryFile(getPartName(seg_index, i), nullptr);
+        }
+    }
+    _segment_parts.erase(it);
 }
 
 HlsMediaSource::Ptr HlsMakerImp::getMediaSource() const {
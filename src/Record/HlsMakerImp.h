@@ -48,12 +48,19 @@ protected:
     void onWriteSegment(const char *data, size_t len) override;
     void onWriteHls(const std::string &data, bool include_delay) override;
     void onFlushLastSegment(uint64_t duration_ms) override;
+    std::string getPartUrl(uint64_t seg_index, uint32_t part_index) override;
+    void onFlushPart(uint64_t seg_index, uint32_t part_index) override;
 
 private:
     std::shared_ptr<FILE> makeFile(const std::string &file,bool setbuf = false);
     void clearCache(bool immediately, bool eof);
+    std::string getMemoryFileName(const std::string &file_path) const;
+    std::string getPartName(uint64_t seg_index, uint32_t part_index) const;
+    void delPart(uint64_t seg_index);
 
 private:
+    // 是否只在内存中保存hls文件
+    bool _memory_only = false;
     int _buf_size;
     std::string _params;
     std::string _path_hls;
@@ -63,6 +70,14 @@ private:
     RecordInfo _info;
     std::shared_ptr<FILE> _file;
     std::shared_ptr<char> _file_buf;
+    // 内存模式下正在生成的切片数据
+    std::string _segment_data;
+    // 正在生成的切片序号
+    uint64_t _segment_index = 0;
+    // 当前LL-HLS分片在切片数据中的起始位置
+    size_t _part_offset = 0;
+    // 切片序号 -> LL-HLS分片个数
+    std::map<uint64_t, uint32_t> _segment_parts;
     HlsMediaSource::Ptr _media_src;
     toolkit::EventPoller::Ptr _poller;
     std::map<uint64_t/*index*/,std::string/*file_path*/> _segment_file_paths;
@@ -75,7 +75,7 @@ HlsMediaSource::Ptr HlsCookieData::getMediaSource() const {
     return _src.lock();
 }
 
-void HlsMediaSource::setIndexFile(std::string index_file)
+void HlsMediaSource::setIndexFile(std::string index_file, uint64_t msn, uint32_t part)
 {
     if (!_ring) {
         std::weak_ptr<HlsMediaSource> weakSelf = std::static_pointer_cast<HlsMediaSource>(shared_from_this());
@@ -93,11 +93,180 @@ void HlsMediaSource::setIndexFile(std::string index_file)
     //赋值m3u8索引文件内容
     std::lock_guard<std::mutex> lck(_mtx_index);
     _index_file = std::move(index_file);
+    _msn = msn;
+    _part = part;
 
     if (!_index_file.empty()) {
         _list_cb.for_each([&](const std::function<void(const std::string& str)>& cb) { cb(_index_file); });
         _list_cb.clear();
     }
+
+    for (auto it = _blocking_list.begin(); it != _blocking_list.end();) {
+        if (!*it->cb) {
+            // 已经超时回复
+            it = _blocking_list.erase(it);
+            continue;
+        }
+        if (!_index_file.empty() && (_msn > it->msn || (_msn == it->msn && it->part >= 0 && (uint32_t)it->part < _part))) {
+            // m3u8已经包含等待的切片或分片
+            auto cb = std::move(*it->cb);
+            *it->cb = nullptr;
+            cb(_index_file);
+            it = _blocking_list.erase(it);
+            continue;
+        }
+        ++it;
+    }
+}
+
+// 内存切片目录 -> HlsMediaSource
+static std::mutex s_mtx_memory_dir;
+static std::unordered_map<std::string, std::weak_ptr<HlsMediaSource>> s_memory_dir_map;
+
+HlsMediaSource::~HlsMediaSource() {
+    // 源销毁时回复所有阻塞中的请求，避免http请求一直挂起
+    for (auto &req : _blocking_list) {
+        if (*req.cb) {
+            auto cb = std::move(*req.cb);
+            *req.cb = nullptr;
+            cb(_index_file);
+        }
+    }
+    for (auto &pr : _waiting_files) {
+        for (auto &wait_cb : pr.second) {
+            if (*wait_cb) {
+                auto cb = std::move(*wait_cb);
+                *wait_cb = nullptr;
+                cb(nullptr);
+            }
+        }
+    }
+    if (_memory_dir.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lck(s_mtx_memory_dir);
+    auto it = s_memory_dir_map.find(_memory_dir);
+    if (it != s_memory_dir_map.end() && it->second.expired()) {
+        // 该目录可能已经被新的HlsMediaSource覆盖
+        s_memory_dir_map.erase(it);
+    }
+}
+
+void HlsMediaSource::setMemoryDir(const std::string &dir) {
+    _memory_dir = dir;
+    std::lock_guard<std::mutex> lck(s_mtx_memory_dir);
+    s_memory_dir_map[dir] = std::static_pointer_cast<HlsMediaSource>(shared_from_this());
+}
+
+void HlsMediaSource::setMemoryFile(const std::string &name, Buffer::Ptr buffer) {
+    std::list<std::function<void(const Buffer::Ptr &)>> waiting;
+    {
+        std::lock_guard<std::mutex> lck(_mtx_memory_file);
+        if (!buffer) {
+            _memory_files.erase(name);
+            return;
+        }
+        _memory_files[name] = buffer;
+        auto it = _waiting_files.find(name);
+        if (it != _waiting_files.end()) {
+            for (auto &wait_cb : it->second) {
+                if (*wait_cb) {
+                    waiting.emplace_back(std::move(*wait_cb));
+                    *wait_cb = nullptr;
+                }
+            }
+            _waiting_files.erase(it);
+        }
+    }
+    // 回复等待该分片的请求
+    for (auto &cb : waiting) {
+        cb(buffer);
+    }
+}
+
+void HlsMediaSource::setPreloadHint(std::string name) {
+    std::lock_guard<std::mutex> lck(_mtx_memory_file);
+    _preload_hint = std::move(name);
+}
+
+void HlsMediaSource::clearMemoryFile() {
+    std::lock_guard<std::mutex> lck(_mtx_memory_file);
+    _memory_files.clear();
+}
+
+HlsMediaSource::Ptr HlsMediaSource::findMemoryDir(const std::string &file_path, std::string &name) {
+    auto pos = file_path.size();
+    std::lock_guard<std::mutex> lck(s_mtx_memory_dir);
+    if (s_memory_dir_map.empty()) {
+        return nullptr;
+    }
+    // 切片位于m3u8目录下的日期/小时子目录中，逐级向上查找所属目录
+    while (pos && (pos = file_path.rfind('/', pos - 1)) != std::string::npos) {
+        auto it = s_memory_dir_map.find(file_path.substr(0, pos));
+        if (it != s_memory_dir_map.end()) {
+            name = file_path.substr(pos + 1);
+            return it->second.lock();
+        }
+    }
+    return nullptr;
+}
+
+Buffer::Ptr HlsMediaSource::findMemoryFile(const std::string &file_path) {
+    std::string name;
+    auto src = findMemoryDir(file_path, name);
+    if (!src) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lck(src->_mtx_memory_file);
+    auto it = src->_memory_files.find(name);
+    return it == src->_memory_files.end() ? nullptr : it->second;
+}
+
+bool HlsMediaSource::waitMemoryFile(const std::string &file_path, std::function<void(const Buffer::Ptr &buffer)> cb) {
+    std::string name;
+    auto src = findMemoryDir(file_path, name);
+    if (!src) {
+        return false;
+    }
+    auto invoker = std::make_shared<std::function<void(const Buffer::Ptr &)>>(std::move(cb));
+    {
+        std::lock_guard<std::mutex> lck(src->_mtx_memory_file);
+        if (name != src->_preload_hint || src->_memory_files.find(name) != src->_memory_files.end()) {
+            return false;
+        }
+        src->_waiting_files[name].emplace_back(invoker);
+    }
+
+    // 最多阻塞3倍切片时长，与m3u8阻塞式请求一致
+    GET_CONFIG(float, segDur, Hls::kSegmentDuration);
+    std::weak_ptr<HlsMediaSource> weak_src = src;
+    EventPollerPool::Instance().getPoller()->doDelayTask(segDur * 3 * 1000, [weak_src, invoker, name]() {
+        auto strong_src = weak_src.lock();
+        if (!strong_src) {
+            // 源销毁时已经回复
+            return 0;
+        }
+        std::function<void(const Buffer::Ptr &)> cb;
+        {
+            std::lock_guard<std::mutex> lck(strong_src->_mtx_memory_file);
+            if (!*invoker) {
+                return 0;
+            }
+            cb = std::move(*invoker);
+            *invoker = nullptr;
+            auto it = strong_src->_waiting_files.find(name);
+            if (it != strong_src->_waiting_files.end()) {
+                it->second.remove(invoker);
+                if (it->second.empty()) {
+                    strong_src->_waiting_files.erase(it);
+                }
+            }
+        }
+        // 超时，分片未生成
+        cb(nullptr);
+        return 0;
+    });
+    return true;
 }
 
 void HlsMediaSource::getIndexFile(std::function<void(const std::string& str)> cb)
@@ -111,4 +280,39 @@ void HlsMediaSource::getIndexFile(std::function<void(const std::string& str)> cb
     _list_cb.emplace_back(std::move(cb));
 }
 
+bool HlsMediaSource::getIndexFile(uint64_t msn, int part, std::function<void(const std::string &str)> cb) {
+    auto invoker = std::make_shared<std::function<void(const std::string &)>>(std::move(cb));
+    {
+        std::lock_guard<std::mutex> lck(_mtx_index);
+        if (msn > _msn + 2) {
+            // 请求的切片超前太多，协议规定回复400
+            return false;
+        }
+        if (!_index_file.empty() && (_msn > msn || (_msn == msn && part >= 0 && (uint32_t)part < _part))) {
+            (*invoker)(_index_file);
+            return true;
+        }
+        _blocking_list.emplace_back(BlockingRequest { msn, part, invoker });
+    }
+
+    // 最多阻塞3倍切片时长
+    GET_CONFIG(float, segDur, Hls::kSegmentDuration);
+    std::weak_ptr<HlsMediaSource> weak_self = std::static_pointer_cast<HlsMediaSource>(shared_from_this());
+    EventPollerPool::Instance().getPoller()->doDelayTask(segDur * 3 * 1000, [weak_self, invoker]() {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return 0;
+        }
+        std::lock_guard<std::mutex> lck(strong_self->_mtx_index);
+        if (*invoker) {
+            // 超时，回复当前m3u8
+            auto cb = std::move(*invoker);
+            *invoker = nullptr;
+            cb(strong_self->_index_file);
+        }
+        return 0;
+    });
+    return true;
+}
+
 } // namespace mediakit
@@ -15,6 +15,7 @@
 #include "Util/TimeTicker.h"
 #include "Util/RingBuffer.h"
 #include <atomic>
+#include <unordered_map>
 
 namespace mediakit {
 
@@ -26,6 +27,7 @@ public:
     using Ptr = std::shared_ptr<HlsMediaSource>;
 
     HlsMediaSource(const std::string &schema, const MediaTuple &tuple) : MediaSource(schema, tuple) {}
+    ~HlsMediaSource() override;
 
     /**
      * 	获取媒体源的环形缓冲
@@ -39,14 +41,25 @@ public:
 
     /**
      * 设置或清空m3u8索引文件内容
+     * @param msn 正在生成的切片序号(LL-HLS)
+     * @param part 该切片已完成的分片个数(LL-HLS)
      */
-    void setIndexFile(std::string index_file);
+    void setIndexFile(std::string index_file, uint64_t msn = 0, uint32_t part = 0);
 
     /**
      * 异步获取m3u8文件
      */
     void getIndexFile(std::function<void(const std::string &str)> cb);
 
+    /**
+     * LL-HLS阻塞式获取m3u8文件，等待m3u8包含指定切片或分片后回调，超时则回复当前m3u8
+     * @param msn 切片序号(_HLS_msn)
+     * @param part 分片序号(_HLS_part)，-1代表等待整个切片完成
+     * @param cb 回调
+     * @return msn超前太多时返回false，应回复400
+     */
+    bool getIndexFile(uint64_t msn, int part, std::function<void(const std::string &str)> cb);
+
     /**
      * 同步获取m3u8文件
      */
@@ -57,16 +70,73 @@ public:
 
     void onSegmentSize(size_t bytes) { _speed[TrackVideo] += bytes; }
 
+    /**
+     * 设置内存切片目录(m3u8文件所在目录)，设置后http服务器可以直接从内存获取该目录下的hls文件
+     */
+    void setMemoryDir(const std::string &dir);
+
+    /**
+     * 设置或删除内存中的hls文件(m3u8、init.mp4、切片)
+     * @param name 相对m3u8文件所在目录的文件名
+     * @param buffer 文件内容，为空时删除
+     */
+    void setMemoryFile(const std::string &name, toolkit::Buffer::Ptr buffer);
+
+    /**
+     * 清空内存中的hls文件
+     */
+    void clearMemoryFile();
+
+    /**
+     * 根据文件绝对路径查找内存中的hls文件
+     * @param file_path 文件绝对路径
+     * @return 文件内容，未找到时返回空
+     */
+    static toolkit::Buffer::Ptr findMemoryFile(const std::string &file_path);
+
+    /**
+     * 设置m3u8中EXT-X-PRELOAD-HINT提示的LL-HLS分片文件名
+     * @param name 相对m3u8文件所在目录的文件名
+     */
+    void setPreloadHint(std::string name);
+
+    /**
+     * LL-HLS阻塞式获取EXT-X-PRELOAD-HINT提示的分片，分片生成后回调，超时或源销毁时回调nullptr
+     * @param file_path 文件绝对路径
+     * @param cb 回调
+     * @return 文件已存在或不是预加载提示的分片时返回false，此时不会回调
+     */
+    static bool waitMemoryFile(const std::string &file_path, std::function<void(const toolkit::Buffer::Ptr &buffer)> cb);
+
     void getPlayerList(const std::function<void(const std::list<toolkit::Any> &info_list)> &cb,
                        const std::function<toolkit::Any(toolkit::Any &&info)> &on_change) override {
         _ring->getInfoList(cb, on_change);
     }
 
+private:
+    static Ptr findMemoryDir(const std::string &file_path, std::string &name);
+
 private:
     RingType::Ptr _ring;
     std::string _index_file;
     mutable std::mutex _mtx_index;
     toolkit::List<std::function<void(const std::string &)>> _list_cb;
+    // LL-HLS状态以及阻塞中的m3u8请求
+    uint64_t _msn = 0;
+    uint32_t _part = 0;
+    struct BlockingRequest {
+        uint64_t msn;
+        int part;
+        std::shared_ptr<std::function<void(const std::string &)>> cb;
+    };
+    std::list<BlockingRequest> _blocking_list;
+    std::string _memory_dir;
+    std::mutex _mtx_memory_file;
+    std::unordered_map<std::string/*name*/, toolkit::Buffer::Ptr> _memory_files;
+    // 预加载提示的分片以及等待该分片生成的请求
+    using WaitFileCB = std::shared_ptr<std::function<void(const toolkit::Buffer::Ptr &)>>;
+    std::string _preload_hint;
+    std::unordered_map<std::string/*name*/, std::list<WaitFileCB>> _waiting_files;
 };
 
 class HlsCookieData {
@@ -11,6 +11,7 @@
 #ifndef HLSRECORDER_H
 #define HLSRECORDER_H
 
+#include <atomic>
 #include "HlsMakerImp.h"
 #include "MPEG.h"
 #include "MP4Muxer.h"
@@ -55,8 +56,7 @@ public:
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
-        if (_clear_cache && _option.hls_demand) {
-            _clear_cache = false;
+        if (_option.hls_demand && _clear_cache.exchange(false)) {
             //清空旧的m3u8索引文件于ts切片
             _hls->clearCache();
             _hls->getMediaSource()->setIndexFile("");
@@ -73,8 +73,9 @@ public:
     }
 
 protected:
-    bool _enabled = true;
-    bool _clear_cache = false;
+    // 开启多线程复用时，由归属线程修改，复用器线程读取
+    std::atomic<bool> _enabled { true };
+    std::atomic<bool> _clear_cache { false };
     ProtocolOption _option;
     std::shared_ptr<HlsMakerImp> _hls;
 };
@@ -457,9 +457,12 @@ FCI_TWCC::TwccPacketStatus FCI_TWCC::getPacketChunkList(size_t total_size) const
         }
         ptr += 2;
     }
-    for (auto &pr : ret) {
+    // recv delta按seq顺序排列，seq回环时map的遍历顺序与之不同
+    seq = getBaseSeq();
+    for (uint16_t i = 0; i < rtp_count; ++i, ++seq) {
         CHECK(ptr <= end);
-        pr.second.second = getRecvDelta(pr.second.first, ptr, end);
+        auto &pr = ret[seq];
+        pr.second = getRecvDelta(pr.first, ptr, end);
     }
     return ret;
 }
@@ -147,9 +147,21 @@ void FlvMuxer::onWriteFlvTag(uint8_t type, const Buffer::Ptr &buffer, uint32_t t
 }
 
 void FlvMuxer::onWriteRtmp(const RtmpPacket::Ptr &pkt, bool flush) {
+    Buffer::Ptr header, trailer, ws_header;
+    if (pkt->getFlvTag(header, trailer, ws_header)) {
+        //该rtmp包已经生成过flv tag，直接复用
+        onWriteSharedFlvTag(header, pkt, trailer, ws_header, flush);
+        return;
+    }
     onWriteFlvTag(pkt, pkt->time_stamp, flush);
 }
 
+void FlvMuxer::onWriteSharedFlvTag(const Buffer::Ptr &header, const Buffer::Ptr &body, const Buffer::Ptr &trailer, const Buffer::Ptr &ws_header, bool flush) {
+    onWrite(header, false);
+    onWrite(body, false);
+    onWrite(trailer, flush);
+}
+
 void FlvMuxer::stop() {
     if (_ring_reader) {
         _ring_reader.reset();
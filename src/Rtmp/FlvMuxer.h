@@ -31,6 +31,17 @@ protected:
     virtual void onDetach() = 0;
     virtual std::shared_ptr<FlvMuxer> getSharedPtr() = 0;
 
+    /**
+     * 发送所有播放器共享的flv tag
+     * @param header flv tag头
+     * @param body flv tag数据
+     * @param trailer PreviousTagSize
+     * @param ws_header 整个tag作为一个websocket帧时的帧头
+     * @param flush 是否刷新缓存
+     */
+    virtual void onWriteSharedFlvTag(const toolkit::Buffer::Ptr &header, const toolkit::Buffer::Ptr &body,
+                                     const toolkit::Buffer::Ptr &trailer, const toolkit::Buffer::Ptr &ws_header, bool flush);
+
 private:
     void onWriteFlvHeader(const RtmpMediaSource::Ptr &src);
     void onWriteRtmp(const RtmpPacket::Ptr &pkt, bool flush);
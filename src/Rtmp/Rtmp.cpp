@@ -9,6 +9,8 @@
  */
 
 #include "Rtmp.h"
+#include "utils.h"
+#include "Http/WebSocketSplitter.h"
 #include "Common/config.h"
 #include "Extension/Factory.h"
 
@@ -151,6 +153,94 @@ void RtmpPacket::clear() {
     ts_field = 0;
     body_size = 0;
     buffer.clear();
+    _chunk_header = nullptr;
+    _chunk_flag = nullptr;
+    _chunk_ext_stamp = nullptr;
+    _flv_tag_header = nullptr;
+    _flv_tag_trailer = nullptr;
+    _flv_ws_header = nullptr;
+}
+
+void RtmpPacket::makeChunkHeader() {
+    if (chunk_id < 2 || chunk_id > 63 || buffer.empty()) {
+        // 不支持的块流id，由RtmpProtocol::sendRtmp处理
+        return;
+    }
+    bool ext_stamp = time_stamp >= 0xFFFFFF;
+
+    // 第一个chunk的12字节完整头
+    auto header_buf = toolkit::BufferRaw::create();
+    header_buf->setCapacity(sizeof(RtmpHeader));
+    header_buf->setSize(sizeof(RtmpHeader));
+    // 对rtmp头赋值，如果使用整形赋值，在arm android上可能由于数据对齐导致总线错误的问题
+    auto header = (RtmpHeader *)header_buf->data();
+    header->fmt = 0;
+    header->chunk_id = chunk_id;
+    header->type_id = type_id;
+    set_be24(header->time_stamp, ext_stamp ? 0xFFFFFF : time_stamp);
+    set_be24(header->body_size, (uint32_t)buffer.size());
+    set_le32(header->stream_index, stream_index);
+
+    // 后续chunk的1字节头
+    auto flag_buf = toolkit::BufferRaw::create();
+    flag_buf->setCapacity(1);
+    flag_buf->setSize(1);
+    header = (RtmpHeader *)flag_buf->data();
+    header->fmt = 3;
+    header->chunk_id = chunk_id;
+
+    // 每个chunk都携带的4字节扩展时间戳
+    toolkit::BufferRaw::Ptr ext_stamp_buf;
+    if (ext_stamp) {
+        ext_stamp_buf = toolkit::BufferRaw::create();
+        ext_stamp_buf->setCapacity(4);
+        ext_stamp_buf->setSize(4);
+        set_be32(ext_stamp_buf->data(), time_stamp);
+    }
+
+    _chunk_header = std::move(header_buf);
+    _chunk_flag = std::move(flag_buf);
+    _chunk_ext_stamp = std::move(ext_stamp_buf);
+}
+
+bool RtmpPacket::getChunkHeader(uint32_t stream_index, toolkit::Buffer::Ptr &header, toolkit::Buffer::Ptr &flag, toolkit::Buffer::Ptr &ext_stamp) const {
+    if (!_chunk_header || stream_index != this->stream_index) {
+        return false;
+    }
+    header = _chunk_header;
+    flag = _chunk_flag;
+    ext_stamp = _chunk_ext_stamp;
+    return true;
+}
+
+void RtmpPacket::makeFlvTag() {
+    RtmpTagHeader header;
+    header.type = type_id;
+    set_be24(header.data_size, (uint32_t)size());
+    header.timestamp_ex = (time_stamp >> 24) & 0xff;
+    set_be24(header.timestamp, time_stamp & 0xFFFFFF);
+    _flv_tag_header = std::make_shared<toolkit::BufferString>(std::string((char *)&header, sizeof(header)));
+
+    uint32_t tag_size = htonl((uint32_t)(size() + sizeof(header)));
+    _flv_tag_trailer = std::make_shared<toolkit::BufferString>(std::string((char *)&tag_size, 4));
+
+    WebSocketHeader ws_header;
+    ws_header._fin = true;
+    ws_header._reserved = 0;
+    ws_header._opcode = WebSocketHeader::BINARY;
+    ws_header._mask_flag = false;
+    auto ws_len = sizeof(header) + size() + 4;
+    _flv_ws_header = std::make_shared<toolkit::BufferString>(WebSocketSplitter::encodeHeader(ws_header, ws_len));
+}
+
+bool RtmpPacket::getFlvTag(toolkit::Buffer::Ptr &header, toolkit::Buffer::Ptr &trailer, toolkit::Buffer::Ptr &ws_header) const {
+    if (!_flv_tag_header) {
+        return false;
+    }
+    header = _flv_tag_header;
+    trailer = _flv_tag_trailer;
+    ws_header = _flv_ws_header;
+    return true;
 }
 
 bool RtmpPacket::isVideoKeyFrame() const {
@@ -19,6 +19,8 @@
 #include "Extension/Track.h"
 
 #define DEFAULT_CHUNK_LEN	128
+//服务器(播放)与推流器发送媒体数据时采用的chunk size
+#define SERVER_CHUNK_LEN	60000
 #define HANDSHAKE_PLAINTEXT	0x03
 #define RANDOM_LEN		(1536 - 8)
 
@@ -198,6 +200,35 @@ public:
     int getAudioSampleBit() const;
     int getAudioChannel() const;
 
+    /**
+     * 预先生成rtmp chunk头与扩展时间戳，所有播放器共享，负载由发送端按chunk size切片引用本包数据，不拷贝
+     * 请在该包被多线程访问前(写入环形缓存前)调用
+     */
+    void makeChunkHeader();
+
+    /**
+     * 获取预先生成的rtmp chunk头，完整的chunk流为 header + [ext_stamp] + 负载切片 + ([flag] + [ext_stamp] + 负载切片)...
+     * @param stream_index 发送端stream id
+     * @param header 第一个chunk的完整头
+     * @param flag 后续chunk的1字节头
+     * @param ext_stamp 扩展时间戳，无扩展时间戳时为nullptr
+     * @return 未预先生成或stream id不匹配时返回false
+     */
+    bool getChunkHeader(uint32_t stream_index, toolkit::Buffer::Ptr &header, toolkit::Buffer::Ptr &flag, toolkit::Buffer::Ptr &ext_stamp) const;
+
+    /**
+     * 预先生成flv tag头、PreviousTagSize以及ws-flv的websocket帧头，所有http-flv/ws-flv播放器共享
+     * 请在该包被多线程访问前(写入环形缓存前)调用
+     */
+    void makeFlvTag();
+
+    /**
+     * 获取预先生成的flv tag，完整的tag为 header + 本包数据 + trailer
+     * ws-flv时整个tag作为一个websocket帧，帧头为ws_header
+     * @return 未预先生成时返回false
+     */
+    bool getFlvTag(toolkit::Buffer::Ptr &header, toolkit::Buffer::Ptr &trailer, toolkit::Buffer::Ptr &ws_header) const;
+
 private:
     friend class toolkit::ResourcePool_l<RtmpPacket>;
     RtmpPacket(){
@@ -207,6 +238,12 @@ private:
     RtmpPacket &operator=(const RtmpPacket &that);
 
 private:
+    toolkit::Buffer::Ptr _chunk_header;
+    toolkit::Buffer::Ptr _chunk_flag;
+    toolkit::Buffer::Ptr _chunk_ext_stamp;
+    toolkit::Buffer::Ptr _flv_tag_header;
+    toolkit::Buffer::Ptr _flv_tag_trailer;
+    toolkit::Buffer::Ptr _flv_ws_header;
     //对象个数统计
     toolkit::ObjectStatistic<RtmpPacket> _statistic;
 };
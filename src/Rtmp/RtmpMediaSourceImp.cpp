@@ -45,6 +45,12 @@ void RtmpMediaSource::setMetaData(const AMFValue &metadata) {
 }
 
 void RtmpMediaSource::onWrite(RtmpPacket::Ptr pkt, bool /*= true*/) {
+    if (pkt->isConfigFrame() || (_ring && _ring->readerCount())) {
+        // 有播放器时预先生成rtmp chunk头与flv tag头，所有播放器共享，避免每个播放器重复生成
+        // config帧会被后续播放器直接发送，所以也需要生成
+        pkt->makeChunkHeader();
+        pkt->makeFlvTag();
+    }
     bool is_video = pkt->type_id == MSG_VIDEO;
     _speed[is_video ? TrackVideo : TrackAudio] += pkt->size();
     // 保存当前时间戳
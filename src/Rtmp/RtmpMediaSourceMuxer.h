@@ -11,8 +11,10 @@
 #ifndef ZLMEDIAKIT_RTMPMEDIASOURCEMUXER_H
 #define ZLMEDIAKIT_RTMPMEDIASOURCEMUXER_H
 
+#include <atomic>
 #include "RtmpMuxer.h"
 #include "Rtmp/RtmpMediaSource.h"
+#include "Common/FrameGopCache.h"
 
 namespace mediakit {
 
@@ -46,6 +48,13 @@ public:
         _media_src->setTimeStamp(stamp);
     }
 
+    /**
+     * 设置帧级gop缓存，按需转协议无人观看后重新有人观看时，从该缓存补齐当前gop
+     */
+    void setGopCache(const FrameGopCache::Ptr &cache) {
+        _gop_replayer.setGopCache(cache);
+    }
+
     int readerCount() const{
         return _media_src->readerCount();
     }
@@ -65,13 +74,14 @@ public:
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
-        if (_clear_cache && _option.rtmp_demand) {
-            _clear_cache = false;
+        if (_option.rtmp_demand && _clear_cache.exchange(false)) {
             _media_src->clearCache();
         }
         if (_enabled || !_option.rtmp_demand) {
+            _gop_replayer.onInput(frame, [this](const Frame::Ptr &cached) { RtmpMuxer::inputFrame(cached); });
             return RtmpMuxer::inputFrame(frame);
         }
+        _gop_replayer.onSkip();
         return false;
     }
 
@@ -81,9 +91,11 @@ public:
     }
 
 private:
-    bool _enabled = true;
-    bool _clear_cache = false;
+    // 开启多线程复用时，由归属线程修改，复用器线程读取
+    std::atomic<bool> _enabled { true };
+    std::atomic<bool> _clear_cache { false };
     ProtocolOption _option;
+    FrameGopReplayer _gop_replayer;
     RtmpMediaSource::Ptr _media_src;
 };
 
@@ -225,9 +225,6 @@ void RtmpProtocol::sendRtmp(uint8_t type, uint32_t stream_index, const Buffer::P
     set_be24(header->time_stamp, ext_stamp ? 0xFFFFFF : stamp);
     set_be24(header->body_size, (uint32_t)buf->size());
     set_le32(header->stream_index, stream_index);
-    //发送rtmp头
-    onSendRawData(std::move(buffer_header));
-
     //扩展时间戳字段
     BufferRaw::Ptr buffer_ext_stamp;
     if (ext_stamp) {
@@ -246,24 +243,45 @@ void RtmpProtocol::sendRtmp(uint8_t type, uint32_t stream_index, const Buffer::P
     header->fmt = 3;
     header->chunk_id = chunk_id;
 
+    sendChunks(std::move(buffer_header), buffer_flags, buffer_ext_stamp, buf);
+}
+
+void RtmpProtocol::sendChunks(Buffer::Ptr header, const Buffer::Ptr &flag, const Buffer::Ptr &ext_stamp, const Buffer::Ptr &buf) {
+    //发送rtmp头
+    size_t totalSize = header->size();
+    onSendRawData(std::move(header));
+
     size_t offset = 0;
-    size_t totalSize = sizeof(RtmpHeader);
     while (offset < buf->size()) {
         if (offset) {
-            onSendRawData(buffer_flags);
-            totalSize += 1;
+            onSendRawData(flag);
+            totalSize += flag->size();
         }
         if (ext_stamp) {
             //扩展时间戳
-            onSendRawData(buffer_ext_stamp);
-            totalSize += 4;
+            onSendRawData(ext_stamp);
+            totalSize += ext_stamp->size();
         }
+        //负载只引用原始数据，不拷贝
         size_t chunk = min(_chunk_size_out, buf->size() - offset);
         onSendRawData(std::make_shared<BufferPartial>(buf, offset, chunk));
         totalSize += chunk;
         offset += chunk;
     }
-    _bytes_sent += (uint32_t)totalSize;
+    onSendBytes(totalSize);
+}
+
+void RtmpProtocol::sendRtmp(const RtmpPacket::Ptr &pkt, uint32_t stream_index) {
+    Buffer::Ptr header, flag, ext_stamp;
+    if (!pkt->getChunkHeader(stream_index, header, flag, ext_stamp)) {
+        sendRtmp(pkt->type_id, stream_index, pkt, pkt->time_stamp, pkt->chunk_id);
+        return;
+    }
+    sendChunks(std::move(header), flag, ext_stamp, pkt);
+}
+
+void RtmpProtocol::onSendBytes(size_t bytes) {
+    _bytes_sent += (uint32_t)bytes;
     if (_windows_size > 0 && _bytes_sent - _bytes_sent_last >= _windows_size) {
         _bytes_sent_last = _bytes_sent;
         sendAcknowledgement(_bytes_sent);
@@ -61,9 +61,12 @@ protected:
     void sendResponse(int type, const std::string &str);
     void sendRtmp(uint8_t type, uint32_t stream_index, const std::string &buffer, uint32_t stamp, int chunk_id);
     void sendRtmp(uint8_t type, uint32_t stream_index, const toolkit::Buffer::Ptr &buffer, uint32_t stamp, int chunk_id);
+    //优先使用多个播放器共享的chunk头，负载切片引用原始数据，不匹配时再逐个生成chunk头
+    void sendRtmp(const RtmpPacket::Ptr &pkt, uint32_t stream_index);
     toolkit::BufferRaw::Ptr obtainBuffer(const void *data = nullptr, size_t len = 0);
 
 private:
+    void sendChunks(toolkit::Buffer::Ptr header, const toolkit::Buffer::Ptr &flag, const toolkit::Buffer::Ptr &ext_stamp, const toolkit::Buffer::Ptr &buf);
     void handle_C1_simple(const char *data);
 #ifdef ENABLE_OPENSSL
     void handle_C1_complex(const char *data);
@@ -78,6 +81,7 @@ private:
     const char* handle_C2(const char *data, size_t len);
     const char* handle_rtmp(const char *data, size_t len);
     void handle_chunk(RtmpPacket::Ptr chunk_data);
+    void onSendBytes(size_t bytes);
 
 protected:
     int _send_req_id = 0;
@@ -120,7 +120,7 @@ void RtmpPusher::onConnect(const SockException &err){
             return;
         }
 
-        strong_self->sendChunkSize(60000);
+        strong_self->sendChunkSize(SERVER_CHUNK_LEN);
         strong_self->send_connect();
     });
 }
@@ -205,7 +205,7 @@ void RtmpPusher::send_metaData(){
 
     // config frame
     src->getConfigFrame([&](const RtmpPacket::Ptr &pkt) {
-        sendRtmp(pkt->type_id, _stream_index, pkt, pkt->time_stamp, pkt->chunk_id);
+        sendRtmp(pkt, _stream_index);
     });
 
     src->pause(false);
@@ -232,7 +232,7 @@ void RtmpPusher::send_metaData(){
                 pkt.append(rtmp->data(), rtmp->size());
                 strong_self->sendRequest(MSG_DATA, pkt);
             } else {
-                strong_self->sendRtmp(rtmp->type_id, strong_self->_stream_index, rtmp, rtmp->time_stamp, rtmp->chunk_id);
+                strong_self->sendRtmp(rtmp, strong_self->_stream_index);
             }
         });
     });
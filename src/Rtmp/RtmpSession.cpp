@@ -73,7 +73,7 @@ void RtmpSession::onRecv(const Buffer::Ptr &buf) {
 void RtmpSession::onCmd_connect(AMFDecoder &dec) {
     auto params = dec.load<AMFValue>();
     ///////////set chunk size////////////////
-    sendChunkSize(60000);
+    sendChunkSize(SERVER_CHUNK_LEN);
     ////////////window Acknowledgement size/////
     sendAcknowledgementSize(5000000);
     ///////////set peerBandwidth////////////////
@@ -585,7 +585,7 @@ void RtmpSession::onCmd_seek(AMFDecoder &dec) {
 }
 
 void RtmpSession::onSendMedia(const RtmpPacket::Ptr &pkt) {
-    sendRtmp(pkt->type_id, pkt->stream_index, pkt, pkt->time_stamp, pkt->chunk_id);
+    sendRtmp(pkt, pkt->stream_index);
 }
 
 bool RtmpSession::close(MediaSource &sender) {
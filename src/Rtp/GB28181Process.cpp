@@ -28,6 +28,106 @@ static inline bool checkTS(const uint8_t *packet, size_t bytes) {
     return bytes % TS_PACKET_SIZE == 0 && packet[0] == TS_SYNC_BYTE;
 }
 
+// 解析psm，获取视频流的编码类型
+static CodecId parsePSMVideoCodec(const uint8_t *psm, size_t bytes) {
+    // current_next_indicator/version(1) + marker(1) + program_stream_info_length(2)
+    if (bytes < 4) {
+        return CodecInvalid;
+    }
+    size_t pos = 4 + ((psm[2] << 8) | psm[3]);
+    if (pos + 2 > bytes) {
+        return CodecInvalid;
+    }
+    auto end = std::min(bytes, pos + 2 + ((psm[pos] << 8) | psm[pos + 1]));
+    pos += 2;
+    // stream_type(1) + elementary_stream_id(1) + elementary_stream_info_length(2)
+    while (pos + 4 <= end) {
+        auto stream_type = psm[pos];
+        auto stream_id = psm[pos + 1];
+        if (stream_id >= 0xE0 && stream_id <= 0xEF) {
+            switch (stream_type) {
+                case 0x1B: return CodecH264;
+                case 0x24: return CodecH265;
+                default: return CodecInvalid;
+            }
+        }
+        pos += 4 + ((psm[pos + 2] << 8) | psm[pos + 3]);
+    }
+    return CodecInvalid;
+}
+
+// 根据pes负载中第一个视频slice之前的nalu判断是否为关键帧
+static bool checkNaluKeyFrame(CodecId codec, const uint8_t *data, size_t bytes) {
+    for (size_t pos = 0; pos + 3 < bytes; ++pos) {
+        if (data[pos] || data[pos + 1] || data[pos + 2] != 1) {
+            continue;
+        }
+        auto nal = data[pos + 3];
+        if (codec == CodecH264) {
+            auto type = nal & 0x1F;
+            if (type == 5 || type == 7) {
+                // idr或sps
+                return true;
+            }
+            if (type >= 1 && type <= 4) {
+                // 非idr slice
+                return false;
+            }
+        } else {
+            auto type = (nal >> 1) & 0x3F;
+            if ((type >= 16 && type <= 21) || type == 32 || type == 33) {
+                // irap或vps/sps
+                return true;
+            }
+            if (type < 16) {
+                // 非irap slice
+                return false;
+            }
+        }
+        // aud、sei等，继续查找
+        pos += 3;
+    }
+    return false;
+}
+
+// 判断rtp负载是否为视频关键帧所在ps包的开始处
+// 优先根据psm中的视频编码解析pes负载中的nalu，无法解析时退化为判断pack header后是否携带system header
+static bool checkPSKeyPos(const uint8_t *payload, size_t bytes, CodecId &video_codec) {
+    // mpeg2 pack header固定14个字节，最后一个字节低3位为填充长度
+    if (bytes < 14 || memcmp(payload, "\x00\x00\x01\xBA", 4)) {
+        return false;
+    }
+    bool system_header = false;
+    size_t pos = 14 + (payload[13] & 0x07);
+    while (pos + 6 <= bytes && !payload[pos] && !payload[pos + 1] && payload[pos + 2] == 1) {
+        auto stream_id = payload[pos + 3];
+        size_t body = pos + 6;
+        size_t len = (payload[pos + 4] << 8) | payload[pos + 5];
+        if (stream_id == 0xBB) {
+            system_header = true;
+        } else if (stream_id == 0xBC) {
+            auto codec = parsePSMVideoCodec(payload + body, std::min(len, bytes - body));
+            if (codec != CodecInvalid) {
+                video_codec = codec;
+            }
+        } else if (stream_id >= 0xE0 && stream_id <= 0xEF) {
+            if (video_codec == CodecInvalid) {
+                break;
+            }
+            // pes头: flags(2) + PES_header_data_length(1)
+            if (body + 3 > bytes || body + 3 + payload[body + 2] > bytes) {
+                return false;
+            }
+            auto data = body + 3 + payload[body + 2];
+            // 视频pes长度可能为0(不限长度)
+            auto end = len ? std::min(bytes, body + len) : bytes;
+            return end > data && checkNaluKeyFrame(video_codec, payload + data, end - data);
+        }
+        pos = body + len;
+    }
+    return video_codec == CodecInvalid && system_header;
+}
+
 class RtpReceiverImp : public RtpTrackImp {
 public:
     using Ptr = std::shared_ptr<RtpReceiverImp>;
@@ -57,7 +157,15 @@ GB28181Process::GB28181Process(const MediaInfo &media_info, MediaSinkInterface *
 }
 
 void GB28181Process::onRtpSorted(RtpPacket::Ptr rtp) {
-    _rtp_decoder[rtp->getHeader()->pt]->inputRtp(rtp, false);
+    auto pt = rtp->getHeader()->pt;
+    _rtp_decoder[pt]->inputRtp(rtp, false);
+    if (_on_ps_rtp && pt == _ps_pt) {
+        _on_ps_rtp(rtp, checkPSKeyPos(rtp->getPayload(), rtp->getPayloadSize(), _ps_video_codec));
+    }
+}
+
+void GB28181Process::setOnPSRtp(onPSRtp cb) {
+    _on_ps_rtp = std::move(cb);
 }
 
 void GB28181Process::flush() {
@@ -181,6 +289,7 @@ void GB28181Process::onRtpDecode(const Frame::Ptr &frame) {
             // 猜测是ps负载
             InfoL << _media_info.stream << " judged to be PS";
             _decoder = DecoderImp::createDecoder(DecoderImp::decoder_ps, _interface);
+            _ps_pt = frame->getIndex();
         }
     }
 
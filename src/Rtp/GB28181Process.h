@@ -25,6 +25,7 @@ class RtpReceiverImp;
 class GB28181Process : public ProcessInterface {
 public:
     using Ptr = std::shared_ptr<GB28181Process>;
+    using onPSRtp = std::function<void(const RtpPacket::Ptr &rtp, bool key_pos)>;
 
     GB28181Process(const MediaInfo &media_info, MediaSinkInterface *sink);
 
@@ -41,6 +42,12 @@ public:
      */
     void flush() override;
 
+    /**
+     * 设置排序后的ps负载rtp回调，用于透传转发
+     * key_pos为true时，该rtp为关键帧所在ps包的开始处
+     */
+    void setOnPSRtp(onPSRtp cb);
+
 protected:
     void onRtpSorted(RtpPacket::Ptr rtp);
 
@@ -48,6 +55,11 @@ private:
     void onRtpDecode(const Frame::Ptr &frame);
 
 private:
+    // ps负载的pt，-1表示尚未判定为ps
+    int _ps_pt = -1;
+    // 从psm中获取的视频编码，用于判断ps包是否为关键帧
+    CodecId _ps_video_codec = CodecInvalid;
+    onPSRtp _on_ps_rtp;
     MediaInfo _media_info;
     DecoderImp::Ptr _decoder;
     MediaSinkInterface *_interface;
@@ -122,7 +122,16 @@ bool RtpProcess::inputRtp(bool is_udp, const Socket::Ptr &sock, const char *data
         fwrite((uint8_t *) data, len, 1, _save_file_rtp.get());
     }
     if (!_process) {
-        _process = std::make_shared<GB28181Process>(_media_info, this);
+        auto process = std::make_shared<GB28181Process>(_media_info, this);
+        if (_only_track == kAll) {
+            // 单track时ps包内容与复用器的track不一致，不能透传
+            process->setOnPSRtp([this](const RtpPacket::Ptr &rtp, bool key_pos) {
+                if (_muxer) {
+                    _muxer->inputPSRtp(rtp, key_pos);
+                }
+            });
+        }
+        _process = std::move(process);
     }
 
     auto header = (RtpHeader *) data;
@@ -22,6 +22,9 @@ using namespace toolkit;
 
 namespace mediakit{
 
+// ps rtp透传时，未遇到mark位也最多缓存这么多个rtp再合并写出
+static constexpr size_t kMaxPSRtpListSize = 64;
+
 RtpSender::RtpSender(EventPoller::Ptr poller) {
     _poller = poller ? std::move(poller) : EventPollerPool::Instance().getPoller();
     _socket_rtp = Socket::createSocket(_poller, false);
@@ -37,6 +40,7 @@ RtpSender::~RtpSender() {
 
 void RtpSender::startSend(const MediaSourceEvent::SendRtpArgs &args, const function<void(uint16_t local_port, const SockException &ex)> &cb){
     _args = args;
+    _ps_ssrc = atoi(args.ssrc.data());
     if (!_interface) {
         //重连时不重新创建对象
         auto lam = [this](std::shared_ptr<List<Buffer::Ptr>> list) { onFlushRtpList(std::move(list)); };
@@ -286,6 +290,7 @@ void RtpSender::resetTracks() {
 }
 
 void RtpSender::flush() {
+    flushPSRtp();
     if (_interface) {
         _interface->flush();
     }
@@ -300,6 +305,52 @@ bool RtpSender::inputFrame(const Frame::Ptr &frame) {
     return _is_connect ? _interface->inputFrame(frame) : false;
 }
 
+void RtpSender::inputPSRtp(const RtpPacket::Ptr &rtp) {
+    if (!_is_connect) {
+        // 连接成功后才做实质操作(节省cpu资源)
+        return;
+    }
+    // 原始rtp由多个发送者共享，拷贝后再改写rtp头
+    auto size = rtp->size();
+    auto out = RtpPacket::create();
+    out->setCapacity(size);
+    out->setSize(size);
+    memcpy(out->data(), rtp->data(), size);
+    out->type = rtp->type;
+    out->sample_rate = rtp->sample_rate;
+    out->ntp_stamp = rtp->ntp_stamp;
+
+    auto header = out->getHeader();
+    auto stamp = ntohl(header->stamp);
+    auto seq = ntohs(header->seq);
+    if (!_ps_offset_inited) {
+        // seq和时间戳从0开始，与复用模式保持一致；之后按固定偏移改写，保留源丢包造成的seq空洞，便于对端发现丢包
+        _ps_offset_inited = true;
+        _ps_seq_offset = (uint16_t)(0 - seq);
+        _ps_stamp_offset = stamp;
+    }
+    auto mark = header->mark;
+    header->pt = _args.pt;
+    header->seq = htons((uint16_t)(seq + _ps_seq_offset));
+    header->stamp = htonl(stamp - _ps_stamp_offset);
+    header->ssrc = htonl(_ps_ssrc);
+
+    if (!_ps_rtp_list) {
+        _ps_rtp_list = std::make_shared<List<Buffer::Ptr> >();
+    }
+    _ps_rtp_list->emplace_back(std::move(out));
+    if (mark || _ps_rtp_list->size() >= kMaxPSRtpListSize) {
+        // 一帧结束或者缓存太多时合并写出
+        flushPSRtp();
+    }
+}
+
+void RtpSender::flushPSRtp() {
+    if (_ps_rtp_list && !_ps_rtp_list->empty()) {
+        onFlushRtpList(std::move(_ps_rtp_list));
+    }
+}
+
 void RtpSender::onSendRtpUdp(const toolkit::Buffer::Ptr &buf, bool check) {
     if (!_socket_rtcp) {
         return;
@@ -345,13 +396,27 @@ void RtpSender::onFlushRtpList(shared_ptr<List<Buffer::Ptr>> rtp_list) {
 
     size_t i = 0;
     auto size = rtp_list->size();
+    switch (_args.con_type) {
+        case MediaSourceEvent::SendRtpArgs::kUdpActive:
+        case MediaSourceEvent::SendRtpArgs::kUdpPassive: {
+            if (!_udp_batch_sender || _udp_batch_sender->getSock() != _socket_rtp) {
+                _udp_batch_sender = std::make_shared<UdpBatchSender>(_socket_rtp);
+            }
+            break;
+        }
+        default: break;
+    }
     rtp_list->for_each([&](Buffer::Ptr &packet) {
         switch (_args.con_type) {
             case MediaSourceEvent::SendRtpArgs::kUdpActive:
             case MediaSourceEvent::SendRtpArgs::kUdpPassive: {
-                onSendRtpUdp(packet, i == 0);
+                onSendRtpUdp(packet, i++ == 0);
                 // udp模式，rtp over tcp前4个字节可以忽略
-                _socket_rtp->send(std::make_shared<BufferRtp>(std::move(packet), RtpPacket::kRtpTcpHeaderSize), nullptr, 0, ++i == size);
+                _udp_batch_sender->input(std::make_shared<BufferRtp>(std::move(packet), RtpPacket::kRtpTcpHeaderSize));
+                if (i == size) {
+                    // 一次flush的rtp包批量发送
+                    _udp_batch_sender->flush();
+                }
                 break;
             }
             case MediaSourceEvent::SendRtpArgs::kTcpActive:
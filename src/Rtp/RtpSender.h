@@ -16,6 +16,7 @@
 #include "Rtcp/RtcpContext.h"
 #include "Common/MediaSource.h"
 #include "Common/MediaSink.h"
+#include "Common/UdpBatchSender.h"
 
 namespace mediakit{
 
@@ -41,6 +42,12 @@ public:
      */
     bool inputFrame(const Frame::Ptr &frame) override;
 
+    /**
+     * 透传输入ps负载的rtp，只改写ssrc、seq、时间戳和pt，不经过解复用与复用
+     * @param rtp 排序后的原始rtp，可能被多个发送者共享，不会被修改
+     */
+    void inputPSRtp(const RtpPacket::Ptr &rtp);
+
     /**
      * 刷新输出frame缓存
      */
@@ -79,12 +86,20 @@ private:
     void onRecvRtcp(RtcpHeader *rtcp);
     void onSendRtpUdp(const toolkit::Buffer::Ptr &buf, bool check);
     void onClose(const toolkit::SockException &ex);
+    void flushPSRtp();
 
 private:
     bool _is_connect = false;
+    // ps rtp透传时的改写状态
+    bool _ps_offset_inited = false;
+    uint16_t _ps_seq_offset = 0;
+    uint32_t _ps_ssrc = 0;
+    uint32_t _ps_stamp_offset = 0;
+    std::shared_ptr<toolkit::List<toolkit::Buffer::Ptr> > _ps_rtp_list;
     MediaSourceEvent::SendRtpArgs _args;
     toolkit::Socket::Ptr _socket_rtp;
     toolkit::Socket::Ptr _socket_rtcp;
+    UdpBatchSender::Ptr _udp_batch_sender;
     toolkit::EventPoller::Ptr _poller;
     MediaSinkInterface::Ptr _interface;
     std::shared_ptr<RtcpContext> _rtcp_context;
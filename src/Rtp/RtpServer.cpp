@@ -12,6 +12,7 @@
 #include "Util/uv_errno.h"
 #include "RtpServer.h"
 #include "RtpProcess.h"
+#include "RtpUdpSteering.h"
 #include "Rtcp/RtcpContext.h"
 #include "Common/config.h"
 
@@ -178,8 +179,20 @@ void RtpServer::start(uint16_t local_port, const char *local_ip, const MediaTupl
         (*udp_server)[RtpSession::kUdpRecvBuffer] = udpRecvSocketBuffer;
         (*udp_server)[RtpSession::kVhost] = tuple.vhost;
         (*udp_server)[RtpSession::kApp] = tuple.app;
+        GET_CONFIG(bool, udp_steering, RtpProxy::kUdpSteering);
+        if (udp_steering) {
+            //数据已按ssrc分发到固定poller的socket，rtp会话及RtpProcess直接创建在收包poller上
+            udp_server->setOnCreateSocket([](const EventPoller::Ptr &poller, const Buffer::Ptr &buf, struct sockaddr *, int) {
+                auto recv_poller = buf ? EventPoller::getCurrentPoller() : nullptr;
+                return Socket::createSocket(recv_poller ? recv_poller : poller, false);
+            });
+        }
         udp_server->start<RtpSession>(local_port, local_ip);
         rtp_socket = nullptr;
+        if (udp_steering) {
+            //按ssrc分发到各poller的监听socket
+            RtpUdpSteering::start(udp_server->getPort(), local_ip);
+        }
     }
 
     TcpServer::Ptr tcp_server;
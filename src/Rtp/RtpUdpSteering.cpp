@@ -0,0 +1,98 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "RtpUdpSteering.h"
+#include "Util/logger.h"
+#include "Poller/EventPoller.h"
+#include "Common/ReuseportFilter.h"
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <linux/filter.h>
+#endif
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+constexpr size_t RtpUdpSteering::kSSRCOffset;
+
+// 乘法hash，国标ssrc多为连续的十进制数，直接取模也较均匀，乘法hash可以兼顾其他规律的ssrc
+static constexpr uint32_t kHashMultiplier = 2654435761U;
+
+size_t RtpUdpSteering::ssrcToIndex(uint32_t ssrc, size_t count) {
+    return ((uint32_t)(ssrc * kHashMultiplier) >> 16) % count;
+}
+
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+
+/**
+ * reuseport cbpf程序，输入为udp负载，返回值为组内socket下标，越界时内核回退到hash分发
+ * 只处理rtp version为2且不是rtcp的数据包
+ */
+static ReuseportFilter makeFilter(size_t count) {
+    // 跳转目标
+    enum { kLoadSSRC = 9, kFallback = 14 };
+    ReuseportFilter ret;
+    // 越界读取会直接返回0，必须先检查长度
+    ret.stmt(BPF_LD | BPF_W | BPF_LEN, 0);
+    ret.jump(BPF_JMP | BPF_JGE | BPF_K, RtpUdpSteering::kSSRCOffset + 4, -1, kFallback);
+    // rtp version
+    ret.stmt(BPF_LD | BPF_B | BPF_ABS, 0);
+    ret.stmt(BPF_ALU | BPF_AND | BPF_K, 0xC0);
+    ret.jump(BPF_JMP | BPF_JEQ | BPF_K, 0x80, -1, kFallback);
+    // 去除marker位后，rtcp(pt 200~204)在72~76之间
+    ret.stmt(BPF_LD | BPF_B | BPF_ABS, 1);
+    ret.stmt(BPF_ALU | BPF_AND | BPF_K, 0x7F);
+    ret.jump(BPF_JMP | BPF_JGE | BPF_K, 72, -1, kLoadSSRC);
+    ret.jump(BPF_JMP | BPF_JGT | BPF_K, 76, -1, kFallback);
+    // kLoadSSRC
+    ret.stmt(BPF_LD | BPF_W | BPF_ABS, RtpUdpSteering::kSSRCOffset);
+    ret.stmt(BPF_ALU | BPF_MUL | BPF_K, kHashMultiplier);
+    ret.stmt(BPF_ALU | BPF_RSH | BPF_K, 16);
+    ret.stmt(BPF_ALU | BPF_MOD | BPF_K, (uint32_t)count);
+    ret.stmt(BPF_RET | BPF_A, 0);
+    // kFallback
+    ret.stmt(BPF_RET | BPF_K, 0xFFFFFFFF);
+    return ret;
+}
+
+bool RtpUdpSteering::attachFilter(int fd, size_t count) {
+    return makeFilter(count).attach(fd);
+}
+
+bool RtpUdpSteering::start(uint16_t port, const string &local_ip) {
+    auto count = EventPollerPool::Instance().getExecutorSize();
+    if (count < 2) {
+        return false;
+    }
+    // 组内前count个socket为各poller上的监听socket，之后创建的rtp会话socket下标都大于等于count，不会被选中
+    auto attached = makeFilter(count).attach(port, local_ip);
+    if (attached) {
+        InfoL << "Rtp udp steering enabled, port: " << port << ", socket count: " << count;
+    }
+    return attached;
+}
+
+#else
+
+bool RtpUdpSteering::attachFilter(int fd, size_t count) {
+    return false;
+}
+
+bool RtpUdpSteering::start(uint16_t port, const string &local_ip) {
+    WarnL << "Rtp udp steering is only supported on linux";
+    return false;
+}
+
+#endif // defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+
+} // namespace mediakit
@@ -0,0 +1,57 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_RTPUDPSTEERING_H
+#define ZLMEDIAKIT_RTPUDPSTEERING_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace mediakit {
+
+/**
+ * 单端口(多路复用)udp rtp服务器在每个poller线程上都有一个SO_REUSEPORT socket，
+ * 默认由内核按四元组hash选择socket，与rtp会话所在poller无关，首包需要跨线程切换，且多个设备经同一nat出口时负载不均。
+ * 开启后在reuseport组上挂载cbpf程序，读取rtp头中的ssrc并按hash分发，
+ * 同一ssrc的数据包总是落在同一个poller，rtp会话及RtpProcess直接创建在收包poller上，不能识别的数据包仍按四元组hash分发
+ */
+class RtpUdpSteering {
+public:
+    // ssrc在rtp头中的偏移
+    static constexpr size_t kSSRCOffset = 8;
+
+    /**
+     * 计算ssrc对应的socket下标，与cbpf程序的计算方式一致
+     * @param ssrc rtp ssrc
+     * @param count 参与分发的socket个数
+     */
+    static size_t ssrcToIndex(uint32_t ssrc, size_t count);
+
+    /**
+     * 在fd所在的reuseport组上挂载分发程序
+     * @param fd 已绑定端口的SO_REUSEPORT udp socket
+     * @param count 参与分发的socket个数，即组内前count个socket
+     * @return 是否成功
+     */
+    static bool attachFilter(int fd, size_t count);
+
+    /**
+     * 单端口udp rtp服务器启动后调用，在该端口上挂载分发程序
+     * @param port rtp udp端口
+     * @param local_ip 监听ip
+     * @return 是否开启成功
+     */
+    static bool start(uint16_t port, const std::string &local_ip);
+};
+
+} // namespace mediakit
+
+#endif // ZLMEDIAKIT_RTPUDPSTEERING_H
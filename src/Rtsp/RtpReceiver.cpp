@@ -26,7 +26,7 @@ uint32_t RtpTrack::getSSRC() const {
 void RtpTrack::clear() {
     _ssrc = 0;
     _ssrc_alive.resetTime();
-    PacketSortor<RtpPacket::Ptr>::clear();
+    Sortor::clear();
 }
 
 RtpPacket::Ptr RtpTrack::inputRtp(TrackType type, int sample_rate, uint8_t *ptr, size_t len) {
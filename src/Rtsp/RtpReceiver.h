@@ -14,6 +14,9 @@
 #include <map>
 #include <string>
 #include <memory>
+#include <vector>
+#include <limits>
+#include <algorithm>
 #include "Rtsp/Rtsp.h"
 #include "Extension/Frame.h"
 // for NtpStamp
@@ -22,11 +25,212 @@
 
 namespace mediakit {
 
-template<typename T, typename SEQ = uint16_t>
+/**
+ * 以seq为下标的定长环形缓存，实现了PacketSortor所需的std::map子集接口(按seq数值升序遍历)
+ * seq取模后槽位冲突的包存放在溢出map中，所以行为与std::map完全一致
+ * 插入删除为O(1)，lower_bound只需顺序扫描相邻槽位，避免了std::map每个包一次的节点分配与树平衡开销
+ */
+template<typename SEQ, typename T>
+class SeqRingMap {
+public:
+    static constexpr SEQ SEQ_MAX = (std::numeric_limits<SEQ>::max)();
+    // 默认槽位个数，需为2的幂，覆盖默认的max_distance(256)
+    static constexpr size_t kDefaultCapacity = 512;
+    using value_type = std::pair<SEQ, T>;
+
+    class iterator {
+    public:
+        iterator() = default;
+        iterator(SeqRingMap *owner, value_type *ptr) : _owner(owner), _ptr(ptr) {}
+
+        value_type &operator*() const { return *_ptr; }
+        value_type *operator->() const { return _ptr; }
+        bool operator==(const iterator &that) const { return _ptr == that._ptr; }
+        bool operator!=(const iterator &that) const { return _ptr != that._ptr; }
+        iterator &operator++() {
+            _ptr = _owner->next(_ptr->first);
+            return *this;
+        }
+
+    private:
+        friend class SeqRingMap;
+        SeqRingMap *_owner = nullptr;
+        value_type *_ptr = nullptr;
+    };
+
+    explicit SeqRingMap(size_t capacity = kDefaultCapacity) {
+        size_t size = 16;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _mask = size - 1;
+    }
+
+    SeqRingMap(SeqRingMap &&that) { *this = std::move(that); }
+
+    SeqRingMap &operator=(SeqRingMap &&that) {
+        if (this == &that) {
+            return *this;
+        }
+        _mask = that._mask;
+        _ring_size = that._ring_size;
+        _ring_min = that._ring_min;
+        _ring_max = that._ring_max;
+        _slots = std::move(that._slots);
+        _used = std::move(that._used);
+        _overflow = std::move(that._overflow);
+        // 与std::map一致，被移动后为空
+        that._slots.clear();
+        that._used.clear();
+        that._overflow.clear();
+        that._ring_size = 0;
+        that._ring_min = 0;
+        that._ring_max = 0;
+        return *this;
+    }
+
+    size_t size() const { return _ring_size + _overflow.size(); }
+    bool empty() const { return size() == 0; }
+
+    void clear() {
+        if (_ring_size) {
+            for (size_t i = 0; i < _used.size(); ++i) {
+                if (_used[i]) {
+                    _used[i] = 0;
+                    _slots[i].second = T();
+                }
+            }
+            _ring_size = 0;
+            _ring_min = 0;
+            _ring_max = 0;
+        }
+        _overflow.clear();
+    }
+
+    iterator begin() { return iterator(this, findGreaterEqual(0)); }
+    iterator end() { return iterator(this, nullptr); }
+    iterator lower_bound(SEQ seq) { return iterator(this, findGreaterEqual(seq)); }
+
+    /**
+     * 与std::map::emplace一致，seq已存在时忽略
+     */
+    void emplace(SEQ seq, T value) {
+        if (_slots.empty()) {
+            // 按需分配，未出现乱序的流不占用内存
+            _slots.resize(_mask + 1);
+            _used.resize(_mask + 1);
+        }
+        auto index = seq & _mask;
+        auto &slot = _slots[index];
+        if (_used[index]) {
+            if (slot.first != seq) {
+                // 槽位冲突，存放至溢出map
+                _overflow.emplace(seq, value_type(seq, std::move(value)));
+            }
+            return;
+        }
+        if (!_overflow.empty() && _overflow.find(seq) != _overflow.end()) {
+            return;
+        }
+        slot.first = seq;
+        slot.second = std::move(value);
+        _used[index] = 1;
+        if (!_ring_size++) {
+            _ring_min = _ring_max = seq;
+        } else if (seq < _ring_min) {
+            _ring_min = seq;
+        } else if (seq > _ring_max) {
+            _ring_max = seq;
+        }
+    }
+
+    iterator erase(iterator it) {
+        auto seq = it->first;
+        remove(it._ptr);
+        return iterator(this, next(seq));
+    }
+
+    iterator erase(iterator first, iterator last) {
+        while (first != last) {
+            first = erase(first);
+        }
+        return last;
+    }
+
+private:
+    void remove(value_type *ptr) {
+        if (!_slots.empty() && ptr >= _slots.data() && ptr < _slots.data() + _slots.size()) {
+            _used[ptr - _slots.data()] = 0;
+            ptr->second = T();
+            if (!--_ring_size) {
+                _ring_min = _ring_max = 0;
+            } else if (ptr->first == _ring_min) {
+                // 收缩上下界，保证按序出队时扫描区间最小
+                ++_ring_min;
+            } else if (ptr->first == _ring_max) {
+                --_ring_max;
+            }
+            return;
+        }
+        _overflow.erase(ptr->first);
+    }
+
+    value_type *next(SEQ seq) { return seq == SEQ_MAX ? nullptr : findGreaterEqual(static_cast<SEQ>(seq + 1)); }
+
+    // 查找seq数值不小于key的最小元素
+    value_type *findGreaterEqual(SEQ key) {
+        value_type *ret = nullptr;
+        if (_ring_size && key <= _ring_max) {
+            // [_ring_min, _ring_max]为环形区seq的上下界(可能比实际范围宽)
+            auto start = (std::max)(key, _ring_min);
+            size_t span = static_cast<size_t>(_ring_max - start) + 1;
+            if (span <= _slots.size()) {
+                // 区间小于槽位数，按seq顺序扫描，命中的第一个即为最小值
+                for (size_t i = 0; i < span; ++i) {
+                    auto seq = static_cast<SEQ>(start + i);
+                    auto index = seq & _mask;
+                    if (_used[index] && _slots[index].first == seq) {
+                        ret = &_slots[index];
+                        break;
+                    }
+                }
+            } else {
+                // 区间过大(seq回环)，遍历全部槽位
+                for (size_t i = 0; i < _slots.size(); ++i) {
+                    if (_used[i] && _slots[i].first >= key && (!ret || _slots[i].first < ret->first)) {
+                        ret = &_slots[i];
+                    }
+                }
+            }
+        }
+        if (!_overflow.empty()) {
+            auto it = _overflow.lower_bound(key);
+            if (it != _overflow.end() && (!ret || it->first < ret->first)) {
+                ret = &it->second;
+            }
+        }
+        return ret;
+    }
+
+private:
+    size_t _mask;
+    size_t _ring_size = 0;
+    SEQ _ring_min = 0;
+    SEQ _ring_max = 0;
+    std::vector<value_type> _slots;
+    std::vector<uint8_t> _used;
+    std::map<SEQ, value_type> _overflow;
+};
+
+/**
+ * rtp排序器
+ * @tparam CACHE 排序缓存容器，默认为std::map，可选SeqRingMap
+ */
+template<typename T, typename SEQ = uint16_t, typename CACHE = std::map<SEQ, T>>
 class PacketSortor {
 public:
     static constexpr SEQ SEQ_MAX = (std::numeric_limits<SEQ>::max)();
-    using iterator = typename std::map<SEQ, T>::iterator;
+    using iterator = typename CACHE::iterator;
 
     virtual ~PacketSortor() = default;
 
@@ -72,9 +276,12 @@ public:
             _pkt_drop_cache_map.emplace(seq, std::move(packet));
             if (_pkt_drop_cache_map.size() > _max_distance || _ticker.elapsedTime() > _max_buffer_ms) {
                 // seq回退包太多，可能源端重置seq计数器，这部分数据需要输出
+                // forceFlush会清空预丢弃包列表，需提前取出
+                auto drop_cache = std::move(_pkt_drop_cache_map);
+                _pkt_drop_cache_map.clear();
                 forceFlush(next_seq);
                 // 旧的seq计数器的数据清空后把新seq计数器的数据赋值给排序列队
-                _pkt_sort_cache_map = std::move(_pkt_drop_cache_map);
+                _pkt_sort_cache_map = std::move(drop_cache);
                 popIterator(_pkt_sort_cache_map.begin());
             }
             return;
@@ -201,15 +408,17 @@ private:
     // 下次应该输出的SEQ
     SEQ _last_seq_out = 0;
     // pkt排序缓存，根据seq排序
-    std::map<SEQ, T> _pkt_sort_cache_map;
+    CACHE _pkt_sort_cache_map;
     // 预丢弃包列表
-    std::map<SEQ, T> _pkt_drop_cache_map;
+    CACHE _pkt_drop_cache_map;
     // 回调
     std::function<void(SEQ seq, T packet)> _cb;
 };
 
-class RtpTrack : public PacketSortor<RtpPacket::Ptr> {
+class RtpTrack : public PacketSortor<RtpPacket::Ptr, uint16_t, SeqRingMap<uint16_t, RtpPacket::Ptr>> {
 public:
+    using Sortor = PacketSortor<RtpPacket::Ptr, uint16_t, SeqRingMap<uint16_t, RtpPacket::Ptr>>;
+
     class BadRtpException : public std::invalid_argument {
     public:
         template<typename Type>
@@ -78,6 +78,13 @@ public:
         return _ring ? _ring->readerCount() : 0;
     }
 
+    /**
+     * 获取gop缓存占用的字节数
+     */
+    size_t getCacheBytes() const override {
+        return _cache_bytes;
+    }
+
     /**
      * 获取该源的sdp
      */
@@ -138,6 +145,7 @@ public:
     void clearCache() override{
         PacketCache<RtpPacket>::clearCache();
         _ring->clearCache();
+        _cache_bytes = 0;
     }
 
 private:
@@ -148,7 +156,9 @@ private:
      */
     void onFlush(std::shared_ptr<toolkit::List<RtpPacket::Ptr> > rtp_list, bool key_pos) override {
         //如果不存在视频，那么就没有存在GOP缓存的意义，所以is_key一直为true确保一直清空GOP缓存
-        _ring->write(std::move(rtp_list), _have_video ? key_pos : true);
+        key_pos = _have_video ? key_pos : true;
+        updateCacheBytes(*rtp_list, key_pos);
+        _ring->write(std::move(rtp_list), key_pos);
     }
 
 private:
@@ -11,8 +11,10 @@
 #ifndef ZLMEDIAKIT_RTSPMEDIASOURCEMUXER_H
 #define ZLMEDIAKIT_RTSPMEDIASOURCEMUXER_H
 
+#include <atomic>
 #include "RtspMuxer.h"
 #include "Rtsp/RtspMediaSource.h"
+#include "Common/FrameGopCache.h"
 
 namespace mediakit {
 
@@ -42,6 +44,13 @@ public:
         _media_src->setListener(shared_from_this());
     }
 
+    /**
+     * 设置帧级gop缓存，按需转协议无人观看后重新有人观看时，从该缓存补齐当前gop
+     */
+    void setGopCache(const FrameGopCache::Ptr &cache) {
+        _gop_replayer.setGopCache(cache);
+    }
+
     int readerCount() const{
         return _media_src->readerCount();
     }
@@ -64,13 +73,14 @@ public:
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
-        if (_clear_cache && _option.rtsp_demand) {
-            _clear_cache = false;
+        if (_option.rtsp_demand && _clear_cache.exchange(false)) {
             _media_src->clearCache();
         }
         if (_enabled || !_option.rtsp_demand) {
+            _gop_replayer.onInput(frame, [this](const Frame::Ptr &cached) { RtspMuxer::inputFrame(cached); });
             return RtspMuxer::inputFrame(frame);
         }
+        _gop_replayer.onSkip();
         return false;
     }
 
@@ -80,9 +90,11 @@ public:
     }
 
 private:
-    bool _enabled = true;
-    bool _clear_cache = false;
+    // 开启多线程复用时，由归属线程修改，复用器线程读取
+    std::atomic<bool> _enabled { true };
+    std::atomic<bool> _clear_cache { false };
     ProtocolOption _option;
+    FrameGopReplayer _gop_replayer;
     RtspMediaSource::Ptr _media_src;
 };
 
@@ -1241,24 +1241,25 @@ void RtspSession::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
             break;
         case Rtsp::RTP_UDP: {
             //下标0表示视频，1表示音频
-            Socket::Ptr rtp_socks[2];
-            rtp_socks[TrackVideo] = _rtp_socks[getTrackIndexByTrackType(TrackVideo)];
-            rtp_socks[TrackAudio] = _rtp_socks[getTrackIndexByTrackType(TrackAudio)];
+            UdpBatchSender *rtp_senders[2];
+            rtp_senders[TrackVideo] = getRtpBatchSender(getTrackIndexByTrackType(TrackVideo));
+            rtp_senders[TrackAudio] = getRtpBatchSender(getTrackIndexByTrackType(TrackAudio));
             pkt->for_each([&](const RtpPacket::Ptr &rtp) {
                 if (_target_play_track == TrackInvalid || _target_play_track == rtp->type) {
                     updateRtcpContext(rtp);
-                    auto &sock = rtp_socks[rtp->type];
-                    if (!sock) {
+                    auto sender = rtp_senders[rtp->type];
+                    if (!sender) {
                         shutdown(SockException(Err_shutdown, "udp sock not opened yet"));
                         return;
                     }
                     _bytes_usage += rtp->size() - RtpPacket::kRtpTcpHeaderSize;
-                    sock->send(std::make_shared<BufferRtp>(rtp, RtpPacket::kRtpTcpHeaderSize), nullptr, 0, false);
+                    sender->input(std::make_shared<BufferRtp>(rtp, RtpPacket::kRtpTcpHeaderSize));
                 }
             });
-            for (auto &sock : rtp_socks) {
-                if (sock) {
-                    sock->flushAll();
+            //一次flush的rtp包批量发送
+            for (auto &sender : rtp_senders) {
+                if (sender) {
+                    sender->flush();
                 }
             }
         }
@@ -1268,6 +1269,17 @@ void RtspSession::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
     }
 }
 
+UdpBatchSender *RtspSession::getRtpBatchSender(int track_idx) {
+    if (track_idx < 0 || track_idx >= 2 || !_rtp_socks[track_idx]) {
+        return nullptr;
+    }
+    auto &sender = _rtp_batch_senders[track_idx];
+    if (!sender || sender->getSock() != _rtp_socks[track_idx]) {
+        sender = std::make_shared<UdpBatchSender>(_rtp_socks[track_idx]);
+    }
+    return sender.get();
+}
+
 void RtspSession::setSocketFlags(){
     GET_CONFIG(int, mergeWriteMS, General::kMergeWriteMS);
     if(mergeWriteMS > 0) {
@@ -21,6 +21,7 @@
 #include "RtspMediaSource.h"
 #include "RtspMediaSourceImp.h"
 #include "RtpMultiCaster.h"
+#include "Common/UdpBatchSender.h"
 
 namespace mediakit {
 
@@ -143,6 +144,8 @@ private:
     void emitOnPlay();
     //发送rtp给客户端
     void sendRtpPacket(const RtspMediaSource::RingDataType &pkt);
+    //获取udp方式下某track的rtp批量发送器
+    UdpBatchSender *getRtpBatchSender(int track_idx);
     //触发rtcp发送
     void updateRtcpContext(const RtpPacket::Ptr &rtp);
     //回复客户端
@@ -190,6 +193,8 @@ private:
     toolkit::Socket::Ptr _rtp_socks[2];
     //RTCP端口,trackid idx 为数组下标
     toolkit::Socket::Ptr _rtcp_socks[2];
+    //RTP批量发送器,trackid idx 为数组下标
+    UdpBatchSender::Ptr _rtp_batch_senders[2];
     //标记是否收到播放的udp打洞包,收到播放的udp打洞包后才能知道其外网udp端口号
     std::unordered_set<int> _udp_connected_flags;
     ////////RTSP over HTTP  ////////
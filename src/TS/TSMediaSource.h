@@ -67,6 +67,13 @@ public:
         return _ring ? _ring->readerCount() : 0;
     }
 
+    /**
+     * 获取gop缓存占用的字节数
+     */
+    size_t getCacheBytes() const override {
+        return _cache_bytes;
+    }
+
     /**
      * 输入TS包
      * @param packet TS包
@@ -90,6 +97,7 @@ public:
     void clearCache() override {
         PacketCache<TSPacket>::clearCache();
         _ring->clearCache();
+        _cache_bytes = 0;
     }
 
 private:
@@ -113,7 +121,9 @@ private:
      */
     void onFlush(std::shared_ptr<toolkit::List<TSPacket::Ptr> > packet_list, bool key_pos) override {
         //如果不存在视频，那么就没有存在GOP缓存的意义，所以确保一直清空GOP缓存
-        _ring->write(std::move(packet_list), _have_video ? key_pos : true);
+        key_pos = _have_video ? key_pos : true;
+        updateCacheBytes(*packet_list, key_pos);
+        _ring->write(std::move(packet_list), key_pos);
     }
 
 private:
@@ -0,0 +1,161 @@
+﻿#include "Util/util.h"
+#include "Common/config.h"
+#include "LiveCC.hpp"
+#include "SrtTransport.hpp"
+
+using namespace std;
+using namespace toolkit;
+
+namespace SRT {
+
+// 平滑发送定时器间隔
+static constexpr uint64_t kPacerIntervalMS = 2;
+// 最多允许的突发时长
+static constexpr uint64_t kPacerMaxBurstMS = 10;
+
+LiveCC::LiveCC(EventPoller::Ptr poller, onSendCB cb)
+    : _input_rate(SteadyClock::now()) {
+    _poller = std::move(poller);
+    _cb = std::move(cb);
+}
+
+void LiveCC::setMaxQueueDelay(uint32_t ms) {
+    _max_queue_ms = max<uint32_t>(ms, kPacerIntervalMS);
+}
+
+uint64_t LiveCC::getInputRate() const {
+    return _input_rate.getInputRate();
+}
+
+uint64_t LiveCC::getSendRate() const {
+    GET_CONFIG(int64_t, max_bw, kMaxBandwidth);
+    GET_CONFIG(uint32_t, overhead, kOverheadBandwidth);
+    if (max_bw > 0) {
+        return max_bw;
+    }
+    if (max_bw < 0) {
+        return 0;
+    }
+    // 输入码率未采样完成前不限速
+    return getInputRate() * (100 + overhead) / 100;
+}
+
+size_t LiveCC::getQueueBytes() const {
+    return _queue_bytes;
+}
+
+const LiveCC::Item &LiveCC::front() const {
+    if (_retrans_queue.empty()) {
+        return _queue.front();
+    }
+    if (_queue.empty() || _retrans_queue.front().enqueue_us < _queue.front().enqueue_us) {
+        return _retrans_queue.front();
+    }
+    return _queue.front();
+}
+
+uint64_t LiveCC::getQueueDelayMS() const {
+    if (empty()) {
+        return 0;
+    }
+    return (getCurrentMicrosecond() - front().enqueue_us) / 1000;
+}
+
+void LiveCC::inputPacket(Buffer::Ptr pkt, bool flush) {
+    auto now = SteadyClock::now();
+    _input_rate.inputPacket(now, pkt->size() + UDP_HDR_SIZE);
+    input(Item { std::move(pkt), flush, false, 0 });
+}
+
+void LiveCC::inputRetransmit(Buffer::Ptr pkt, bool flush) {
+    input(Item { std::move(pkt), flush, true, 0 });
+}
+
+void LiveCC::refillBudget(uint64_t now_us) {
+    if (!_last_refill_us) {
+        _last_refill_us = now_us;
+    }
+    auto elapsed_us = now_us - _last_refill_us;
+    _last_refill_us = now_us;
+
+    double rate = getSendRate();
+    if (!empty()) {
+        // 排队过久时提高发送速度，确保队列在最大排队时长内发送完毕
+        auto wait_us = now_us - front().enqueue_us;
+        auto remain_us = max<int64_t>((int64_t)_max_queue_ms * 1000 - (int64_t)wait_us, kPacerIntervalMS * 1000);
+        rate = max(rate, _queue_bytes * 1000.0 * 1000 / remain_us);
+    }
+    _budget += (int64_t)(rate * elapsed_us / 1000 / 1000);
+    _budget = min(_budget, (int64_t)(rate * kPacerMaxBurstMS / 1000));
+}
+
+void LiveCC::send(Item &item, bool flush) {
+    auto bytes = item.pkt->size() + UDP_HDR_SIZE;
+    _budget -= bytes;
+    if (item.retransmit) {
+        ++_retrans_pkts;
+        _retrans_bytes += bytes;
+    }
+    ++_send_pkts;
+    _send_bytes += bytes;
+    _cb(std::move(item.pkt), flush);
+}
+
+void LiveCC::input(Item item) {
+    auto now_us = getCurrentMicrosecond();
+    if (empty()) {
+        if (!getSendRate()) {
+            // 不限速
+            send(item, item.flush);
+            return;
+        }
+        refillBudget(now_us);
+        if (_budget > 0) {
+            send(item, item.flush);
+            return;
+        }
+    }
+    item.enqueue_us = now_us;
+    _queue_bytes += item.pkt->size();
+    if (item.retransmit) {
+        _retrans_queue.emplace_back(std::move(item));
+    } else {
+        _queue.emplace_back(std::move(item));
+    }
+    startTimer();
+}
+
+void LiveCC::startTimer() {
+    if (_timer_started) {
+        return;
+    }
+    _timer_started = true;
+    weak_ptr<LiveCC> weak_self = shared_from_this();
+    _poller->doDelayTask(kPacerIntervalMS, [weak_self]() -> uint64_t {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return 0;
+        }
+        return strong_self->onTimer();
+    });
+}
+
+uint64_t LiveCC::onTimer() {
+    refillBudget(getCurrentMicrosecond());
+    while (!empty() && _budget > 0) {
+        // 重传包优先
+        auto &queue = _retrans_queue.empty() ? _queue : _retrans_queue;
+        auto item = std::move(queue.front());
+        queue.pop_front();
+        _queue_bytes -= item.pkt->size();
+        // 本轮最后一个包flush socket
+        send(item, empty() || _budget - (int64_t)(item.pkt->size() + UDP_HDR_SIZE) <= 0);
+    }
+    if (empty()) {
+        _timer_started = false;
+        return 0;
+    }
+    return kPacerIntervalMS;
+}
+
+} // namespace SRT
\ No newline at end of file
@@ -0,0 +1,90 @@
+﻿#ifndef ZLMEDIAKIT_SRT_LIVE_CC_H
+#define ZLMEDIAKIT_SRT_LIVE_CC_H
+
+#include <deque>
+#include <memory>
+#include <functional>
+#include "Poller/EventPoller.h"
+#include "Statistic.hpp"
+
+namespace SRT {
+
+/**
+ * 发送端直播拥塞控制，参考libsrt的LiveCC
+ * 发送带宽为srt.maxBandwidth，为0时根据输入码率与srt.overheadBandwidth计算，
+ * 数据包按该带宽平滑发送，避免关键帧突发；重传包优先发送，与数据包共享发送带宽
+ * 该对象只能在所属poller线程访问
+ */
+class LiveCC : public std::enable_shared_from_this<LiveCC> {
+public:
+    using Ptr = std::shared_ptr<LiveCC>;
+    using onSendCB = std::function<void(toolkit::Buffer::Ptr pkt, bool flush)>;
+
+    LiveCC(toolkit::EventPoller::Ptr poller, onSendCB cb);
+
+    /**
+     * 设置最大排队时长，排队超过该时长后加速发送，单位毫秒
+     * 一般为srt延时的一半，防止排队过久导致接收端丢弃
+     */
+    void setMaxQueueDelay(uint32_t ms);
+
+    /**
+     * 发送数据包
+     */
+    void inputPacket(toolkit::Buffer::Ptr pkt, bool flush);
+
+    /**
+     * 发送重传包
+     */
+    void inputRetransmit(toolkit::Buffer::Ptr pkt, bool flush);
+
+    // 输入码率，单位字节/秒
+    uint64_t getInputRate() const;
+    // 当前发送带宽，单位字节/秒，0表示不限速
+    uint64_t getSendRate() const;
+    // 排队中的字节数
+    size_t getQueueBytes() const;
+    // 队首包的排队时长，单位毫秒
+    uint64_t getQueueDelayMS() const;
+
+    uint64_t getSendPackets() const { return _send_pkts; }
+    uint64_t getSendBytes() const { return _send_bytes; }
+    uint64_t getRetransmitPackets() const { return _retrans_pkts; }
+    uint64_t getRetransmitBytes() const { return _retrans_bytes; }
+
+private:
+    struct Item {
+        toolkit::Buffer::Ptr pkt;
+        bool flush;
+        bool retransmit;
+        uint64_t enqueue_us;
+    };
+
+    void input(Item item);
+    void send(Item &item, bool flush);
+    void refillBudget(uint64_t now_us);
+    void startTimer();
+    uint64_t onTimer();
+    bool empty() const { return _queue.empty() && _retrans_queue.empty(); }
+    const Item &front() const;
+
+private:
+    bool _timer_started = false;
+    uint32_t _max_queue_ms = 60;
+    int64_t _budget = 0;
+    uint64_t _last_refill_us = 0;
+    size_t _queue_bytes = 0;
+    uint64_t _send_pkts = 0;
+    uint64_t _send_bytes = 0;
+    uint64_t _retrans_pkts = 0;
+    uint64_t _retrans_bytes = 0;
+    InputRateContext _input_rate;
+    std::deque<Item> _queue;
+    std::deque<Item> _retrans_queue;
+    onSendCB _cb;
+    toolkit::EventPoller::Ptr _poller;
+};
+
+} // namespace SRT
+
+#endif // ZLMEDIAKIT_SRT_LIVE_CC_H
\ No newline at end of file
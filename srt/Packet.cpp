@@ -50,7 +50,9 @@ bool DataPacket::loadFromData(uint8_t *buf, size_t len) {
     dst_socket_id = loadUint32(ptr);
     ptr += 4;
 
-    _data = BufferRaw::create();
+    if (!_data) {
+        _data = BufferRaw::create();
+    }
     _data->assign((char *)(buf), len);
     return true;
 }
@@ -56,6 +56,9 @@ public:
     static const size_t HEADER_SIZE = 16;
     static bool isDataPacket(uint8_t *buf, size_t len);
     static uint32_t getSocketID(uint8_t *buf, size_t len);
+    /**
+     * 解析数据包，对象从对象池复用时复用之前的内存，容量足够时不重新分配
+     */
     bool loadFromData(uint8_t *buf, size_t len);
     bool storeToData(uint8_t *buf, size_t len);
     bool storeToHeader();
@@ -2,31 +2,89 @@
 
 namespace SRT {
 
+// 环形缓存最小容量
+static constexpr uint32_t kMinCapacity = 256;
+
+static uint32_t roundUpPow2(uint32_t size) {
+    uint32_t ret = kMinCapacity;
+    while (ret < size && ret < ((MAX_SEQ >> 1) + 1)) {
+        ret <<= 1;
+    }
+    return ret;
+}
+
 PacketSendQueue::PacketSendQueue(uint32_t max_size, uint32_t latency,uint32_t flag)
     : _srt_flag(flag)
     , _pkt_cap(max_size)
-    , _pkt_latency(latency) {}
+    , _pkt_latency(latency) {
+    // 初始容量按每毫秒一个包(约10Mbps)估算，更高码率时自动扩容
+    _pkt_cache.resize(roundUpPow2(std::min<uint32_t>(max_size, latency / 1000)));
+}
+
+void PacketSendQueue::clear() {
+    for (uint32_t i = 0; i < _size; ++i) {
+        at(_first_seq + i).reset();
+    }
+    _size = 0;
+}
+
+void PacketSendQueue::popFront() {
+    at(_first_seq).reset();
+    _first_seq = incSeq(_first_seq);
+    --_size;
+}
+
+void PacketSendQueue::expand() {
+    std::vector<DataPacket::Ptr> cache(_pkt_cache.size() * 2);
+    auto mask = cache.size() - 1;
+    for (uint32_t i = 0; i < _size; ++i) {
+        auto seq = (_first_seq + i) & MAX_SEQ;
+        cache[seq & mask] = std::move(at(seq));
+    }
+    _pkt_cache.swap(cache);
+}
 
 bool PacketSendQueue::drop(uint32_t num) {
-    decltype(_pkt_cache.begin()) it;
-    for (it = _pkt_cache.begin(); it != _pkt_cache.end(); ++it) {
-        if ((*it)->packet_seq_number == num) {
-            break;
-        }
+    if (!_size) {
+        return true;
+    }
+    auto offset = offsetOf(num);
+    if (offset > (MAX_SEQ >> 1)) {
+        // 过期的ack
+        return true;
     }
-    if (it != _pkt_cache.end()) {
-        _pkt_cache.erase(_pkt_cache.begin(), it);
+    offset = std::min(offset, _size);
+    while (offset--) {
+        popFront();
     }
     return true;
 }
 
 bool PacketSendQueue::inputPacket(DataPacket::Ptr pkt) {
-    _pkt_cache.push_back(pkt);
-    while (_pkt_cache.size() > _pkt_cap) {
-        _pkt_cache.pop_front();
+    auto seq = pkt->packet_seq_number;
+    if (_size && offsetOf(seq) != _size) {
+        // 发送序号不连续，理论上不会发生，清空后重新开始
+        WarnL << "send seq not continuous, expect " << ((_first_seq + _size) & MAX_SEQ) << " got " << seq;
+        clear();
+    }
+    if (!_size) {
+        _first_seq = seq;
+    }
+    if (_size == _pkt_cache.size()) {
+        if (_pkt_cache.size() < _pkt_cap) {
+            expand();
+        } else {
+            popFront();
+        }
+    }
+    at(seq) = std::move(pkt);
+    ++_size;
+
+    while (_size > _pkt_cap) {
+        popFront();
     }
     while (timeLatency() > _pkt_latency && TLPKTDrop()) {
-        _pkt_cache.pop_front();
+        popFront();
     }
     return true;
 }
@@ -35,37 +93,27 @@ bool PacketSendQueue::TLPKTDrop(){
     return (_srt_flag&HSExtMessage::HS_EXT_MSG_TLPKTDROP) && (_srt_flag &HSExtMessage::HS_EXT_MSG_TSBPDSND);
 }
 
-std::list<DataPacket::Ptr> PacketSendQueue::findPacketBySeq(uint32_t start, uint32_t end) {
-    std::list<DataPacket::Ptr> re;
-    decltype(_pkt_cache.begin()) it;
-    for (it = _pkt_cache.begin(); it != _pkt_cache.end(); ++it) {
-        if ((*it)->packet_seq_number == start) {
-            break;
-        }
-    }
-
-    if (start == end) {
-        if (it != _pkt_cache.end()) {
-            re.push_back(*it);
-        }
+std::vector<DataPacket::Ptr> PacketSendQueue::findPacketBySeq(uint32_t start, uint32_t end) {
+    std::vector<DataPacket::Ptr> re;
+    auto offset = offsetOf(start);
+    if (offset >= _size) {
         return re;
     }
-
-    for (; it != _pkt_cache.end(); ++it) {
-        re.push_back(*it);
-        if ((*it)->packet_seq_number == end) {
-            break;
-        }
+    // end不在缓存中时返回到缓存末尾
+    auto count = std::min(((end - start) & MAX_SEQ) + 1, _size - offset);
+    re.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        re.emplace_back(at(start + i));
     }
     return re;
 }
 
 uint32_t PacketSendQueue::timeLatency() {
-    if (_pkt_cache.empty()) {
+    if (!_size) {
         return 0;
     }
-    auto first = _pkt_cache.front()->timestamp;
-    auto last = _pkt_cache.back()->timestamp;
+    auto first = at(_first_seq)->timestamp;
+    auto last = at(_first_seq + _size - 1)->timestamp;
     uint32_t dur;
 
     if (last > first) {
@@ -3,34 +3,61 @@
 
 #include "Packet.hpp"
 #include <algorithm>
-#include <list>
 #include <memory>
-#include <set>
-#include <tuple>
 #include <utility>
+#include <vector>
 
 namespace SRT {
 
+/**
+ * 发送缓存，用于nak重传
+ * 发送的包序号是连续的，所以按seq直接映射到环形缓存，nak查找与ack裁剪都无需遍历
+ * 缓存初始容量由延时估算，码率较高时按2倍扩容，最大不超过max_size
+ */
 class PacketSendQueue {
 public:
     using Ptr = std::shared_ptr<PacketSendQueue>;
     using LostPair = std::pair<uint32_t, uint32_t>;
 
+    /**
+     * @param max_size 最多缓存的包个数
+     * @param latency 缓存时长，单位微秒，一般为rtt * latencyMul
+     * @param flag 握手协商的srt flag
+     */
     PacketSendQueue(uint32_t max_size, uint32_t latency,uint32_t flag = 0xbf);
     ~PacketSendQueue() = default;
 
+    /**
+     * 收到ack，移除序号小于num的包
+     */
     bool drop(uint32_t num);
     bool inputPacket(DataPacket::Ptr pkt);
-    std::list<DataPacket::Ptr> findPacketBySeq(uint32_t start, uint32_t end);
+    /**
+     * 查找[start, end]区间的包，start不在缓存中时返回空
+     */
+    std::vector<DataPacket::Ptr> findPacketBySeq(uint32_t start, uint32_t end);
+
+    size_t getSize() const { return _size; }
+    size_t getCapacity() const { return _pkt_cache.size(); }
 
 private:
     uint32_t timeLatency();
     bool TLPKTDrop();
+    void popFront();
+    void expand();
+    void clear();
+    // 相对于首包的偏移，已考虑序号回环
+    uint32_t offsetOf(uint32_t seq) const { return (seq - _first_seq) & MAX_SEQ; }
+    DataPacket::Ptr &at(uint32_t seq) { return _pkt_cache[seq & (_pkt_cache.size() - 1)]; }
+
 private:
     uint32_t _srt_flag;
     uint32_t _pkt_cap;
     uint32_t _pkt_latency;
-    std::list<DataPacket::Ptr> _pkt_cache;
+    // 缓存[_first_seq, _first_seq + _size)区间的包，容量为2的幂，MAX_SEQ + 1是其整数倍，序号回环时映射不变
+    uint32_t _first_seq = 0;
+    uint32_t _size = 0;
+    std::vector<DataPacket::Ptr> _pkt_cache;
 };
 
 } // namespace SRT
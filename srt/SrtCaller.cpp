@@ -0,0 +1,227 @@
+﻿#include "Util/util.h"
+#include "Common/config.h"
+#include "Common/Parser.h"
+#include "Common/strCoding.h"
+#include "Thread/WorkThreadPool.h"
+#include "SrtCaller.hpp"
+#include "SrtPlayer.hpp"
+#include "SrtPusher.hpp"
+
+using namespace std;
+using namespace mediakit;
+
+namespace SRT {
+
+SrtCaller::SrtCaller(const EventPoller::Ptr &poller, bool is_receiver)
+    : SrtTransport(poller) {
+    _is_receiver = is_receiver;
+    memset(&_peer_addr, 0, sizeof(_peer_addr));
+}
+
+SrtCaller::~SrtCaller() {
+    close();
+}
+
+void SrtCaller::parseUrl(const string &url, bool is_receiver, string &host, uint16_t &port, string &streamid, uint16_t &latency) {
+    auto pos = url.find("://");
+    CHECK(pos != string::npos, "invalid srt url:", url);
+    auto host_port = url.substr(pos + 3);
+    string params;
+    pos = host_port.find('?');
+    if (pos != string::npos) {
+        params = host_port.substr(pos + 1);
+        host_port.erase(pos);
+    }
+    string path;
+    pos = host_port.find('/');
+    if (pos != string::npos) {
+        path = host_port.substr(pos + 1);
+        host_port.erase(pos);
+    }
+    port = 9000;
+    splitUrl(host_port, host, port);
+
+    auto args = Parser::parseArgs(params);
+    // stream id中的#等字符可能经过url编码
+    streamid = strCoding::UrlDecodeComponent(args["streamid"]);
+    if (streamid.empty() && !path.empty()) {
+        // 根据url路径生成stream id
+        streamid = "#!::r=" + path + (is_receiver ? "" : ",m=publish");
+    }
+    if (!args["latency"].empty()) {
+        latency = (uint16_t)atoi(args["latency"].data());
+    }
+}
+
+void SrtCaller::connect(const string &url, float timeout_sec, float media_timeout_sec) {
+    string host;
+    uint16_t port;
+    parseUrl(url, _is_receiver, host, port, _streamid, _latency);
+    _media_timeout_sec = media_timeout_sec;
+
+    weak_ptr<SrtCaller> weak_self = static_pointer_cast<SrtCaller>(shared_from_this());
+    _connect_timer = std::make_shared<Timer>(timeout_sec, [weak_self]() {
+        if (auto strong_self = weak_self.lock()) {
+            strong_self->onShutdown(SockException(Err_timeout, "srt handshake timeout"));
+        }
+        return false;
+    }, getPoller());
+
+    auto poller = getPoller();
+    WorkThreadPool::Instance().getPoller()->async([weak_self, poller, host, port]() {
+        struct sockaddr_storage addr;
+        // 切换线程目的是为了dns解析放在后台线程执行
+        auto ret = SockUtil::getDomainIP(host.data(), port, addr, AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        poller->async([weak_self, ret, addr, host]() {
+            auto strong_self = weak_self.lock();
+            if (!strong_self) {
+                return;
+            }
+            if (!ret) {
+                strong_self->onShutdown(SockException(Err_dns, StrPrinter << "dns resolution failed: " << host));
+                return;
+            }
+            strong_self->onResolved(addr);
+        });
+    });
+}
+
+void SrtCaller::onResolved(const struct sockaddr_storage &addr) {
+    if (_closed) {
+        return;
+    }
+    _peer_addr = addr;
+    _sock = Socket::createSocket(getPoller(), false);
+    if (!_sock->bindUdpSock(0, addr.ss_family == AF_INET ? "0.0.0.0" : "::")) {
+        onShutdown(SockException(Err_other, StrPrinter << "bind udp socket failed: " << get_uv_errmsg(true)));
+        return;
+    }
+    _sock->bindPeerAddr((struct sockaddr *)&_peer_addr, 0, true);
+    SockUtil::setRecvBuf(_sock->rawFD(), 1024 * 1024);
+
+    weak_ptr<SrtCaller> weak_self = static_pointer_cast<SrtCaller>(shared_from_this());
+    _sock->setOnRead([weak_self](const Buffer::Ptr &buf, struct sockaddr *addr, int addr_len) {
+        auto strong_self = weak_self.lock();
+        if (!strong_self || strong_self->_closed) {
+            return;
+        }
+        strong_self->inputSockData((uint8_t *)buf->data(), buf->size(), &strong_self->_peer_addr);
+    });
+    InfoL << "srt caller connect to " << SockUtil::inet_ntoa((struct sockaddr *)&_peer_addr) << ":"
+          << SockUtil::inet_port((struct sockaddr *)&_peer_addr) << ", streamid: " << _streamid;
+    startCallerHandshake(_streamid, _latency);
+}
+
+void SrtCaller::close() {
+    _on_connect = nullptr;
+    _on_shutdown = nullptr;
+    _on_data = nullptr;
+    if (_closed) {
+        return;
+    }
+    _closed = true;
+    _connect_timer = nullptr;
+    if (_sock) {
+        SrtTransport::onShutdown(SockException(Err_shutdown, "srt caller closed"));
+        _sock->setOnRead(nullptr);
+    }
+}
+
+int SrtCaller::getLatencyMul() {
+    GET_CONFIG(int, latencyMul, kLatencyMul);
+    return latencyMul > 0 ? latencyMul : 4;
+}
+
+int SrtCaller::getPktBufSize() {
+    GET_CONFIG(int, pktBufSize, kPktBufSize);
+    return pktBufSize > 0 ? pktBufSize : 8192;
+}
+
+void SrtCaller::onSRTData(DataPacket::Ptr pkt) {
+    if (_on_data) {
+        _on_data(pkt);
+    }
+}
+
+void SrtCaller::onHandShakeFinished(std::string &streamid, struct sockaddr_storage *addr) {
+    SrtTransport::onHandShakeFinished(streamid, addr);
+    _connect_timer = nullptr;
+    InfoL << "srt caller handshake success, streamid: " << streamid;
+    if (_on_connect) {
+        // 回调中可能销毁本对象
+        auto strong_self = shared_from_this();
+        auto cb = std::move(_on_connect);
+        _on_connect = nullptr;
+        cb(SockException());
+    }
+}
+
+void SrtCaller::onShutdown(const SockException &ex) {
+    if (_closed) {
+        return;
+    }
+    _closed = true;
+    _connect_timer = nullptr;
+    if (_sock) {
+        SrtTransport::onShutdown(ex);
+        _sock->setOnRead(nullptr);
+    }
+    // 回调中可能销毁本对象
+    auto strong_self = shared_from_this();
+    if (_on_connect) {
+        // 握手未完成
+        auto cb = std::move(_on_connect);
+        _on_connect = nullptr;
+        _on_shutdown = nullptr;
+        cb(ex);
+        return;
+    }
+    if (_on_shutdown) {
+        auto cb = std::move(_on_shutdown);
+        _on_shutdown = nullptr;
+        cb(ex);
+    }
+}
+
+void SrtCaller::sendPacket(Buffer::Ptr pkt, bool flush) {
+    if (!_sock) {
+        return;
+    }
+    // 数据包会被重传时修改，需要拷贝
+    auto tmp = _packet_pool.obtain2();
+    tmp->assign(pkt->data(), pkt->size());
+    _sock->send(std::move(tmp), nullptr, 0, flush);
+}
+
+// 与PlayerBase::createPlayer一致，在poller线程teardown并析构
+template <typename T>
+static std::shared_ptr<T> makeOnPoller(const EventPoller::Ptr &poller, T *obj) {
+    std::weak_ptr<EventPoller> weak_poller = poller;
+    return std::shared_ptr<T>(obj, [weak_poller](T *ptr) {
+        if (auto poller = weak_poller.lock()) {
+            poller->async([ptr]() {
+                onceToken token(nullptr, [&]() { delete ptr; });
+                ptr->teardown();
+            });
+        } else {
+            delete ptr;
+        }
+    });
+}
+
+void registerSrtCaller() {
+    static onceToken token([]() {
+        PlayerBase::registerPlayer("srt", [](const EventPoller::Ptr &poller) -> PlayerBase::Ptr {
+            return makeOnPoller(poller, new SrtPlayerImp(poller));
+        });
+        PusherBase::registerPusher("srt", [](const EventPoller::Ptr &poller, const MediaSource::Ptr &src) -> PusherBase::Ptr {
+            auto ts_src = std::dynamic_pointer_cast<TSMediaSource>(src);
+            if (!ts_src) {
+                throw std::invalid_argument("srt pusher only support ts source, please use schema=ts");
+            }
+            return makeOnPoller(poller, new SrtPusherImp(poller, ts_src));
+        });
+    });
+}
+
+} // namespace SRT
\ No newline at end of file
@@ -0,0 +1,93 @@
+﻿#ifndef ZLMEDIAKIT_SRT_CALLER_H
+#define ZLMEDIAKIT_SRT_CALLER_H
+
+#include "Network/Socket.h"
+#include "Util/ResourcePool.h"
+#include "SrtTransport.hpp"
+
+namespace SRT {
+
+/**
+ * srt caller模式客户端，主动向srt服务器发起握手，用于srt拉流与推流
+ * url格式: srt://host:port?streamid=#!::r=app/stream,m=publish&latency=120
+ * 或者srt://host:port/app/stream，此时根据推拉流类型自动生成stream id
+ * latency单位为毫秒
+ */
+class SrtCaller : public SrtTransport {
+public:
+    using Ptr = std::shared_ptr<SrtCaller>;
+    using onResult = std::function<void(const SockException &ex)>;
+    using onData = std::function<void(const DataPacket::Ptr &pkt)>;
+
+    /**
+     * @param poller 所属poller
+     * @param is_receiver 是否接收媒体数据(拉流)
+     */
+    SrtCaller(const EventPoller::Ptr &poller, bool is_receiver);
+    ~SrtCaller() override;
+
+    /**
+     * 解析url并发起握手
+     * @param url srt url
+     * @param timeout_sec 握手超时时间，单位秒
+     * @param media_timeout_sec 握手完成后接收数据超时时间，单位秒
+     */
+    void connect(const std::string &url, float timeout_sec, float media_timeout_sec);
+
+    /**
+     * 主动断开，不触发回调
+     */
+    void close();
+
+    void setOnConnect(onResult cb) { _on_connect = std::move(cb); }
+    void setOnShutdown(onResult cb) { _on_shutdown = std::move(cb); }
+    void setOnData(onData cb) { _on_data = std::move(cb); }
+
+    /**
+     * 解析url中的stream id与延时
+     * @param url srt url
+     * @param is_receiver 是否为拉流
+     * @param host 服务器地址
+     * @param port 服务器端口
+     * @param streamid stream id
+     * @param latency 延时，单位毫秒，url未指定时不修改
+     */
+    static void parseUrl(const std::string &url, bool is_receiver, std::string &host, uint16_t &port, std::string &streamid, uint16_t &latency);
+
+protected:
+    ///////SrtTransport override///////
+    bool isPusher() override { return _is_receiver; }
+    int getLatencyMul() override;
+    int getPktBufSize() override;
+    float getTimeOutSec() override { return _media_timeout_sec; }
+    void onSRTData(DataPacket::Ptr pkt) override;
+    void onShutdown(const SockException &ex) override;
+    void onHandShakeFinished(std::string &streamid, struct sockaddr_storage *addr) override;
+    void sendPacket(Buffer::Ptr pkt, bool flush = true) override;
+
+private:
+    void onResolved(const struct sockaddr_storage &addr);
+
+private:
+    bool _is_receiver;
+    bool _closed = false;
+    float _media_timeout_sec = 5;
+    uint16_t _latency = 120;
+    std::string _streamid;
+    struct sockaddr_storage _peer_addr;
+    Socket::Ptr _sock;
+    Timer::Ptr _connect_timer;
+    ResourcePool<BufferRaw> _packet_pool;
+    onResult _on_connect;
+    onResult _on_shutdown;
+    onData _on_data;
+};
+
+/**
+ * 注册srt播放器与推流器，注册后可以通过addStreamProxy/addStreamPusherProxy使用srt url
+ */
+void registerSrtCaller();
+
+} // namespace SRT
+
+#endif // ZLMEDIAKIT_SRT_CALLER_H
\ No newline at end of file
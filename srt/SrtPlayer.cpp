@@ -0,0 +1,116 @@
+﻿#include "Common/config.h"
+#include "Http/HlsPlayer.h"
+#include "SrtPlayer.hpp"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+namespace SRT {
+
+SrtPlayer::SrtPlayer(const EventPoller::Ptr &poller) {
+    _poller = poller ? poller : EventPollerPool::Instance().getPoller();
+}
+
+SrtPlayer::~SrtPlayer() {
+    if (_caller) {
+        _caller->close();
+    }
+}
+
+void SrtPlayer::play(const string &url) {
+    TraceL << "play srt: " << url;
+    _benchmark_mode = (*this)[Client::kBenchmarkMode].as<int>();
+    if (_caller) {
+        _caller->close();
+    }
+    _caller = std::make_shared<SrtCaller>(_poller, true);
+
+    weak_ptr<SrtPlayer> weak_self = shared_from_this();
+    _caller->setOnConnect([weak_self](const SockException &ex) {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return;
+        }
+        strong_self->onPlayResult(ex);
+    });
+    _caller->setOnShutdown([weak_self](const SockException &ex) {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return;
+        }
+        strong_self->onShutdown(ex);
+    });
+    _caller->setOnData([weak_self](const DataPacket::Ptr &pkt) {
+        auto strong_self = weak_self.lock();
+        if (!strong_self || strong_self->_benchmark_mode) {
+            return;
+        }
+        strong_self->onSRTData(pkt->payloadData(), pkt->payloadSize());
+    });
+    _caller->connect(url, (*this)[Client::kTimeoutMS].as<int>() / 1000.0f, (*this)[Client::kMediaTimeoutMS].as<int>() / 1000.0f);
+}
+
+void SrtPlayer::teardown() {
+    if (_caller) {
+        _caller->close();
+        _caller = nullptr;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+SrtPlayerImp::SrtPlayerImp(const EventPoller::Ptr &poller) : PlayerImp<SrtPlayer, PlayerBase>(poller) {}
+
+void SrtPlayerImp::onSRTData(const char *data, size_t len) {
+    if (!_decoder && _demuxer) {
+        _decoder = DecoderImp::createDecoder(DecoderImp::decoder_ts, _demuxer.get());
+    }
+
+    if (_decoder && _demuxer) {
+        _decoder->input((uint8_t *) data, len);
+    }
+}
+
+void SrtPlayerImp::addTrackCompleted() {
+    PlayerImp<SrtPlayer, PlayerBase>::onPlayResult(SockException(Err_success, "play srt success"));
+}
+
+void SrtPlayerImp::onPlayResult(const SockException &ex) {
+    auto benchmark_mode = (*this)[Client::kBenchmarkMode].as<int>();
+    if (ex || benchmark_mode) {
+        PlayerImp<SrtPlayer, PlayerBase>::onPlayResult(ex);
+    } else {
+        // 握手成功，等待解析出所有track后再触发播放成功事件
+        auto demuxer = std::make_shared<HlsDemuxer>();
+        demuxer->start(getPoller(), this);
+        _demuxer = std::move(demuxer);
+    }
+}
+
+void SrtPlayerImp::onShutdown(const SockException &ex) {
+    if (_demuxer) {
+        std::weak_ptr<SrtPlayerImp> weak_self = static_pointer_cast<SrtPlayerImp>(shared_from_this());
+        if (_decoder) {
+            _decoder->flush();
+        }
+        // 等待所有frame flush输出后，再触发onShutdown事件
+        static_pointer_cast<HlsDemuxer>(_demuxer)->pushTask([weak_self, ex]() {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->_demuxer = nullptr;
+                strong_self->onShutdown(ex);
+            }
+        });
+        return;
+    }
+    PlayerImp<SrtPlayer, PlayerBase>::onShutdown(ex);
+}
+
+vector<Track::Ptr> SrtPlayerImp::getTracks(bool ready) const {
+    if (!_demuxer) {
+        return vector<Track::Ptr>();
+    }
+    return static_pointer_cast<HlsDemuxer>(_demuxer)->getTracks(ready);
+}
+
+} // namespace SRT
\ No newline at end of file
@@ -0,0 +1,70 @@
+﻿#ifndef ZLMEDIAKIT_SRT_PLAYER_H
+#define ZLMEDIAKIT_SRT_PLAYER_H
+
+#include "Player/PlayerBase.h"
+#include "Rtp/Decoder.h"
+#include "SrtCaller.hpp"
+
+namespace SRT {
+
+/**
+ * srt拉流客户端(caller模式)，接收mpegts数据
+ */
+class SrtPlayer : public mediakit::PlayerBase, public std::enable_shared_from_this<SrtPlayer> {
+public:
+    SrtPlayer(const toolkit::EventPoller::Ptr &poller);
+    ~SrtPlayer() override;
+
+    /**
+     * 开始播放
+     */
+    void play(const std::string &url) override;
+
+    /**
+     * 停止播放
+     */
+    void teardown() override;
+
+    const toolkit::EventPoller::Ptr &getPoller() const { return _poller; }
+
+protected:
+    /**
+     * 收到mpegts数据
+     */
+    virtual void onSRTData(const char *data, size_t len) {}
+
+private:
+    bool _benchmark_mode = false;
+    toolkit::EventPoller::Ptr _poller;
+    SrtCaller::Ptr _caller;
+};
+
+class SrtPlayerImp : public mediakit::PlayerImp<SrtPlayer, mediakit::PlayerBase>, private mediakit::TrackListener {
+public:
+    using Ptr = std::shared_ptr<SrtPlayerImp>;
+
+    SrtPlayerImp(const toolkit::EventPoller::Ptr &poller);
+
+private:
+    //// SrtPlayer override////
+    void onSRTData(const char *data, size_t len) override;
+
+private:
+    //// PlayerBase override////
+    void onPlayResult(const toolkit::SockException &ex) override;
+    std::vector<mediakit::Track::Ptr> getTracks(bool ready = true) const override;
+    void onShutdown(const toolkit::SockException &ex) override;
+
+private:
+    //// TrackListener override////
+    bool addTrack(const mediakit::Track::Ptr &track) override { return true; };
+    void addTrackCompleted() override;
+
+private:
+    mediakit::DecoderImp::Ptr _decoder;
+    mediakit::MediaSinkInterface::Ptr _demuxer;
+};
+
+} // namespace SRT
+
+#endif // ZLMEDIAKIT_SRT_PLAYER_H
\ No newline at end of file
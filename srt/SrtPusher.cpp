@@ -0,0 +1,87 @@
+﻿#include "Common/config.h"
+#include "SrtPusher.hpp"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+namespace SRT {
+
+SrtPusher::SrtPusher(const EventPoller::Ptr &poller, const TSMediaSource::Ptr &src) {
+    _poller = poller ? poller : EventPollerPool::Instance().getPoller();
+    _media_src = src;
+}
+
+SrtPusher::~SrtPusher() {
+    teardown();
+}
+
+void SrtPusher::publish(const string &url) {
+    TraceL << "publish srt: " << url;
+    teardown();
+    _caller = std::make_shared<SrtCaller>(_poller, false);
+
+    weak_ptr<SrtPusher> weak_self = shared_from_this();
+    _caller->setOnConnect([weak_self](const SockException &ex) {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return;
+        }
+        if (ex) {
+            strong_self->onPublishResult(ex);
+            return;
+        }
+        strong_self->onConnected();
+    });
+    _caller->setOnShutdown([weak_self](const SockException &ex) {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return;
+        }
+        strong_self->_ts_reader = nullptr;
+        strong_self->onShutdown(ex);
+    });
+    _caller->connect(url, (*this)[Client::kTimeoutMS].as<int>() / 1000.0f, (*this)[Client::kMediaTimeoutMS].as<int>() / 1000.0f);
+}
+
+void SrtPusher::onConnected() {
+    auto src = _media_src.lock();
+    if (!src) {
+        onPublishResult(SockException(Err_shutdown, "the media source was released"));
+        return;
+    }
+    src->pause(false);
+    _ts_reader = src->getRing()->attach(_poller);
+
+    weak_ptr<SrtPusher> weak_self = shared_from_this();
+    _ts_reader->setDetachCB([weak_self]() {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            // 本对象已经销毁
+            return;
+        }
+        strong_self->onShutdown(SockException(Err_shutdown, "the media source was released"));
+    });
+    _ts_reader->setReadCB([weak_self](const TSMediaSource::RingDataType &ts_list) {
+        auto strong_self = weak_self.lock();
+        if (!strong_self || !strong_self->_caller) {
+            // 本对象已经销毁
+            return;
+        }
+        size_t i = 0;
+        auto size = ts_list->size();
+        auto caller = strong_self->_caller;
+        ts_list->for_each([&](const TSPacket::Ptr &ts) { caller->onSendTSData(ts, ++i == size); });
+    });
+    onPublishResult(SockException(Err_success, "publish srt success"));
+}
+
+void SrtPusher::teardown() {
+    _ts_reader = nullptr;
+    if (_caller) {
+        _caller->close();
+        _caller = nullptr;
+    }
+}
+
+} // namespace SRT
\ No newline at end of file
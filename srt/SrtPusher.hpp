@@ -0,0 +1,42 @@
+﻿#ifndef ZLMEDIAKIT_SRT_PUSHER_H
+#define ZLMEDIAKIT_SRT_PUSHER_H
+
+#include "Pusher/PusherBase.h"
+#include "TS/TSMediaSource.h"
+#include "SrtCaller.hpp"
+
+namespace SRT {
+
+/**
+ * srt推流客户端(caller模式)，将mpegts直播源推送至srt服务器
+ */
+class SrtPusher : public mediakit::PusherBase, public std::enable_shared_from_this<SrtPusher> {
+public:
+    SrtPusher(const toolkit::EventPoller::Ptr &poller, const mediakit::TSMediaSource::Ptr &src);
+    ~SrtPusher() override;
+
+    /**
+     * 开始推流
+     */
+    void publish(const std::string &url) override;
+
+    /**
+     * 停止推流
+     */
+    void teardown() override;
+
+private:
+    void onConnected();
+
+private:
+    toolkit::EventPoller::Ptr _poller;
+    std::weak_ptr<mediakit::TSMediaSource> _media_src;
+    mediakit::TSMediaSource::RingType::RingReader::Ptr _ts_reader;
+    SrtCaller::Ptr _caller;
+};
+
+using SrtPusherImp = mediakit::PusherImp<SrtPusher, mediakit::PusherBase>;
+
+} // namespace SRT
+
+#endif // ZLMEDIAKIT_SRT_PUSHER_H
\ No newline at end of file
@@ -17,6 +17,7 @@ public:
     void onManager() override;
     void attachServer(const toolkit::Server &server) override;
     static EventPoller::Ptr queryPoller(const Buffer::Ptr &buffer);
+    const SrtTransport::Ptr &getTransport() const { return _transport; }
 
 private:
     bool _find_transport = true;
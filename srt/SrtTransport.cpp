@@ -2,6 +2,7 @@
 #include "Util/mini.h"
 
 #include <iterator>
+#include <random>
 #include <stdlib.h>
 
 #include "Ack.hpp"
@@ -16,12 +17,18 @@ const std::string kTimeOutSec = SRT_FIELD "timeoutSec";
 const std::string kPort = SRT_FIELD "port";
 const std::string kLatencyMul = SRT_FIELD "latencyMul";
 const std::string kPktBufSize = SRT_FIELD "pktBufSize";
+// 发送最大带宽，单位字节/秒，-1不限速，0根据输入码率计算
+const std::string kMaxBandwidth = SRT_FIELD "maxBandwidth";
+// 根据输入码率计算发送带宽时，额外预留给重传的带宽百分比
+const std::string kOverheadBandwidth = SRT_FIELD "overheadBandwidth";
 
 static onceToken token([]() {
     mINI::Instance()[kTimeOutSec] = 5;
     mINI::Instance()[kPort] = 9000;
     mINI::Instance()[kLatencyMul] = 4;
     mINI::Instance()[kPktBufSize] = 8192;
+    mINI::Instance()[kMaxBandwidth] = 0;
+    mINI::Instance()[kOverheadBandwidth] = 25;
 });
 
 static std::atomic<uint32_t> s_srt_socket_id_generate { 125 };
@@ -33,6 +40,8 @@ SrtTransport::SrtTransport(const EventPoller::Ptr &poller)
     _pkt_recv_rate_context = std::make_shared<PacketRecvRateContext>(_start_timestamp);
     //_recv_rate_context = std::make_shared<RecvRateContext>(_start_timestamp);
     _estimated_link_capacity_context = std::make_shared<EstimatedLinkCapacityContext>(_start_timestamp);
+    // 接收队列中的数据包不在池中，池只需容纳排队时长内释放的数据包
+    _recv_pkt_pool.setSize(256);
 }
 
 SrtTransport::~SrtTransport() {
@@ -276,10 +285,7 @@ void SrtTransport::handleHandshakeConclusion(HandshakePacket &pkt, struct sockad
         sendControlPacket(res, true);
         TraceL << " buf size = " << res->max_flow_window_size << " init seq =" << _init_seq_number
                << " latency=" << delay;
-        _recv_buf = std::make_shared<PacketRecvQueue>(getPktBufSize(), _init_seq_number, delay * 1e3,srt_flag);
-        _send_buf = std::make_shared<PacketSendQueue>(getPktBufSize(), delay * 1e3,srt_flag);
-        _send_packet_seq_number = _init_seq_number;
-        _buf_delay = delay;
+        onHandshakeDone(delay, srt_flag);
         onHandShakeFinished(_stream_id, addr);
 
         if(!isPusher()){
@@ -301,9 +307,139 @@ void SrtTransport::handleHandshakeConclusion(HandshakePacket &pkt, struct sockad
         return;
         
     }
+}
+
+void SrtTransport::onHandshakeDone(uint16_t delay, uint32_t srt_flag) {
+    _recv_buf = std::make_shared<PacketRecvQueue>(getPktBufSize(), _init_seq_number, delay * 1e3,srt_flag);
+    _send_buf = std::make_shared<PacketSendQueue>(getPktBufSize(), delay * 1e3,srt_flag);
+    // 该对象随transport销毁，不会在transport销毁后回调
+    _live_cc = std::make_shared<LiveCC>(_poller, [this](Buffer::Ptr pkt, bool flush) { sendPacket(std::move(pkt), flush); });
+    _live_cc->setMaxQueueDelay(delay / 2);
+    _send_packet_seq_number = _init_seq_number;
+    _buf_delay = delay;
     _last_ack_pkt_seq = _init_seq_number;
 }
 
+void SrtTransport::startCallerHandshake(const std::string &streamid, uint16_t latency) {
+    _is_caller = true;
+    _stream_id = streamid;
+    _caller_latency = latency;
+    _now = SteadyClock::now();
+    _start_timestamp = _now;
+    _induction_ts = _now;
+    _init_seq_number = std::random_device()() & MAX_SEQ;
+    _last_pkt_seq = _init_seq_number - 1;
+    _estimated_link_capacity_context->setLastSeq(_last_pkt_seq);
+
+    // 第一阶段，发送version 4的induction请求，获取syn cookie
+    HandshakePacket::Ptr req = std::make_shared<HandshakePacket>();
+    req->dst_socket_id = 0;
+    req->timestamp = 0;
+    req->version = 4;
+    req->encryption_field = HandshakePacket::NO_ENCRYPTION;
+    req->extension_field = 2;
+    req->initial_packet_sequence_number = _init_seq_number;
+    req->mtu = _mtu;
+    req->max_flow_window_size = _max_window_size;
+    req->handshake_type = HandshakePacket::HS_TYPE_INDUCTION;
+    req->srt_socket_id = _socket_id;
+    req->syn_cookie = 0;
+    memset(req->peer_ip_addr, 0, sizeof(req->peer_ip_addr));
+    req->storeToData();
+    _handleshake_res = req;
+    sendControlPacket(req, true);
+
+    // 握手包可能丢失，定时重发，握手完成后停止
+    _handleshake_timer = std::make_shared<Timer>(0.25, [this]() -> bool {
+        if (_handleshake_res->handshake_type == HandshakePacket::HS_TYPE_INDUCTION) {
+            _induction_ts = SteadyClock::now();
+        }
+        sendControlPacket(_handleshake_res, true);
+        return true;
+    }, getPoller());
+}
+
+void SrtTransport::handleCallerHandshake(HandshakePacket &pkt, struct sockaddr_storage *addr) {
+    if (_is_handleshake_finished) {
+        // 重复的应答
+        return;
+    }
+    if (pkt.handshake_type == HandshakePacket::HS_TYPE_INDUCTION) {
+        if (_handleshake_res->handshake_type != HandshakePacket::HS_TYPE_INDUCTION) {
+            return;
+        }
+        if (pkt.version != 5) {
+            onShutdown(SockException(Err_other, StrPrinter << "not support srt handshake version " << pkt.version));
+            return;
+        }
+        uint16_t delay = DurationCountMicroseconds(_now - _induction_ts) * getLatencyMul() / 1000;
+        delay = std::max(delay, _caller_latency);
+        TraceL << getIdentifier() << " Induction response, cookie=" << pkt.syn_cookie << " latency=" << delay;
+
+        // 第二阶段，携带cookie、srt扩展与stream id发送conclusion请求
+        HandshakePacket::Ptr req = std::make_shared<HandshakePacket>();
+        req->dst_socket_id = 0;
+        req->timestamp = DurationCountMicroseconds(_now - _start_timestamp);
+        req->version = 5;
+        req->encryption_field = HandshakePacket::NO_ENCRYPTION;
+        req->extension_field = HandshakePacket::HS_EXT_FILED_HSREQ;
+        req->initial_packet_sequence_number = _init_seq_number;
+        req->mtu = _mtu;
+        req->max_flow_window_size = _max_window_size;
+        req->handshake_type = HandshakePacket::HS_TYPE_CONCLUSION;
+        req->srt_socket_id = _socket_id;
+        req->syn_cookie = pkt.syn_cookie;
+        req->assignPeerIP(addr);
+        HSExtMessage::Ptr ext = std::make_shared<HSExtMessage>();
+        ext->extension_type = HSExt::SRT_CMD_HSREQ;
+        ext->srt_version = srtVersion(1, 5, 0);
+        ext->srt_flag = HSExtMessage::HS_EXT_MSG_TSBPDSND | HSExtMessage::HS_EXT_MSG_TSBPDRCV
+            | HSExtMessage::HS_EXT_MSG_TLPKTDROP | HSExtMessage::HS_EXT_MSG_PERIODICNAK | HSExtMessage::HS_EXT_MSG_REXMITFLG;
+        ext->recv_tsbpd_delay = ext->send_tsbpd_delay = delay;
+        req->ext_list.push_back(std::move(ext));
+        if (!_stream_id.empty()) {
+            req->extension_field |= HandshakePacket::HS_EXT_FILED_CONFIG;
+            HSExtStreamID::Ptr sid = std::make_shared<HSExtStreamID>();
+            sid->streamid = _stream_id;
+            req->ext_list.push_back(std::move(sid));
+        }
+        req->storeToData();
+        _handleshake_res = req;
+        _caller_latency = delay;
+        sendControlPacket(req, true);
+        return;
+    }
+
+    if (pkt.handshake_type == HandshakePacket::HS_TYPE_CONCLUSION) {
+        if (_handleshake_res->handshake_type != HandshakePacket::HS_TYPE_CONCLUSION) {
+            return;
+        }
+        HSExtMessage::Ptr rsp;
+        for (auto &ext : pkt.ext_list) {
+            rsp = std::dynamic_pointer_cast<HSExtMessage>(ext);
+            if (rsp) {
+                break;
+            }
+        }
+        auto srt_flag = std::static_pointer_cast<HSExtMessage>(_handleshake_res->ext_list.front())->srt_flag;
+        uint16_t delay = _caller_latency;
+        if (rsp) {
+            srt_flag = rsp->srt_flag;
+            delay = std::max(delay, std::max(rsp->recv_tsbpd_delay, rsp->send_tsbpd_delay));
+        }
+        _peer_socket_id = pkt.srt_socket_id;
+        _handleshake_timer.reset();
+        TraceL << getIdentifier() << " CONCLUSION response, peer socket id=" << _peer_socket_id << " init seq=" << _init_seq_number
+               << " latency=" << delay;
+        onHandshakeDone(delay, srt_flag);
+        onHandShakeFinished(_stream_id, addr);
+        return;
+    }
+
+    // 握手被拒绝时，握手类型为拒绝原因
+    onShutdown(SockException(Err_refused, StrPrinter << "srt handshake rejected, reason: " << pkt.handshake_type));
+}
+
 void SrtTransport::handleHandshake(uint8_t *buf, int len, struct sockaddr_storage *addr) {
     HandshakePacket pkt;
     if(!pkt.loadFromData(buf, len)){
@@ -311,7 +447,9 @@ void SrtTransport::handleHandshake(uint8_t *buf, int len, struct sockaddr_storag
         return;
     }
 
-    if (pkt.handshake_type == HandshakePacket::HS_TYPE_INDUCTION) {
+    if (_is_caller) {
+        handleCallerHandshake(pkt, addr);
+    } else if (pkt.handshake_type == HandshakePacket::HS_TYPE_INDUCTION) {
         handleHandshakeInduction(pkt, addr);
     } else if (pkt.handshake_type == HandshakePacket::HS_TYPE_CONCLUSION) {
         handleHandshakeConclusion(pkt, addr);
@@ -379,7 +517,11 @@ void SrtTransport::handleNAK(uint8_t *buf, int len, struct sockaddr_storage *add
         for (auto& pkt : re_list) {
             pkt->R = 1;
             pkt->storeToHeader();
-            sendPacket(pkt, flush);
+            if (_live_cc) {
+                _live_cc->inputRetransmit(pkt, flush);
+            } else {
+                sendPacket(pkt, flush);
+            }
             empty = false;
         }
         if (empty) {
@@ -608,8 +750,15 @@ void SrtTransport::sendShutDown() {
 }
 
 void SrtTransport::handleDataPacket(uint8_t *buf, int len, struct sockaddr_storage *addr) {
-    DataPacket::Ptr pkt = std::make_shared<DataPacket>();
-    pkt->loadFromData(buf, len);
+    // 数据包只拷贝一次至复用的内存，之后以指针形式经过接收队列交给解码器
+    DataPacket::Ptr pkt = _recv_pkt_pool.obtain2();
+    if (!pkt->data()) {
+        ++_recv_pkt_alloc;
+    }
+    ++_recv_pkt_count;
+    if (!pkt->loadFromData(buf, len)) {
+        return;
+    }
 
     _estimated_link_capacity_context->inputPacket(_now,pkt);
 
@@ -681,8 +830,12 @@ void SrtTransport::handleDataPacket(uint8_t *buf, int len, struct sockaddr_stora
 
 void SrtTransport::sendDataPacket(DataPacket::Ptr pkt, char *buf, int len, bool flush) {
     pkt->storeToData((uint8_t *)buf, len);
-    sendPacket(pkt, flush);
     _send_buf->inputPacket(pkt);
+    if (_live_cc) {
+        _live_cc->inputPacket(std::move(pkt), flush);
+    } else {
+        sendPacket(std::move(pkt), flush);
+    }
 }
 
 void SrtTransport::sendControlPacket(ControlPacket::Ptr pkt, bool flush) {
@@ -729,6 +882,9 @@ void SrtTransport::unregisterSelf() {
 void SrtTransport::onShutdown(const SockException &ex) {
     sendShutDown();
     WarnL << ex.what();
+    if (_recv_pkt_count) {
+        DebugL << getIdentifier() << " recv packets: " << _recv_pkt_count << ", allocated: " << _recv_pkt_alloc;
+    }
     unregisterSelfHandshake();
     unregisterSelf();
     for (auto &pr : _history_sessions) {
@@ -15,6 +15,7 @@
 #include "Packet.hpp"
 #include "PacketQueue.hpp"
 #include "PacketSendQueue.hpp"
+#include "LiveCC.hpp"
 #include "Statistic.hpp"
 namespace SRT {
 
@@ -24,6 +25,8 @@ extern const std::string kPort;
 extern const std::string kTimeOutSec;
 extern const std::string kLatencyMul;
 extern const std::string kPktBufSize;
+extern const std::string kMaxBandwidth;
+extern const std::string kOverheadBandwidth;
 
 class SrtTransport : public std::enable_shared_from_this<SrtTransport> {
 public:
@@ -47,6 +50,12 @@ public:
 
     std::string getIdentifier() const;
     void unregisterSelf();
+    // 发送端拥塞控制，握手完成前为空
+    const LiveCC::Ptr &getLiveCC() const { return _live_cc; }
+    // 接收的数据包个数
+    uint64_t getRecvPackets() const { return _recv_pkt_count; }
+    // 接收数据包时新创建的对象个数，其余复用自对象池
+    uint64_t getRecvPacketAllocs() const { return _recv_pkt_alloc; }
     void unregisterSelfHandshake();
 
 protected:
@@ -61,6 +70,13 @@ protected:
     virtual int getPktBufSize() { return 8192; };
     virtual float getTimeOutSec(){return 5.0;};
 
+    /**
+     * 以caller模式向对端发起握手，握手完成后触发onHandShakeFinished
+     * @param streamid 握手时携带的stream id
+     * @param latency 期望的延时，单位毫秒，最终取双方协商的最大值
+     */
+    void startCallerHandshake(const std::string &streamid, uint16_t latency);
+
 private:
     void registerSelf();
     void registerSelfHandshake();
@@ -70,6 +86,8 @@ private:
     void handleHandshake(uint8_t *buf, int len, struct sockaddr_storage *addr);
     void handleHandshakeInduction(HandshakePacket &pkt, struct sockaddr_storage *addr);
     void handleHandshakeConclusion(HandshakePacket &pkt, struct sockaddr_storage *addr);
+    void handleCallerHandshake(HandshakePacket &pkt, struct sockaddr_storage *addr);
+    void onHandshakeDone(uint16_t delay, uint32_t srt_flag);
 
     void handleKeeplive(uint8_t *buf, int len, struct sockaddr_storage *addr);
     void handleACK(uint8_t *buf, int len, struct sockaddr_storage *addr);
@@ -126,6 +144,7 @@ private:
     uint32_t _send_msg_number = 1;
 
     PacketSendQueue::Ptr _send_buf;
+    LiveCC::Ptr _live_cc;
     uint32_t _buf_delay = 120;
     PacketQueueInterface::Ptr _recv_buf;
     // NackContext _recv_nack;
@@ -152,6 +171,10 @@ private:
     Timer::Ptr _handleshake_timer;
 
     ResourcePool<BufferRaw> _packet_pool;
+    // 接收数据包对象池，数据包释放后连同内存一起回收复用
+    ResourcePool<DataPacket> _recv_pkt_pool;
+    uint64_t _recv_pkt_count = 0;
+    uint64_t _recv_pkt_alloc = 0;
 
     //检测超时的定时器
     Timer::Ptr _timer;
@@ -159,6 +182,9 @@ private:
     Ticker _alive_ticker;
 
     bool _is_handleshake_finished = false;
+    // 是否为caller模式(主动发起握手)
+    bool _is_caller = false;
+    uint16_t _caller_latency = 120;
 };
 
 class SrtTransportManager {
@@ -199,6 +199,23 @@ uint32_t EstimatedLinkCapacityContext::getEstimatedLinkCapacity() {
    return (uint32_t)ceil(1000000.0 / (double(sum) / double(count)));
 }
 
+InputRateContext::InputRateContext(TimePoint start)
+    : _period_start(start) {}
+
+void InputRateContext::inputPacket(TimePoint &ts, size_t len) {
+    _bytes += len;
+    auto dur = DurationCountMicroseconds(ts - _period_start);
+    if (dur < _period_us) {
+        return;
+    }
+    uint64_t rate = _bytes * 1000000 / dur;
+    // 首个周期直接使用采样值，之后平滑
+    _rate = _rate ? (_rate * 7 + rate) / 8 : rate;
+    _period_us = 1000 * 1000;
+    _period_start = ts;
+    _bytes = 0;
+}
+
 /*
 void RecvRateContext::inputPacket(TimePoint &ts, size_t size) {
     if (_pkt_map.size() > 100) {
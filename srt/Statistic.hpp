@@ -45,6 +45,24 @@ private:
     //std::map<int64_t, int64_t> _pkt_map;
 };
 
+/**
+ * 发送端输入码率统计，与libsrt一致，首个采样周期500ms，之后每1s采样一次并平滑
+ */
+class InputRateContext {
+public:
+    InputRateContext(TimePoint start);
+    ~InputRateContext() = default;
+    void inputPacket(TimePoint &ts, size_t len);
+    // 输入码率，单位字节/秒，首个采样周期结束前返回0
+    uint64_t getInputRate() const { return _rate; }
+
+private:
+    TimePoint _period_start;
+    int64_t _period_us = 500 * 1000;
+    size_t _bytes = 0;
+    uint64_t _rate = 0;
+};
+
 /*
 class RecvRateContext {
 public:
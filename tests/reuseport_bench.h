@@ -0,0 +1,170 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+// reuseport分发测试程序(test_rtc_udp_steering、test_rtp_udp_steering)共用的收发包框架
+
+#ifndef ZLMEDIAKIT_TESTS_REUSEPORT_BENCH_H
+#define ZLMEDIAKIT_TESTS_REUSEPORT_BENCH_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include "Util/util.h"
+#include "Network/sockutil.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+
+namespace reuseport_bench {
+
+//每个发包线程使用的源端口个数，不开启分发时由内核按四元组hash
+static constexpr size_t kSrcPortPerSender = 8;
+
+enum PacketResult {
+    //不是测试数据包
+    kIgnore = 0,
+    //落在了预期的socket上
+    kMatch,
+    //落在了其他socket上
+    kMismatch,
+    //未被分发，由内核hash
+    kUnsteered,
+};
+
+struct RoundResult {
+    uint64_t send_pkts = 0;
+    uint64_t recv_pkts = 0;
+    uint64_t mismatch = 0;
+    uint64_t unsteered = 0;
+    //各socket的收包数
+    std::vector<uint64_t> socket_pkts;
+    double seconds = 0;
+};
+
+//收包回调，在socket_index对应的收包线程触发
+using onRecv = std::function<PacketResult(size_t socket_index, const char *data, size_t size)>;
+//发包线程主体，sending为false时退出，返回发包个数
+using onSend = std::function<uint64_t(size_t sender_index, const std::vector<int> &socks, const sockaddr_storage &dst,
+                                      const std::atomic<bool> &sending, uint64_t start_us)>;
+//在reuseport组上挂载分发程序
+using onAttach = std::function<bool(int fd, size_t socket_count)>;
+
+//绑定socket_count个SO_REUSEPORT socket，绑定顺序即组内下标，attach不为空时挂载分发程序，每个socket一个收包线程，
+//sender_count个发包线程同时发包duration_ms毫秒，统计收包个数与分发正确性
+static RoundResult runRound(size_t socket_count, size_t sender_count, uint64_t duration_ms, int recv_buf,
+                            const onAttach &attach, const onRecv &on_recv, const onSend &on_send) {
+    using namespace toolkit;
+    RoundResult ret;
+    std::vector<int> fds;
+    uint16_t port = 0;
+    for (size_t i = 0; i < socket_count; ++i) {
+        auto fd = SockUtil::bindUdpSock(port, "127.0.0.1", true);
+        if (fd == -1) {
+            std::cerr << "bind udp socket failed" << std::endl;
+            exit(1);
+        }
+        port = SockUtil::get_local_port(fd);
+        SockUtil::setRecvBuf(fd, recv_buf);
+        //阻塞收包，超时后检查退出标记
+        SockUtil::setNoBlocked(fd, false);
+        timeval tv = { 0, 100 * 1000 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        fds.emplace_back(fd);
+    }
+    if (attach) {
+        //临时加入reuseport组以挂载程序，绑定顺序即组内下标，无需校准
+        auto fd = SockUtil::bindUdpSock(port, "127.0.0.1", true);
+        auto attached = attach(fd, socket_count);
+        close(fd);
+        if (!attached) {
+            std::cerr << "attach reuseport cbpf failed" << std::endl;
+            exit(1);
+        }
+    }
+
+    std::atomic<bool> exit_flag { false };
+    std::atomic<uint64_t> mismatch { 0 };
+    std::atomic<uint64_t> unsteered { 0 };
+    ret.socket_pkts.assign(socket_count, 0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < socket_count; ++i) {
+        threads.emplace_back([&, i]() {
+            char buf[2048];
+            uint64_t pkts = 0;
+            while (!exit_flag) {
+                auto size = recv(fds[i], buf, sizeof(buf), 0);
+                if (size <= 0) {
+                    continue;
+                }
+                switch (on_recv(i, buf, size)) {
+                    case kIgnore: continue;
+                    case kMismatch: ++mismatch; break;
+                    case kUnsteered: ++unsteered; break;
+                    default: break;
+                }
+                ++pkts;
+            }
+            ret.socket_pkts[i] = pkts;
+        });
+    }
+
+    std::atomic<uint64_t> send_pkts { 0 };
+    std::atomic<bool> sending { true };
+    auto start = getCurrentMicrosecond();
+    auto dst = SockUtil::make_sockaddr("127.0.0.1", port);
+    for (size_t i = 0; i < sender_count; ++i) {
+        threads.emplace_back([&, i]() {
+            std::vector<int> socks;
+            for (size_t n = 0; n < kSrcPortPerSender; ++n) {
+                socks.emplace_back(SockUtil::bindUdpSock(0, "127.0.0.1", false));
+            }
+            send_pkts += on_send(i, socks, dst, sending, start);
+            for (auto fd : socks) {
+                close(fd);
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    sending = false;
+    auto stop = getCurrentMicrosecond();
+    //等待接收缓存中的数据被读完
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    exit_flag = true;
+    for (auto &th : threads) {
+        th.join();
+    }
+    for (auto fd : fds) {
+        close(fd);
+    }
+    ret.send_pkts = send_pkts;
+    for (auto pkts : ret.socket_pkts) {
+        ret.recv_pkts += pkts;
+    }
+    ret.mismatch = mismatch;
+    ret.unsteered = unsteered;
+    ret.seconds = (stop - start) / 1000000.0;
+    return ret;
+}
+
+} // namespace reuseport_bench
+
+#else
+
+int main(int argc, char *argv[]) {
+    std::cout << "reuseport steering is only supported on linux" << std::endl;
+    return 0;
+}
+
+#endif // defined(__linux__)
+#endif // ZLMEDIAKIT_TESTS_REUSEPORT_BENCH_H
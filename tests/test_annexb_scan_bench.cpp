@@ -0,0 +1,185 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <random>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include "Util/util.h"
+#include "ext-codec/H264.h"
+#include "ext-codec/AnnexB.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+using NaluList = vector<pair<size_t, size_t>>;
+
+//优化前的splitH264实现，作为性能与正确性的对照
+static const char *memfindLegacy(const char *buf, ssize_t len, const char *subbuf, ssize_t sublen) {
+    for (auto i = 0; i < len - sublen; ++i) {
+        if (memcmp(buf + i, subbuf, sublen) == 0) {
+            return buf + i;
+        }
+    }
+    return NULL;
+}
+
+static void splitH264Legacy(const char *ptr, size_t len, size_t prefix, const function<void(const char *, size_t, size_t)> &cb) {
+    auto start = ptr + prefix;
+    auto end = ptr + len;
+    size_t next_prefix;
+    while (true) {
+        auto next_start = memfindLegacy(start, end - start, "\x00\x00\x01", 3);
+        if (next_start) {
+            if (next_start > start && *(next_start - 1) == 0x00) {
+                next_start -= 1;
+                next_prefix = 4;
+            } else {
+                next_prefix = 3;
+            }
+            cb(start - prefix, next_start - start + prefix, prefix);
+            start = next_start + next_prefix;
+            prefix = next_prefix;
+            continue;
+        }
+        cb(start - prefix, end - start + prefix, prefix);
+        break;
+    }
+}
+
+//生成随机nalu负载，并做防竞争字节处理，保证负载中不会出现起始码
+static void appendNalu(string &out, mt19937 &rng, uint8_t nal_header, size_t size, bool long_prefix) {
+    out.append(long_prefix ? "\x00\x00\x00\x01" : "\x00\x00\x01", long_prefix ? 4 : 3);
+    out.push_back((char)nal_header);
+    //真实码流中0x00出现的频率远高于均匀分布
+    uniform_int_distribution<int> byte_dist(0, 255);
+    uniform_int_distribution<int> zero_dist(0, 15);
+    int zeros = 0;
+    for (size_t i = 0; i < size; ++i) {
+        uint8_t byte = zero_dist(rng) == 0 ? 0 : (uint8_t)byte_dist(rng);
+        if (zeros >= 2 && byte <= 3) {
+            out.push_back(0x03);
+            zeros = 0;
+        }
+        out.push_back((char)byte);
+        zeros = byte ? 0 : zeros + 1;
+    }
+    if (!out.back()) {
+        //rbsp尾部不能以0结尾
+        out.back() = (char)0x80;
+    }
+}
+
+//生成一个访问单元：aud + [sps pps sei] + 若干slice
+static string makeAccessUnit(mt19937 &rng, size_t bytes, bool key, int slices) {
+    string ret;
+    appendNalu(ret, rng, 0x09, 1, true);
+    if (key) {
+        appendNalu(ret, rng, 0x67, 24, true);
+        appendNalu(ret, rng, 0x68, 4, true);
+        appendNalu(ret, rng, 0x06, 32, false);
+    }
+    for (int i = 0; i < slices; ++i) {
+        appendNalu(ret, rng, key ? 0x65 : 0x41, bytes / slices, false);
+    }
+    return ret;
+}
+
+static vector<string> makeGop(size_t key_bytes, size_t p_bytes, int slices) {
+    mt19937 rng(1234);
+    vector<string> ret;
+    ret.emplace_back(makeAccessUnit(rng, key_bytes, true, slices));
+    for (int i = 1; i < 50; ++i) {
+        ret.emplace_back(makeAccessUnit(rng, p_bytes, false, slices));
+    }
+    return ret;
+}
+
+static vector<string> loadFile(const char *path) {
+    vector<string> ret;
+    ifstream in(path, ios::binary);
+    if (!in) {
+        cerr << "open file failed: " << path << endl;
+        return ret;
+    }
+    ret.emplace_back((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    return ret;
+}
+
+template <typename SPLIT>
+static NaluList splitAll(const vector<string> &aus, SPLIT &&split) {
+    NaluList ret;
+    for (auto &au : aus) {
+        split(au.data(), au.size(), prefixSize(au.data(), au.size()), [&](const char *ptr, size_t len, size_t prefix) {
+            ret.emplace_back(ptr - au.data(), len);
+        });
+    }
+    return ret;
+}
+
+template <typename SPLIT>
+static double bench(const vector<string> &aus, size_t total_bytes, SPLIT &&split) {
+    size_t rounds = 0;
+    size_t nalus = 0;
+    auto start = getCurrentMicrosecond();
+    auto now = start;
+    //至少运行1秒
+    while (now - start < 1000 * 1000) {
+        for (auto &au : aus) {
+            split(au.data(), au.size(), prefixSize(au.data(), au.size()), [&](const char *ptr, size_t len, size_t prefix) { ++nalus; });
+        }
+        ++rounds;
+        now = getCurrentMicrosecond();
+    }
+    if (!nalus) {
+        return 0;
+    }
+    return (double)total_bytes * rounds / ((now - start) / 1000000.0);
+}
+
+static void runCase(const string &name, const vector<string> &aus) {
+    size_t total_bytes = 0;
+    for (auto &au : aus) {
+        total_bytes += au.size();
+    }
+    auto legacy_out = splitAll(aus, splitH264Legacy);
+    auto simd_out = splitAll(aus, splitH264);
+    if (legacy_out != simd_out) {
+        cerr << name << ": split result mismatch, legacy=" << legacy_out.size() << ", " << getAnnexBScannerName() << "=" << simd_out.size() << endl;
+        exit(1);
+    }
+
+    auto legacy = bench(aus, total_bytes, splitH264Legacy);
+    auto simd = bench(aus, total_bytes, splitH264);
+    cout << name << ": " << aus.size() << " access units, " << total_bytes / 1024 << " KB, " << simd_out.size() << " nalus" << endl;
+    cout << "  legacy: " << legacy / (1024 * 1024) << " MB/s" << endl;
+    cout << "  " << getAnnexBScannerName() << ": " << simd / (1024 * 1024) << " MB/s, speedup " << simd / legacy << "x" << endl;
+}
+
+//用法: test_annexb_scan_bench [annexb_file...]
+//不指定文件时使用模拟的1080p/4K码流
+int main(int argc, char *argv[]) {
+    cout << "start code scanner: " << getAnnexBScannerName() << endl;
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            auto aus = loadFile(argv[i]);
+            if (!aus.empty()) {
+                runCase(argv[i], aus);
+            }
+        }
+        return 0;
+    }
+    runCase("1080p", makeGop(200 * 1024, 30 * 1024, 4));
+    runCase("4K", makeGop(800 * 1024, 120 * 1024, 8));
+    return 0;
+}
@@ -0,0 +1,117 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <vector>
+#include <iostream>
+#include "Util/logger.h"
+#include "Common/FrameGopCache.h"
+#include "ext-codec/H264.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+static Frame::Ptr makeFrame(uint8_t nal, uint64_t dts) {
+    auto frame = FrameImp::create<H264Frame>();
+    frame->_buffer.assign("\x00\x00\x00\x01", 4);
+    frame->_buffer.push_back((char)nal);
+    // first_mb_in_slice
+    frame->_buffer.push_back((char)0x80);
+    frame->_buffer.append(1000, 'x');
+    frame->_prefix_size = 4;
+    frame->_dts = dts;
+    return frame;
+}
+
+static int s_failed = 0;
+
+#define EXPECT(exp) \
+    if (!(exp)) { \
+        ErrorL << "check failed: " << #exp; \
+        ++s_failed; \
+    }
+
+// 模拟按需转协议的复用器，返回实际输入的帧
+class MockMuxer {
+public:
+    MockMuxer(const FrameGopCache::Ptr &cache) { _replayer.setGopCache(cache); }
+
+    void inputFrame(const Frame::Ptr &frame, bool enabled) {
+        if (!enabled) {
+            _replayer.onSkip();
+            return;
+        }
+        _replayer.onInput(frame, [this](const Frame::Ptr &cached) { _frames.emplace_back(cached); });
+        _frames.emplace_back(frame);
+    }
+
+    vector<Frame::Ptr> _frames;
+
+private:
+    FrameGopReplayer _replayer;
+};
+
+int main() {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+
+    auto cache = std::make_shared<FrameGopCache>();
+    MockMuxer late_muxer(cache);
+    MockMuxer resume_muxer(cache);
+
+    vector<Frame::Ptr> gop1 = { makeFrame(7, 0), makeFrame(8, 0), makeFrame(5, 0), makeFrame(1, 40), makeFrame(1, 80) };
+    vector<Frame::Ptr> gop2 = { makeFrame(7, 120), makeFrame(8, 120), makeFrame(5, 120), makeFrame(1, 160), makeFrame(1, 200) };
+
+    // 第一个gop: late_muxer无人观看，resume_muxer输入前两帧后无人观看
+    for (size_t i = 0; i < gop1.size(); ++i) {
+        cache->inputFrame(gop1[i], true);
+        late_muxer.inputFrame(gop1[i], false);
+        resume_muxer.inputFrame(gop1[i], i < 2);
+    }
+    EXPECT(cache->getFrameCount() == gop1.size());
+    EXPECT(cache->getFramesBefore(gop1[3]).size() == 3);
+    EXPECT(cache->getFramesBefore(makeFrame(1, 80)).empty());
+
+    // 第二个gop的第4帧时两者重新有人观看
+    for (size_t i = 0; i < gop2.size(); ++i) {
+        cache->inputFrame(gop2[i], true);
+        late_muxer.inputFrame(gop2[i], i >= 3);
+        resume_muxer.inputFrame(gop2[i], i >= 3);
+    }
+    EXPECT(cache->getFrameCount() == gop2.size());
+    EXPECT(cache->getBytes() == gop2.size() * gop2[0]->size());
+
+    // 补齐了第二个gop的前3帧，与之后的帧连续
+    EXPECT(late_muxer._frames.size() == gop2.size());
+    for (size_t i = 0; i < late_muxer._frames.size() && i < gop2.size(); ++i) {
+        EXPECT(late_muxer._frames[i] == gop2[i]);
+    }
+    // 整个gop都未输入过，同样补齐
+    EXPECT(resume_muxer._frames.size() == 2 + gop2.size());
+
+    // 在同一gop内恢复时不补齐，防止时间戳回退
+    auto same_gop_cache = std::make_shared<FrameGopCache>();
+    MockMuxer same_gop_muxer(same_gop_cache);
+    for (size_t i = 0; i < gop1.size(); ++i) {
+        same_gop_cache->inputFrame(gop1[i], true);
+        same_gop_muxer.inputFrame(gop1[i], i != 3);
+    }
+    EXPECT(same_gop_muxer._frames.size() == gop1.size() - 1);
+
+    // 没有视频时不缓存
+    cache->inputFrame(makeFrame(1, 240), false);
+    EXPECT(cache->getFrameCount() == 0 && cache->getBytes() == 0);
+
+    if (s_failed) {
+        ErrorL << s_failed << " checks failed";
+        return 1;
+    }
+    InfoL << "all checks passed";
+    return 0;
+}
@@ -0,0 +1,107 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <vector>
+#include <iostream>
+#include "Util/logger.h"
+#include "Util/util.h"
+#include "Thread/semaphore.h"
+#include "Poller/EventPoller.h"
+#include "Common/config.h"
+#include "Common/MediaSource.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+class BenchMediaSource : public MediaSource {
+public:
+    using Ptr = std::shared_ptr<BenchMediaSource>;
+    using MediaSource::MediaSource;
+    int readerCount() override { return 0; }
+};
+
+//该测试程序用于测试MediaSource注册表在所有poller线程并发注册/注销时的查找性能
+//用法: test_media_registry_bench [流个数(默认20000)] [测试时长秒(默认5)]
+int main(int argc, char *argv[]) {
+    //注册/注销会打印日志，只输出警告以上日志
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    size_t stream_count = argc > 1 ? atoi(argv[1]) : 20000;
+    uint64_t duration_ms = (argc > 2 ? atoi(argv[2]) : 5) * 1000;
+    auto poller_count = EventPollerPool::Instance().getExecutorSize();
+
+    vector<BenchMediaSource::Ptr> sources;
+    sources.reserve(stream_count);
+    for (size_t i = 0; i < stream_count; ++i) {
+        MediaTuple tuple;
+        tuple.vhost = DEFAULT_VHOST;
+        tuple.app = "live";
+        tuple.stream = "stream_" + to_string(i);
+        auto src = std::make_shared<BenchMediaSource>(RTSP_SCHEMA, tuple);
+        if (i % 2 == 0) {
+            //一半的流预先注册
+            src->regist();
+        }
+        sources.emplace_back(std::move(src));
+    }
+
+    atomic<uint64_t> total_find { 0 };
+    atomic<uint64_t> total_hit { 0 };
+    atomic<uint64_t> total_write { 0 };
+    semaphore sem;
+    size_t index = 0;
+    auto start = getCurrentMillisecond();
+    EventPollerPool::Instance().for_each([&](const TaskExecutor::Ptr &executor) {
+        auto poller_index = index++;
+        executor->async([&, poller_index]() {
+            uint64_t find = 0, hit = 0, write = 0;
+            size_t seed = poller_index * 7919 + 1;
+            while (getCurrentMillisecond() - start < duration_ms) {
+                for (int i = 0; i < 64; ++i) {
+                    seed = seed * 1103515245 + 12345;
+                    auto &src = sources[(seed >> 8) % stream_count];
+                    if (MediaSource::find(RTSP_SCHEMA, DEFAULT_VHOST, "live", src->getMediaTuple().stream)) {
+                        ++hit;
+                    }
+                    ++find;
+                }
+                //每个poller只修改属于自己的流，模拟各poller并发推流注册/注销
+                seed = seed * 1103515245 + 12345;
+                auto n = ((seed >> 8) % (stream_count / poller_count)) * poller_count + poller_index;
+                if (n < stream_count) {
+                    auto &src = sources[n];
+                    if (!src->unregist()) {
+                        src->regist();
+                    }
+                    ++write;
+                }
+            }
+            total_find += find;
+            total_hit += hit;
+            total_write += write;
+            sem.post();
+        });
+    });
+    for (size_t i = 0; i < poller_count; ++i) {
+        sem.wait();
+    }
+
+    auto elapsed = getCurrentMillisecond() - start;
+    cout << "pollers: " << poller_count << ", streams: " << stream_count << ", elapsed: " << elapsed << "ms" << endl;
+    cout << "find: " << total_find * 1000 / elapsed << "/s, hit rate: " << (total_find ? total_hit * 100 / total_find : 0) << "%" << endl;
+    cout << "regist/unregist: " << total_write * 1000 / elapsed << "/s" << endl;
+
+    size_t count = 0;
+    MediaSource::for_each_media([&](const MediaSource::Ptr &src) { ++count; }, RTSP_SCHEMA);
+    cout << "registered after test: " << count << endl;
+    return 0;
+}
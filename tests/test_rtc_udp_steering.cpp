@@ -0,0 +1,104 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "reuseport_bench.h"
+#include "Util/logger.h"
+#include "../webrtc/WebRtcUdpSteering.h"
+
+#if defined(__linux__)
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+using namespace reuseport_bench;
+
+//模拟的ufrag前缀，长度为WebRtcUdpSteering::kUfragTagPos
+static const char kUserPrefix[] = "AAAAAAAAAAA=_";
+
+//sender_count个发包线程轮流发送携带各socket标记的binding request，统计收包速率与分发正确性
+static RoundResult runRound(size_t socket_count, size_t sender_count, uint64_t duration_ms, bool steering) {
+    auto on_recv = [](size_t socket_index, const char *data, size_t size) {
+        if (size <= WebRtcUdpSteering::kStunTagOffset) {
+            return kIgnore;
+        }
+        auto index = WebRtcUdpSteering::tagToIndex(data[WebRtcUdpSteering::kStunTagOffset]);
+        if (index < 0) {
+            return kUnsteered;
+        }
+        return (size_t)index == socket_index ? kMatch : kMismatch;
+    };
+    auto on_send = [socket_count](size_t sender_index, const vector<int> &socks, const sockaddr_storage &dst, const atomic<bool> &sending, uint64_t start_us) {
+        vector<string> packets;
+        for (size_t index = 0; index < socket_count; ++index) {
+            auto transaction_id = makeRandStr(12, false);
+            //模拟浏览器binding request的大小
+            auto packet = WebRtcUdpSteering::makeBindingRequest(WebRtcUdpSteering::indexToTag(index), kUserPrefix, transaction_id.data());
+            packet.resize(100);
+            packets.emplace_back(std::move(packet));
+        }
+        uint64_t seq = sender_index;
+        while (sending) {
+            auto &packet = packets[seq % packets.size()];
+            ::sendto(socks[seq % socks.size()], packet.data(), packet.size(), 0, (struct sockaddr *)&dst, sizeof(sockaddr_in));
+            ++seq;
+        }
+        return seq - sender_index;
+    };
+    onAttach attach;
+    if (steering) {
+        attach = WebRtcUdpSteering::attachFilter;
+    }
+    return reuseport_bench::runRound(socket_count, sender_count, duration_ms, 4 * 1024 * 1024, attach, on_recv, on_send);
+}
+
+//该测试程序用于测试rtc udp端口使用多个SO_REUSEPORT socket并按ufrag标记分发时的收包性能与分发正确性
+//用法: test_rtc_udp_steering [最大socket个数(默认cpu核数)] [每轮测试时长秒(默认2)]
+int main(int argc, char *argv[]) {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+
+    size_t max_socket = argc > 1 ? atoi(argv[1]) : thread::hardware_concurrency();
+    uint64_t duration_ms = (argc > 2 ? atoi(argv[2]) : 2) * 1000;
+    max_socket = std::max<size_t>(1, std::min(max_socket, WebRtcUdpSteering::kMaxSocket));
+
+    //socket个数按1、2、4...递增，最后一轮为最大个数
+    vector<size_t> counts;
+    for (size_t count = 1; count < max_socket; count *= 2) {
+        counts.emplace_back(count);
+    }
+    counts.emplace_back(max_socket);
+
+    bool failed = false;
+    double base_pps = 0;
+    for (auto count : counts) {
+        //发包线程个数与socket个数相同，保证发包能力随之增长
+        auto result = runRound(count, count, duration_ms, true);
+        auto pps = result.recv_pkts / result.seconds;
+        if (count == 1) {
+            base_pps = pps;
+        }
+        cout << "sockets: " << count << ", recv: " << (uint64_t)pps << " pps, scale: " << pps / base_pps
+             << "x, mismatch: " << result.mismatch << ", unsteered: " << result.unsteered << endl;
+        if (result.mismatch || result.unsteered) {
+            failed = true;
+        }
+    }
+
+    //对照: 不挂载分发程序时由内核hash，数据包落在非所属线程的比例
+    auto result = runRound(max_socket, max_socket, duration_ms, false);
+    cout << "without steering, sockets: " << max_socket << ", recv: " << (uint64_t)(result.recv_pkts / result.seconds)
+         << " pps, misdelivered: " << (result.recv_pkts ? result.mismatch * 100 / result.recv_pkts : 0) << "%" << endl;
+    if (failed) {
+        cerr << "steering result is not as expected" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+#endif // defined(__linux__)
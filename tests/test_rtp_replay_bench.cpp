@@ -0,0 +1,766 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <mutex>
+#include <queue>
+#include <random>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include "Util/CMD.h"
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "Thread/semaphore.h"
+#include "Common/config.h"
+#include "Rtp/RtpProcess.h"
+#include "Rtp/GB28181Process.h"
+#include "Common/MultiMediaSourceMuxer.h"
+
+#if !defined(_WIN32)
+#include <time.h>
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+#if defined(ENABLE_RTPPROXY)
+
+class CMD_main : public CMD {
+public:
+    CMD_main() {
+        _parser.reset(new OptionParser(nullptr));
+
+        (*_parser) << Option('l',/*该选项简称，如果是\x00则说明无简称*/
+                             "level",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             to_string(LWarn).data(),/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "日志等级,LTrace~LError(0~4)",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('t', "threads", Option::ArgRequired, to_string(thread::hardware_concurrency()).data(), false,
+                             "启动事件触发线程数", nullptr);
+
+        (*_parser) << Option('i', "in", Option::ArgRequired, nullptr, true,
+                             "rtp dump文件路径，即rtp_proxy.dumpDir导出的*.rtp文件(2字节大端长度+rtp)", nullptr);
+
+        (*_parser) << Option('c', "count", Option::ArgRequired, "1", false, "并行回放的流个数", nullptr);
+
+        (*_parser) << Option('s', "speed", Option::ArgRequired, "1", false,
+                             "回放倍速，按rtp时间戳匀速回放；0为不限速，测试最大吞吐", nullptr);
+
+        (*_parser) << Option('n', "loop", Option::ArgRequired, "1", false, "每个流循环回放次数", nullptr);
+
+        (*_parser) << Option('m', "mode", Option::ArgRequired, "2", false,
+                             "测试阶段，0:只解复用(GB28181Process)，1:完整RtpProcess(解复用+协议复用)，2:依次测试两者并计算各阶段开销", nullptr);
+
+        (*_parser) << Option('p', "loss", Option::ArgRequired, "0", false, "模拟丢包率，单位百分比", nullptr);
+
+        (*_parser) << Option('r', "reorder", Option::ArgRequired, "0", false,
+                             "模拟乱序率，单位百分比，乱序包推迟1~3个包后输入", nullptr);
+
+        (*_parser) << Option('j', "jitter", Option::ArgRequired, "0", false,
+                             "模拟网络抖动，每个包随机推迟0~jitter毫秒输入，不限速回放时无效", nullptr);
+    }
+
+    ~CMD_main() override {}
+
+    const char *description() const override {
+        return "主程序命令参数";
+    }
+};
+
+struct ReplayOption {
+    size_t count = 1;
+    size_t loop = 1;
+    double speed = 1;
+    double loss = 0;
+    double reorder = 0;
+    uint64_t jitter_us = 0;
+};
+
+//dump文件中的一个rtp包
+struct RtpItem {
+    //在dump数据中的偏移
+    uint32_t offset;
+    uint16_t size;
+    uint16_t seq;
+    //是否为主pt(第一个rtp包的pt)，只有主pt的时间戳用于回放调度与时延统计
+    bool main_pt;
+    //主pt的时间戳，单位毫秒，与解复用输出帧的pts比较计算时延
+    uint32_t stamp_ms;
+    //按时间戳回放时相对开始的输入时间
+    uint64_t due_us;
+    //负载中pes时间戳(pts/dts)在RtpDump::pes_stamps中的起始下标与个数
+    uint32_t pes_begin;
+    uint8_t pes_count;
+};
+
+struct RtpDump {
+    string data;
+    vector<RtpItem> items;
+    //ps/ts负载中pes时间戳字段(5字节)在data中的偏移
+    vector<uint32_t> pes_stamps;
+    //主pt的时钟频率
+    uint32_t clock_rate = 90000;
+    //循环回放时seq的增量
+    uint16_t seq_span = 0;
+    //循环回放时rtp时间戳的增量，单位为时钟频率
+    uint32_t rtp_stamp_span = 0;
+    //循环回放时pes时间戳的增量，单位为90K
+    uint64_t pes_stamp_span = 0;
+    //单次回放的时长
+    uint64_t loop_us = 0;
+};
+
+struct PassResult {
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t dropped = 0;
+    uint64_t errors = 0;
+    uint64_t frames = 0;
+    uint64_t video_frames = 0;
+    //输入rtp时所在线程的cpu耗时
+    uint64_t cpu_us = 0;
+    uint64_t process_cpu_us = 0;
+    uint64_t wall_us = 0;
+    vector<uint64_t> latency_us;
+};
+
+static uint64_t getThreadCpuUs() {
+#if !defined(_WIN32)
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+#else
+    return getCurrentMicrosecond(true);
+#endif
+}
+
+static uint64_t getProcessCpuUs() {
+#if !defined(_WIN32)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#else
+    return 0;
+#endif
+}
+
+//pes时间戳为33位，分布在5个字节中，带有前缀与marker位
+static constexpr uint64_t kPesStampMask = (1ULL << 33) - 1;
+
+static uint64_t readPesStamp(const uint8_t *ptr) {
+    return (((uint64_t)ptr[0] >> 1) & 0x07) << 30 | (uint64_t)ptr[1] << 22 | ((uint64_t)ptr[2] >> 1) << 15 | (uint64_t)ptr[3] << 7 | ptr[4] >> 1;
+}
+
+static void writePesStamp(uint8_t *ptr, uint64_t stamp) {
+    ptr[0] = (ptr[0] & 0xF1) | (((stamp >> 30) & 0x07) << 1);
+    ptr[1] = (stamp >> 22) & 0xFF;
+    ptr[2] = (((stamp >> 15) & 0x7F) << 1) | 0x01;
+    ptr[3] = (stamp >> 7) & 0xFF;
+    ptr[4] = ((stamp & 0x7F) << 1) | 0x01;
+}
+
+static bool isPesStamp(const uint8_t *ptr, uint8_t prefix) {
+    return (ptr[0] >> 4) == prefix && (ptr[0] & 0x01) && (ptr[2] & 0x01) && (ptr[4] & 0x01);
+}
+
+//查找rtp负载(ps/ts)中完整的音视频pes头，记录其中pts/dts字段的偏移，跨rtp包的pes头不做修改
+//h264/h265的nal头最高位为0，所以00 00 01后跟0xC0~0xEF时不会是es的起始码
+static void findPesStamps(const string &data, size_t offset, size_t size, vector<uint32_t> &out) {
+    auto ptr = (const uint8_t *)data.data() + offset;
+    size_t header = 12 + (ptr[0] & 0x0F) * 4;
+    if ((ptr[0] & 0x10) && header + 4 <= size) {
+        header += 4 + (((ptr[header + 2] << 8) | ptr[header + 3]) * 4);
+    }
+    for (size_t i = header; i + 14 <= size; ++i) {
+        auto pes = ptr + i;
+        if (pes[0] || pes[1] || pes[2] != 1 || pes[3] < 0xC0 || pes[3] > 0xEF || (pes[6] & 0xC0) != 0x80) {
+            continue;
+        }
+        auto flags = pes[7] >> 6;
+        if (flags == 2 && isPesStamp(pes + 9, 0x02)) {
+            out.emplace_back((uint32_t)(offset + i + 9));
+        } else if (flags == 3 && i + 19 <= size && isPesStamp(pes + 9, 0x03) && isPesStamp(pes + 14, 0x01)) {
+            out.emplace_back((uint32_t)(offset + i + 9));
+            out.emplace_back((uint32_t)(offset + i + 14));
+        } else {
+            continue;
+        }
+        i += 13;
+    }
+}
+
+static bool loadDump(const string &path, RtpDump &dump) {
+    std::shared_ptr<FILE> fp(fopen(path.data(), "rb"), [](FILE *fp) {
+        if (fp) {
+            fclose(fp);
+        }
+    });
+    if (!fp) {
+        WarnL << "open file failed:" << path;
+        return false;
+    }
+    char buf[64 * 1024];
+    size_t size;
+    while ((size = fread(buf, 1, sizeof(buf), fp.get())) > 0) {
+        dump.data.append(buf, size);
+    }
+
+    int main_pt = -1;
+    uint32_t &clock_rate = dump.clock_rate;
+    uint32_t first_stamp = 0;
+    uint32_t last_stamp = 0;
+    int64_t max_stamp_diff = 0;
+    int64_t first_pes_stamp = -1;
+    int64_t max_pes_diff = 0;
+    uint64_t due_us = 0;
+    size_t offset = 0;
+    while (offset + 2 <= dump.data.size()) {
+        auto ptr = (const uint8_t *)dump.data.data() + offset;
+        uint16_t len = (ptr[0] << 8) | ptr[1];
+        if (len < 12 || offset + 2 + len > dump.data.size()) {
+            WarnL << "Invalid rtp size: " << len << ", offset: " << offset;
+            break;
+        }
+        ptr += 2;
+        RtpItem item;
+        item.offset = (uint32_t)(offset + 2);
+        item.size = len;
+        item.seq = (ptr[2] << 8) | ptr[3];
+        auto pt = ptr[1] & 0x7F;
+        auto stamp = (uint32_t)((ptr[4] << 24) | (ptr[5] << 16) | (ptr[6] << 8) | ptr[7]);
+        if (main_pt == -1) {
+            main_pt = pt;
+            //g711为8K采样率，ps/ts/视频为90K
+            clock_rate = (pt == 0 || pt == 8) ? 8000 : 90000;
+            first_stamp = last_stamp = stamp;
+        }
+        item.main_pt = pt == main_pt;
+        item.stamp_ms = (uint32_t)(stamp / (clock_rate / 1000));
+        item.pes_begin = (uint32_t)dump.pes_stamps.size();
+        if (item.main_pt) {
+            findPesStamps(dump.data, item.offset, len, dump.pes_stamps);
+            for (auto i = item.pes_begin; i < dump.pes_stamps.size(); ++i) {
+                auto pes_stamp = (int64_t)readPesStamp((const uint8_t *)dump.data.data() + dump.pes_stamps[i]);
+                if (first_pes_stamp == -1) {
+                    first_pes_stamp = pes_stamp;
+                }
+                //音频pts可能略早于第一个pes，忽略负数差值
+                auto diff = (uint64_t)(pes_stamp - first_pes_stamp) & kPesStampMask;
+                if (diff < (1ULL << 32)) {
+                    max_pes_diff = std::max(max_pes_diff, (int64_t)diff);
+                }
+            }
+            max_stamp_diff = std::max(max_stamp_diff, (int64_t)(int32_t)(stamp - first_stamp));
+            //时间戳回退或跳跃过大时不等待，与test_rtp一致
+            auto diff_us = (int64_t)(int32_t)(stamp - last_stamp) * 1000000 / clock_rate;
+            if (diff_us > 0 && diff_us <= 500 * 1000) {
+                due_us += diff_us;
+            }
+            last_stamp = stamp;
+        }
+        item.due_us = due_us;
+        item.pes_count = (uint8_t)std::min<size_t>(dump.pes_stamps.size() - item.pes_begin, 0xFF);
+        dump.items.emplace_back(item);
+        offset += 2 + len;
+    }
+    if (dump.items.empty()) {
+        return false;
+    }
+    dump.seq_span = dump.items.back().seq - dump.items.front().seq + 1;
+    //两次回放之间间隔一帧
+    dump.loop_us = due_us + 40 * 1000;
+    //循环回放时时间戳也间隔一帧递增，保证关闭modify_stamp时时间戳不回退
+    dump.rtp_stamp_span = (uint32_t)max_stamp_diff + clock_rate / 25;
+    dump.pes_stamp_span = (uint64_t)max_pes_diff + 90000 / 25;
+    return true;
+}
+
+//解复用阶段的帧输出
+class FrameSink : public MediaSinkInterface {
+public:
+    using onFrame = function<void(const Frame::Ptr &frame)>;
+
+    FrameSink(onFrame cb) { _cb = std::move(cb); }
+
+    bool inputFrame(const Frame::Ptr &frame) override {
+        _cb(frame);
+        return true;
+    }
+
+    bool addTrack(const Track::Ptr &track) override { return true; }
+
+private:
+    onFrame _cb;
+};
+
+/**
+ * 在所属poller线程回放一个流，所有成员只在该线程访问
+ */
+class ReplayStream : public std::enable_shared_from_this<ReplayStream> {
+public:
+    using Ptr = std::shared_ptr<ReplayStream>;
+    using onDone = function<void(ReplayStream &stream)>;
+
+    ReplayStream(size_t index, EventPoller::Ptr poller, const RtpDump &dump, const ReplayOption &option, bool full)
+        : _full(full)
+        , _dump(dump)
+        , _option(option)
+        , _rng((uint32_t)index) {
+        _poller = std::move(poller);
+        _tuple = MediaTuple { DEFAULT_VHOST, kRtpAppName, "replay_" + to_string(index), "" };
+        _total = _dump.items.size() * _option.loop;
+        memset(&_addr, 0, sizeof(_addr));
+        _addr.ss_family = AF_INET;
+    }
+
+    const MediaTuple &getTuple() const { return _tuple; }
+    const EventPoller::Ptr &getPoller() const { return _poller; }
+    const PassResult &getResult() const { return _result; }
+
+    void start(onDone cb) {
+        _on_done = std::move(cb);
+        weak_ptr<ReplayStream> weak_self = shared_from_this();
+        _poller->async([weak_self]() {
+            auto strong_self = weak_self.lock();
+            if (!strong_self) {
+                return;
+            }
+            strong_self->createProcess();
+            strong_self->_start_us = getCurrentMicrosecond();
+            strong_self->schedule(0);
+        });
+    }
+
+    //协议复用器注册后在所属poller线程调用，读取复用器输出的帧
+    void attachMuxer(const MultiMediaSourceMuxer::Ptr &muxer) {
+        if (_reader || !_process) {
+            return;
+        }
+        weak_ptr<ReplayStream> weak_self = shared_from_this();
+        _reader = muxer->getFrameRing()->attach(_poller, false);
+        _reader->setReadCB([weak_self](const Frame::Ptr &frame) {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->onFrame(frame);
+            }
+        });
+    }
+
+private:
+    struct Pending {
+        uint64_t key;
+        uint64_t pos;
+        bool operator>(const Pending &that) const { return key != that.key ? key > that.key : pos > that.pos; }
+    };
+
+    void createProcess() {
+        if (_full) {
+            _sock = Socket::createSocket(_poller, false);
+            _process = RtpProcess::createProcess(_tuple);
+            return;
+        }
+        MediaInfo info;
+        info.schema = "rtp";
+        static_cast<MediaTuple &>(info) = _tuple;
+        _sink = std::make_shared<FrameSink>([this](const Frame::Ptr &frame) { onFrame(frame); });
+        _demuxer = std::make_shared<GB28181Process>(info, _sink.get());
+    }
+
+    void schedule(uint64_t delay_ms) {
+        weak_ptr<ReplayStream> weak_self = shared_from_this();
+        auto task = [weak_self]() -> uint64_t {
+            auto strong_self = weak_self.lock();
+            if (!strong_self) {
+                return 0;
+            }
+            auto next = strong_self->step();
+            if (next < 0) {
+                strong_self->finish();
+                return 0;
+            }
+            if (next == 0) {
+                //不限速回放，让出线程后继续，保证同一poller上的流公平调度
+                strong_self->_poller->async([weak_self]() {
+                    if (auto strong_self = weak_self.lock()) {
+                        strong_self->schedule(0);
+                    }
+                }, false);
+                return 0;
+            }
+            return next;
+        };
+        if (delay_ms) {
+            _poller->doDelayTask(delay_ms, task);
+        } else {
+            auto next = task();
+            if (next) {
+                _poller->doDelayTask(next, task);
+            }
+        }
+    }
+
+    //相对开始的输入时间，不含抖动
+    uint64_t dueOf(uint64_t pos) const {
+        pos = std::min<uint64_t>(pos, _total - 1);
+        auto &item = _dump.items[pos % _dump.items.size()];
+        return (pos / _dump.items.size()) * _dump.loop_us + item.due_us;
+    }
+
+    bool realtime() const { return _option.speed > 0; }
+
+    void enqueue(uint64_t pos) {
+        uniform_real_distribution<double> percent(0, 100);
+        if (_option.loss > 0 && percent(_rng) < _option.loss) {
+            ++_result.dropped;
+            return;
+        }
+        uint64_t key = realtime() ? dueOf(pos) : pos * 1000;
+        if (realtime() && _option.jitter_us) {
+            //抖动为实际时间，换算到回放时间轴
+            key += (uint64_t)(uniform_int_distribution<uint64_t>(0, _option.jitter_us)(_rng) * _option.speed);
+        }
+        if (_option.reorder > 0 && percent(_rng) < _option.reorder) {
+            auto later = pos + uniform_int_distribution<uint64_t>(1, 3)(_rng);
+            key = std::max(key, (realtime() ? dueOf(later) : later * 1000) + 1);
+        }
+        _pending.push(Pending { key, pos });
+    }
+
+    //输入到期的rtp，返回下次调度的延时(毫秒)，0为立即继续，-1为回放结束
+    int64_t step() {
+        if (!realtime()) {
+            auto end = std::min<uint64_t>(_cursor + 256, _total);
+            while (_cursor < end) {
+                enqueue(_cursor++);
+            }
+            auto limit = _cursor < _total ? (_cursor - 1) * 1000 : UINT64_MAX;
+            while (!_pending.empty() && _pending.top().key <= limit) {
+                feed(_pending.top().pos);
+                _pending.pop();
+            }
+            return _cursor >= _total && _pending.empty() ? -1 : 0;
+        }
+
+        auto now = (uint64_t)((getCurrentMicrosecond() - _start_us) * _option.speed);
+        while (_cursor < _total && dueOf(_cursor) <= now) {
+            enqueue(_cursor++);
+        }
+        while (!_pending.empty() && _pending.top().key <= now) {
+            feed(_pending.top().pos);
+            _pending.pop();
+        }
+        if (_cursor >= _total && _pending.empty()) {
+            return -1;
+        }
+        auto next = std::min(_cursor < _total ? dueOf(_cursor) : UINT64_MAX, _pending.empty() ? UINT64_MAX : _pending.top().key);
+        return std::max<int64_t>(1, (int64_t)((next - now) / _option.speed / 1000));
+    }
+
+    void feed(uint64_t pos) {
+        auto &item = _dump.items[pos % _dump.items.size()];
+        memcpy(_buf, _dump.data.data() + item.offset, item.size);
+        //循环回放时seq与时间戳保持连续
+        auto loop = pos / _dump.items.size();
+        uint16_t seq = item.seq + (uint16_t)(loop * _dump.seq_span);
+        _buf[2] = seq >> 8;
+        _buf[3] = seq & 0xFF;
+        auto stamp_ms = item.stamp_ms;
+        if (loop) {
+            auto rtp_offset = (uint32_t)(loop * _dump.rtp_stamp_span);
+            auto ptr = (uint8_t *)_buf;
+            auto stamp = (uint32_t)((ptr[4] << 24) | (ptr[5] << 16) | (ptr[6] << 8) | ptr[7]) + rtp_offset;
+            ptr[4] = stamp >> 24;
+            ptr[5] = (stamp >> 16) & 0xFF;
+            ptr[6] = (stamp >> 8) & 0xFF;
+            ptr[7] = stamp & 0xFF;
+            stamp_ms = (uint32_t)(stamp / (_dump.clock_rate / 1000));
+            for (auto i = item.pes_begin; i < item.pes_begin + item.pes_count; ++i) {
+                auto field = ptr + (_dump.pes_stamps[i] - item.offset);
+                writePesStamp(field, (readPesStamp(field) + loop * _dump.pes_stamp_span) & kPesStampMask);
+            }
+        }
+
+        auto now = getCurrentMicrosecond();
+        if (item.main_pt) {
+            //记录每帧第一个rtp的输入时间，残留的旧记录(丢包导致)超时后覆盖
+            auto it = _input_time.find(stamp_ms);
+            if (it == _input_time.end()) {
+                if (_input_time.size() > 4096) {
+                    _input_time.clear();
+                }
+                _input_time.emplace(stamp_ms, now);
+            } else if (now - it->second > 5 * 1000 * 1000) {
+                it->second = now;
+            }
+        }
+
+        auto cpu = getThreadCpuUs();
+        try {
+            if (_full) {
+                uint64_t dts = 0;
+                //传入dts_out，无人观看时也完整处理
+                _process->inputRtp(true, _sock, _buf, item.size, (struct sockaddr *)&_addr, &dts);
+            } else {
+                _demuxer->inputRtp(true, _buf, item.size);
+            }
+        } catch (std::exception &ex) {
+            if (!_result.errors++) {
+                WarnL << _tuple.shortUrl() << " input rtp failed: " << ex.what();
+            }
+        }
+        _result.cpu_us += getThreadCpuUs() - cpu;
+        ++_result.packets;
+        _result.bytes += item.size;
+    }
+
+    void onFrame(const Frame::Ptr &frame) {
+        ++_result.frames;
+        if (frame->getTrackType() != TrackVideo) {
+            return;
+        }
+        ++_result.video_frames;
+        //同一时间戳的多个帧(如sps/pps/idr)只统计第一个
+        if (frame->pts() == _last_pts) {
+            return;
+        }
+        _last_pts = frame->pts();
+        //rtp时间戳与帧pts一致时(国标设备一般如此)才能计算时延
+        auto it = _input_time.find((uint32_t)frame->pts());
+        if (it != _input_time.end()) {
+            _result.latency_us.emplace_back(getCurrentMicrosecond() - it->second);
+            _input_time.erase(it);
+        }
+    }
+
+    void finish() {
+        if (_full) {
+            _process->flush();
+        } else {
+            _demuxer->flush();
+        }
+        weak_ptr<ReplayStream> weak_self = shared_from_this();
+        //等待复用器输出的帧被读取
+        _poller->doDelayTask(_full ? 500 : 1, [weak_self]() -> uint64_t {
+            auto strong_self = weak_self.lock();
+            if (!strong_self) {
+                return 0;
+            }
+            strong_self->_reader = nullptr;
+            strong_self->_process = nullptr;
+            strong_self->_demuxer = nullptr;
+            strong_self->_on_done(*strong_self);
+            return 0;
+        });
+    }
+
+private:
+    bool _full;
+    const RtpDump &_dump;
+    ReplayOption _option;
+    mt19937 _rng;
+    MediaTuple _tuple;
+    EventPoller::Ptr _poller;
+    onDone _on_done;
+
+    uint64_t _total = 0;
+    uint64_t _cursor = 0;
+    uint64_t _start_us = 0;
+    priority_queue<Pending, vector<Pending>, greater<Pending>> _pending;
+    char _buf[0xFFFF];
+
+    struct sockaddr_storage _addr;
+    Socket::Ptr _sock;
+    RtpProcess::Ptr _process;
+    std::shared_ptr<FrameSink> _sink;
+    GB28181Process::Ptr _demuxer;
+    MultiMediaSourceMuxer::RingType::RingReader::Ptr _reader;
+
+    uint64_t _last_pts = UINT64_MAX;
+    unordered_map<uint32_t, uint64_t> _input_time;
+    PassResult _result;
+};
+
+static PassResult runPass(const RtpDump &dump, const ReplayOption &option, bool full) {
+    vector<EventPoller::Ptr> pollers;
+    EventPollerPool::Instance().for_each([&](const TaskExecutor::Ptr &executor) {
+        pollers.emplace_back(static_pointer_cast<EventPoller>(executor));
+    });
+
+    mutex mtx;
+    semaphore sem;
+    PassResult ret;
+    size_t remain = option.count;
+    unordered_map<string, ReplayStream::Ptr> streams;
+    for (size_t i = 0; i < option.count; ++i) {
+        auto stream = std::make_shared<ReplayStream>(i, pollers[i % pollers.size()], dump, option, full);
+        streams.emplace(stream->getTuple().stream, stream);
+    }
+
+    //完整模式下读取协议复用器输出的帧
+    static char tag;
+    if (full) {
+        NoticeCenter::Instance().addListener(&tag, Broadcast::kBroadcastMediaChanged, [&](BroadcastMediaChangedArgs) {
+            if (!bRegist || sender.getMediaTuple().app != kRtpAppName) {
+                return;
+            }
+            auto muxer = sender.getMuxer();
+            auto it = streams.find(sender.getMediaTuple().stream);
+            if (!muxer || it == streams.end()) {
+                return;
+            }
+            weak_ptr<ReplayStream> weak_stream = it->second;
+            it->second->getPoller()->async([weak_stream, muxer]() {
+                if (auto stream = weak_stream.lock()) {
+                    stream->attachMuxer(muxer);
+                }
+            });
+        });
+    }
+
+    auto cpu = getProcessCpuUs();
+    auto start = getCurrentMicrosecond();
+    for (auto &pr : streams) {
+        pr.second->start([&](ReplayStream &stream) {
+            auto &result = stream.getResult();
+            lock_guard<mutex> lck(mtx);
+            ret.packets += result.packets;
+            ret.bytes += result.bytes;
+            ret.dropped += result.dropped;
+            ret.errors += result.errors;
+            ret.frames += result.frames;
+            ret.video_frames += result.video_frames;
+            ret.cpu_us += result.cpu_us;
+            ret.latency_us.insert(ret.latency_us.end(), result.latency_us.begin(), result.latency_us.end());
+            if (--remain == 0) {
+                sem.post();
+            }
+        });
+    }
+    sem.wait();
+    ret.wall_us = getCurrentMicrosecond() - start;
+    ret.process_cpu_us = getProcessCpuUs() - cpu;
+    if (full) {
+        NoticeCenter::Instance().delListener(&tag, Broadcast::kBroadcastMediaChanged);
+    }
+    return ret;
+}
+
+static void printResult(const char *name, const ReplayOption &option, PassResult &result) {
+    auto seconds = result.wall_us / 1000000.0;
+    cout << "[" << name << "] streams: " << option.count << ", wall: " << seconds << "s"
+         << ", packets: " << result.packets << " (" << (uint64_t)(result.packets / seconds) << " pps, "
+         << result.bytes * 8 / 1000000.0 / seconds << " Mbps), dropped: " << result.dropped << ", errors: " << result.errors << endl;
+    cout << "[" << name << "] frames: " << result.frames << " (" << (uint64_t)(result.frames / seconds) << " fps), video frames: "
+         << result.video_frames << " (" << (uint64_t)(result.video_frames / seconds) << " fps)" << endl;
+    cout << "[" << name << "] ingest cpu: " << result.cpu_us / 1000 << "ms, "
+         << (result.packets ? (double)result.cpu_us / result.packets : 0) << "us/pkt, "
+         << (result.video_frames ? (double)result.cpu_us / result.video_frames : 0) << "us/video frame, process cpu: "
+         << result.process_cpu_us * 100.0 / result.wall_us << "%" << endl;
+    auto &latency = result.latency_us;
+    if (latency.empty()) {
+        cout << "[" << name << "] latency: n/a (rtp timestamp does not match frame pts)" << endl;
+        return;
+    }
+    sort(latency.begin(), latency.end());
+    uint64_t sum = 0;
+    for (auto us : latency) {
+        sum += us;
+    }
+    cout << "[" << name << "] latency(" << latency.size() << " frames): avg " << sum / latency.size() / 1000.0
+         << "ms, p50 " << latency[latency.size() / 2] / 1000.0 << "ms, p99 " << latency[latency.size() * 99 / 100] / 1000.0
+         << "ms, max " << latency.back() / 1000.0 << "ms" << endl;
+}
+
+//该测试程序用于回放rtp_proxy.dumpDir导出的rtp(ps/ts/es) dump文件，测试多路并行时RtpProcess的吞吐、各阶段cpu开销与时延
+//可模拟丢包、乱序与网络抖动，用于升级前离线回归国标推流接入性能
+int main(int argc, char *argv[]) {
+    CMD_main cmd_main;
+    try {
+        cmd_main.operator()(argc, argv);
+    } catch (ExitException &) {
+        return 0;
+    } catch (std::exception &ex) {
+        cout << ex.what() << endl;
+        return -1;
+    }
+
+    int threads = cmd_main["threads"];
+    LogLevel logLevel = (LogLevel) cmd_main["level"].as<int>();
+    logLevel = MIN(MAX(logLevel, LTrace), LError);
+    auto mode = cmd_main["mode"].as<int>();
+    ReplayOption option;
+    option.count = std::max(1, cmd_main["count"].as<int>());
+    option.loop = std::max(1, cmd_main["loop"].as<int>());
+    option.speed = std::max(0.0, cmd_main["speed"].as<double>());
+    option.loss = cmd_main["loss"].as<double>();
+    option.reorder = cmd_main["reorder"].as<double>();
+    option.jitter_us = std::max(0, cmd_main["jitter"].as<int>()) * 1000;
+
+    //设置日志
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", logLevel));
+    //启动异步日志线程
+    Logger::Instance().setWriter(std::make_shared<AsyncLogWriter>());
+    //设置线程数
+    EventPollerPool::setPoolSize(threads);
+
+    loadIniConfig((exeDir() + "config.ini").data());
+    //复用器输出帧保持源时间戳，以便与输入rtp对应计算时延，循环回放时rtp与pes时间戳按轮次递增
+    mINI::Instance()[Protocol::kModifyStamp] = (int)ProtocolOption::kModifyStampOff;
+    //各阶段cpu开销统计的是输入rtp线程的cpu耗时，协议复用必须在该线程完成
+    mINI::Instance()[Protocol::kParallelMux] = 0;
+    //回放时不再导出
+    mINI::Instance()[RtpProxy::kDumpDir] = "";
+
+    RtpDump dump;
+    if (!loadDump(cmd_main["in"], dump)) {
+        ErrorL << "load rtp dump failed: " << cmd_main["in"];
+        return -1;
+    }
+    cout << "rtp dump: " << dump.items.size() << " packets, " << dump.data.size() / 1024 << "KB, duration: "
+         << dump.items.back().due_us / 1000 << "ms" << endl;
+
+    bool ok = true;
+    PassResult demux, full;
+    if (mode == 0 || mode == 2) {
+        demux = runPass(dump, option, false);
+        printResult("demux", option, demux);
+        ok = ok && demux.video_frames;
+    }
+    if (mode == 1 || mode == 2) {
+        full = runPass(dump, option, true);
+        printResult("full", option, full);
+        ok = ok && full.video_frames;
+    }
+    if (mode == 2 && demux.packets && full.packets) {
+        auto demux_us = (double)demux.cpu_us / demux.packets;
+        auto full_us = (double)full.cpu_us / full.packets;
+        cout << "[stage] demux(sort+ps/ts demux): " << demux_us << "us/pkt, mux(protocol muxers): "
+             << std::max(0.0, full_us - demux_us) << "us/pkt" << endl;
+    }
+    if (!ok) {
+        cerr << "no video frame decoded" << endl;
+        return -1;
+    }
+    return 0;
+}
+
+#else
+
+int main(int argc, char *argv[]) {
+    std::cout << "please ENABLE_RTPPROXY and then test" << std::endl;
+    return 0;
+}
+
+#endif // defined(ENABLE_RTPPROXY)
@@ -0,0 +1,120 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <cstring>
+#include "reuseport_bench.h"
+#include "Util/logger.h"
+#include "Rtp/RtpUdpSteering.h"
+
+#if defined(__linux__)
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+using namespace reuseport_bench;
+
+//模拟国标rtp包大小
+static constexpr size_t kRtpSize = 1400;
+
+//sender_count个发包线程按码率匀速发送camera_count路摄像头的rtp(每路一个ssrc)，统计收包速率、各socket负载与分发正确性
+static RoundResult runRound(size_t socket_count, size_t sender_count, size_t camera_count, uint64_t kbps, uint64_t duration_ms, bool steering) {
+    auto on_recv = [socket_count, steering](size_t socket_index, const char *data, size_t size) {
+        if (size < RtpUdpSteering::kSSRCOffset + 4) {
+            return kIgnore;
+        }
+        uint32_t ssrc;
+        memcpy(&ssrc, data + RtpUdpSteering::kSSRCOffset, 4);
+        if (steering && RtpUdpSteering::ssrcToIndex(ntohl(ssrc), socket_count) != socket_index) {
+            return kMismatch;
+        }
+        return kMatch;
+    };
+    //每路摄像头每秒的rtp包数
+    auto camera_pps = kbps * 1000 / 8 / kRtpSize;
+    auto on_send = [=](size_t sender_index, const vector<int> &socks, const sockaddr_storage &dst, const atomic<bool> &sending, uint64_t start_us) {
+        //本线程负责的摄像头，ssrc采用国标格式的十进制数
+        vector<string> packets;
+        for (size_t camera = sender_index; camera < camera_count; camera += sender_count) {
+            string packet(kRtpSize, '\0');
+            packet[0] = (char)0x80;
+            packet[1] = 96;
+            uint32_t ssrc = htonl((uint32_t)(100000000 + camera));
+            memcpy(&packet[RtpUdpSteering::kSSRCOffset], &ssrc, 4);
+            packets.emplace_back(std::move(packet));
+        }
+        uint64_t sent = 0;
+        if (packets.empty()) {
+            return sent;
+        }
+        auto pps = camera_pps * packets.size();
+        while (sending) {
+            //按码率匀速发送，发送能力不足时尽力发送
+            auto expected = (getCurrentMicrosecond() - start_us) * pps / 1000000;
+            if (sent >= expected) {
+                this_thread::sleep_for(chrono::microseconds(500));
+                continue;
+            }
+            for (; sent < expected && sending; ++sent) {
+                auto index = sent % packets.size();
+                ::sendto(socks[index % socks.size()], packets[index].data(), kRtpSize, 0, (struct sockaddr *)&dst, sizeof(sockaddr_in));
+            }
+        }
+        return sent;
+    };
+    onAttach attach;
+    if (steering) {
+        attach = RtpUdpSteering::attachFilter;
+    }
+    return reuseport_bench::runRound(socket_count, sender_count, duration_ms, 8 * 1024 * 1024, attach, on_recv, on_send);
+}
+
+static void printResult(const char *name, size_t socket_count, const RoundResult &result) {
+    auto avg = result.recv_pkts / socket_count;
+    auto max_socket_pkts = *std::max_element(result.socket_pkts.begin(), result.socket_pkts.end());
+    auto min_socket_pkts = *std::min_element(result.socket_pkts.begin(), result.socket_pkts.end());
+    cout << name << ", sockets: " << socket_count << ", send: " << (uint64_t)(result.send_pkts / result.seconds)
+         << " pps, recv: " << (uint64_t)(result.recv_pkts / result.seconds) << " pps, loss: "
+         << (result.send_pkts ? (double)(result.send_pkts - std::min(result.send_pkts, result.recv_pkts)) * 100 / result.send_pkts : 0)
+         << "%, busiest socket: " << (avg ? (double)max_socket_pkts / avg : 0) << "x avg, idlest socket: "
+         << (avg ? (double)min_socket_pkts / avg : 0) << "x avg, mismatch: " << result.mismatch << endl;
+}
+
+//该测试程序用于测试单端口udp rtp服务器使用多个SO_REUSEPORT socket并按ssrc分发时的收包性能、负载均衡与分发正确性
+//用法: test_rtp_udp_steering [socket个数(默认cpu核数)] [摄像头路数(默认5000)] [每路码率kbps(默认2000)] [测试时长秒(默认2)]
+int main(int argc, char *argv[]) {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+
+    size_t socket_count = argc > 1 ? atoi(argv[1]) : thread::hardware_concurrency();
+    size_t camera_count = argc > 2 ? atoi(argv[2]) : 5000;
+    uint64_t kbps = argc > 3 ? atoi(argv[3]) : 2000;
+    uint64_t duration_ms = (argc > 4 ? atoi(argv[4]) : 2) * 1000;
+    socket_count = std::max<size_t>(1, socket_count);
+    camera_count = std::max<size_t>(1, camera_count);
+    //发包线程个数与socket个数相同
+    auto sender_count = socket_count;
+
+    cout << "cameras: " << camera_count << ", bitrate: " << kbps << " kbps, offered: "
+         << camera_count * (kbps * 1000 / 8 / kRtpSize) << " pps" << endl;
+
+    auto result = runRound(socket_count, sender_count, camera_count, kbps, duration_ms, true);
+    printResult("ssrc steering", socket_count, result);
+
+    //对照: 不挂载分发程序时由内核按四元组hash，源端口较少时各socket负载不均
+    auto hashed = runRound(socket_count, sender_count, camera_count, kbps, duration_ms, false);
+    printResult("4-tuple hash", socket_count, hashed);
+
+    if (result.mismatch) {
+        cerr << "steering result is not as expected" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+#endif // defined(__linux__)
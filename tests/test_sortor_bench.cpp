@@ -0,0 +1,96 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <random>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include "Util/util.h"
+#include "Rtsp/RtpReceiver.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+using MapSortor = PacketSortor<uint16_t, uint16_t>;
+using RingSortor = PacketSortor<uint16_t, uint16_t, SeqRingMap<uint16_t, uint16_t>>;
+
+static constexpr size_t kPacketCount = 2 * 1000 * 1000;
+
+//顺序包，起始seq靠近回环点
+static vector<uint16_t> makeInOrder() {
+    vector<uint16_t> ret(kPacketCount);
+    uint16_t seq = 65000;
+    for (auto &item : ret) {
+        item = seq++;
+    }
+    return ret;
+}
+
+//每32个包中随机打乱一个长度为8的窗口
+static vector<uint16_t> makeReordered() {
+    auto ret = makeInOrder();
+    mt19937 rng(1234);
+    for (size_t i = 0; i + 8 <= ret.size(); i += 32) {
+        shuffle(ret.begin() + i, ret.begin() + i + 8, rng);
+    }
+    return ret;
+}
+
+//在乱序基础上随机丢弃1%的包
+static vector<uint16_t> makeLossy() {
+    auto in = makeReordered();
+    vector<uint16_t> ret;
+    ret.reserve(in.size());
+    mt19937 rng(5678);
+    uniform_int_distribution<int> dist(0, 99);
+    for (auto seq : in) {
+        if (dist(rng)) {
+            ret.emplace_back(seq);
+        }
+    }
+    return ret;
+}
+
+template<typename Sortor>
+static uint64_t runSortor(const vector<uint16_t> &input, vector<uint16_t> &output) {
+    Sortor sortor;
+    output.clear();
+    output.reserve(input.size());
+    sortor.setOnSort([&](uint16_t seq, uint16_t packet) { output.emplace_back(seq); });
+    auto start = getCurrentMicrosecond(true);
+    for (auto seq : input) {
+        sortor.sortPacket(seq, seq);
+    }
+    sortor.flush();
+    return getCurrentMicrosecond(true) - start;
+}
+
+static bool bench(const string &name, const vector<uint16_t> &input) {
+    vector<uint16_t> map_out, ring_out;
+    auto map_us = runSortor<MapSortor>(input, map_out);
+    auto ring_us = runSortor<RingSortor>(input, ring_out);
+    bool same = map_out == ring_out;
+    cout << name << ": packets " << input.size() << ", output " << map_out.size()
+         << ", std::map " << map_us / 1000.0 << "ms (" << map_us * 1000.0 / input.size() << "ns/pkt)"
+         << ", ring " << ring_us / 1000.0 << "ms (" << ring_us * 1000.0 / input.size() << "ns/pkt)"
+         << ", speedup " << (ring_us ? (double)map_us / ring_us : 0)
+         << ", output " << (same ? "identical" : "MISMATCH") << endl;
+    return same;
+}
+
+//该测试程序用于对比std::map与SeqRingMap两种排序缓存的性能，并校验两者输出一致
+int main(int argc, char *argv[]) {
+    bool ok = true;
+    ok = bench("in-order ", makeInOrder()) && ok;
+    ok = bench("reordered", makeReordered()) && ok;
+    ok = bench("lossy    ", makeLossy()) && ok;
+    return ok ? 0 : -1;
+}
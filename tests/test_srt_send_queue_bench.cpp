@@ -0,0 +1,223 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <list>
+#include <deque>
+#include <random>
+#include <iostream>
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "../srt/PacketSendQueue.hpp"
+
+using namespace std;
+using namespace toolkit;
+using namespace SRT;
+
+//旧版基于std::list的发送缓存，用于性能对比
+class LegacySendQueue {
+public:
+    LegacySendQueue(uint32_t max_size, uint32_t latency, uint32_t flag) : _srt_flag(flag), _pkt_cap(max_size), _pkt_latency(latency) {}
+
+    bool drop(uint32_t num) {
+        auto it = _pkt_cache.begin();
+        for (; it != _pkt_cache.end(); ++it) {
+            if ((*it)->packet_seq_number == num) {
+                break;
+            }
+        }
+        if (it != _pkt_cache.end()) {
+            _pkt_cache.erase(_pkt_cache.begin(), it);
+        }
+        return true;
+    }
+
+    bool inputPacket(DataPacket::Ptr pkt) {
+        _pkt_cache.push_back(pkt);
+        while (_pkt_cache.size() > _pkt_cap) {
+            _pkt_cache.pop_front();
+        }
+        while (timeLatency() > _pkt_latency && TLPKTDrop()) {
+            _pkt_cache.pop_front();
+        }
+        return true;
+    }
+
+    list<DataPacket::Ptr> findPacketBySeq(uint32_t start, uint32_t end) {
+        list<DataPacket::Ptr> re;
+        auto it = _pkt_cache.begin();
+        for (; it != _pkt_cache.end(); ++it) {
+            if ((*it)->packet_seq_number == start) {
+                break;
+            }
+        }
+        if (start == end) {
+            if (it != _pkt_cache.end()) {
+                re.push_back(*it);
+            }
+            return re;
+        }
+        for (; it != _pkt_cache.end(); ++it) {
+            re.push_back(*it);
+            if ((*it)->packet_seq_number == end) {
+                break;
+            }
+        }
+        return re;
+    }
+
+private:
+    uint32_t timeLatency() {
+        if (_pkt_cache.empty()) {
+            return 0;
+        }
+        auto first = _pkt_cache.front()->timestamp;
+        auto last = _pkt_cache.back()->timestamp;
+        uint32_t dur = last > first ? last - first : first - last;
+        if (dur > ((uint32_t)0x01 << 31)) {
+            dur = 0xffffffff - dur;
+        }
+        return dur;
+    }
+
+    bool TLPKTDrop() {
+        return (_srt_flag & HSExtMessage::HS_EXT_MSG_TLPKTDROP) && (_srt_flag & HSExtMessage::HS_EXT_MSG_TSBPDSND);
+    }
+
+private:
+    uint32_t _srt_flag;
+    uint32_t _pkt_cap;
+    uint32_t _pkt_latency;
+    list<DataPacket::Ptr> _pkt_cache;
+};
+
+struct SimConfig {
+    uint64_t bitrate;
+    uint32_t payload;
+    uint32_t rtt_ms;
+    uint32_t latency_mul;
+    uint32_t buf_size;
+    double loss;
+    uint32_t seconds;
+};
+
+struct SimResult {
+    uint64_t packets = 0;
+    uint64_t lost = 0;
+    uint64_t nak = 0;
+    uint64_t retransmit = 0;
+    uint64_t cost_us = 0;
+};
+
+/**
+ * 按虚拟时间模拟发送端：恒定码率发送，按丢包率随机丢包，
+ * 丢包在一个rtt后收到nak并重传，重传包半个rtt后到达；
+ * 接收端每10ms回复ack，ack序号为第一个未收到的包
+ */
+template <typename Queue>
+static SimResult simulate(const SimConfig &cfg) {
+    SimResult ret;
+    Queue queue(cfg.buf_size, cfg.rtt_ms * cfg.latency_mul * 1000, 0xbf);
+    mt19937 rng(1234);
+    uniform_real_distribution<double> dist(0, 1);
+
+    uint64_t pps = cfg.bitrate / 8 / cfg.payload;
+    uint64_t total = pps * cfg.seconds;
+    uint64_t interval_ns = 1000000000ULL / pps;
+    uint64_t rtt_us = cfg.rtt_ms * 1000;
+    //起始序号靠近回环点
+    uint32_t init_seq = MAX_SEQ - 1000;
+    auto seqOf = [&](uint64_t index) { return (uint32_t)((init_seq + index) & MAX_SEQ); };
+
+    deque<pair<uint64_t /*time us*/, uint64_t /*index*/>> pending_nak;
+    deque<pair<uint64_t /*time us*/, uint64_t /*index*/>> pending_recover;
+    uint64_t next_ack_us = 0;
+
+    auto start = getCurrentMicrosecond();
+    for (uint64_t i = 0; i < total; ++i) {
+        uint64_t now_us = i * interval_ns / 1000;
+        while (!pending_nak.empty() && pending_nak.front().first <= now_us) {
+            auto index = pending_nak.front().second;
+            pending_nak.pop_front();
+            ++ret.nak;
+            auto seq = seqOf(index);
+            auto re_list = queue.findPacketBySeq(seq, seq);
+            for (auto &pkt : re_list) {
+                pkt->R = 1;
+                ++ret.retransmit;
+            }
+            pending_recover.emplace_back(now_us + rtt_us / 2, index);
+        }
+        while (!pending_recover.empty() && pending_recover.front().first <= now_us) {
+            pending_recover.pop_front();
+        }
+        if (now_us >= next_ack_us && now_us >= rtt_us / 2) {
+            next_ack_us = now_us + 10 * 1000;
+            //半个rtt前发送的包已经到达接收端
+            uint64_t ack = (now_us - rtt_us / 2) * 1000 / interval_ns + 1;
+            if (!pending_recover.empty()) {
+                ack = min(ack, pending_recover.front().second);
+            }
+            if (!pending_nak.empty()) {
+                ack = min(ack, pending_nak.front().second);
+            }
+            queue.drop(seqOf(ack));
+        }
+
+        auto pkt = std::make_shared<DataPacket>();
+        pkt->packet_seq_number = seqOf(i);
+        pkt->timestamp = (uint32_t)now_us;
+        pkt->R = 0;
+        queue.inputPacket(std::move(pkt));
+        if (dist(rng) < cfg.loss) {
+            ++ret.lost;
+            pending_nak.emplace_back(now_us + rtt_us, i);
+        }
+    }
+    ret.packets = total;
+    ret.cost_us = getCurrentMicrosecond() - start;
+    return ret;
+}
+
+static void printResult(const char *name, const SimResult &result) {
+    cout << "  " << name << ": " << result.cost_us / 1000 << " ms cpu, " << result.cost_us * 1000 / result.packets << " ns/pkt, "
+         << result.lost << " lost, " << result.retransmit << "/" << result.nak << " nak retransmitted" << endl;
+}
+
+int main(int argc, char *argv[]) {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+
+    SimConfig cfg;
+    cfg.bitrate = (argc > 1 ? atoi(argv[1]) : 50) * 1000 * 1000ULL;
+    cfg.loss = (argc > 2 ? atof(argv[2]) : 2) / 100;
+    cfg.rtt_ms = argc > 3 ? atoi(argv[3]) : 200;
+    cfg.seconds = argc > 4 ? atoi(argv[4]) : 60;
+    cfg.payload = 1316;
+    cfg.latency_mul = 4;
+    cfg.buf_size = 8192;
+    if (!cfg.bitrate || !cfg.rtt_ms || !cfg.seconds || cfg.bitrate / 8 / cfg.payload == 0) {
+        cerr << "invalid arguments" << endl;
+        return 1;
+    }
+
+    cout << "bitrate " << cfg.bitrate / 1000000 << " Mbps, loss " << cfg.loss * 100 << "%, rtt " << cfg.rtt_ms << " ms, latency "
+         << cfg.rtt_ms * cfg.latency_mul << " ms, " << cfg.seconds << " seconds" << endl;
+    auto legacy = simulate<LegacySendQueue>(cfg);
+    auto ring = simulate<PacketSendQueue>(cfg);
+    printResult("list", legacy);
+    printResult("ring", ring);
+    cout << "  speedup " << (double)legacy.cost_us / ring.cost_us << "x" << endl;
+
+    //两种实现应当重传完全相同的包，并且缓存未溢出时所有丢包都能找到
+    if (ring.retransmit != legacy.retransmit || ring.retransmit != ring.nak) {
+        cerr << "retransmit mismatch" << endl;
+        return 1;
+    }
+    return 0;
+}
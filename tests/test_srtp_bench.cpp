@@ -0,0 +1,153 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstring>
+#include <srtp2/srtp.h>
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "../webrtc/SrtpSession.hpp"
+
+using namespace std;
+using namespace toolkit;
+using namespace RTC;
+
+struct SuiteInfo {
+    SrtpSession::CryptoSuite suite;
+    const char *name;
+    //master key + master salt
+    size_t key_len;
+};
+
+static const SuiteInfo kSuites[] = {
+    { SrtpSession::CryptoSuite::AES_CM_128_HMAC_SHA1_80, "AES_CM_128_HMAC_SHA1_80", 30 },
+    { SrtpSession::CryptoSuite::AEAD_AES_128_GCM, "AEAD_AES_128_GCM", 28 },
+    { SrtpSession::CryptoSuite::AEAD_AES_256_GCM, "AEAD_AES_256_GCM", 44 },
+};
+
+//模拟一帧视频的rtp，每个rtp预留srtp尾部空间
+static vector<string> makeRtpList(size_t count, size_t size) {
+    vector<string> ret;
+    for (size_t i = 0; i < count; ++i) {
+        string rtp(size + SRTP_MAX_TRAILER_LEN, '\0');
+        auto ptr = (uint8_t *)&rtp[0];
+        ptr[0] = 0x80;
+        ptr[1] = 96;
+        ptr[8] = 0x12;
+        ptr[9] = 0x34;
+        ptr[10] = 0x56;
+        ptr[11] = 0x78;
+        for (size_t j = 12; j < size; ++j) {
+            ptr[j] = (uint8_t)(rand() & 0xFF);
+        }
+        ret.emplace_back(std::move(rtp));
+    }
+    return ret;
+}
+
+static void setSeq(string &rtp, uint16_t seq) {
+    rtp[2] = seq >> 8;
+    rtp[3] = seq & 0xFF;
+}
+
+//加密后再解密，确认批量加密与逐个加密的结果都能被正确解密
+static bool verify(const SuiteInfo &info, uint8_t *key, const vector<string> &frame, size_t rtp_size) {
+    SrtpSession encoder(SrtpSession::Type::OUTBOUND, info.suite, key, info.key_len);
+    SrtpSession decoder(SrtpSession::Type::INBOUND, info.suite, key, info.key_len);
+    auto work = frame;
+    vector<uint8_t *> data;
+    vector<int> len;
+    uint16_t seq = 0;
+    for (auto &rtp : work) {
+        setSeq(rtp, seq++);
+        data.emplace_back((uint8_t *)&rtp[0]);
+        len.emplace_back((int)rtp_size);
+    }
+    if (encoder.EncryptRtpList(data.data(), len.data(), data.size()) != data.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < work.size(); ++i) {
+        auto plain = frame[i];
+        setSeq(plain, (uint16_t)i);
+        if (!decoder.DecryptSrtp(data[i], &len[i]) || len[i] != (int)rtp_size || memcmp(data[i], plain.data(), rtp_size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//返回每秒加密的rtp个数
+static double bench(const SuiteInfo &info, uint8_t *key, const vector<string> &frame, size_t rtp_size, bool batch, uint64_t duration_ms) {
+    SrtpSession session(SrtpSession::Type::OUTBOUND, info.suite, key, info.key_len);
+    auto work = frame;
+    vector<uint8_t *> data(work.size());
+    vector<int> len(work.size());
+    uint16_t seq = 0;
+    uint64_t packets = 0;
+    auto start = getCurrentMicrosecond();
+    auto now = start;
+    while (now - start < duration_ms * 1000) {
+        //加密是原地修改，每帧重新拷贝明文，两种方式的拷贝开销相同
+        for (size_t i = 0; i < work.size(); ++i) {
+            memcpy(&work[i][0], frame[i].data(), rtp_size);
+            setSeq(work[i], seq++);
+            data[i] = (uint8_t *)&work[i][0];
+            len[i] = (int)rtp_size;
+        }
+        if (batch) {
+            session.EncryptRtpList(data.data(), len.data(), data.size());
+        } else {
+            for (size_t i = 0; i < data.size(); ++i) {
+                session.EncryptRtp(data[i], &len[i]);
+            }
+        }
+        packets += work.size();
+        now = getCurrentMicrosecond();
+    }
+    return packets / ((now - start) / 1000000.0);
+}
+
+//该测试程序用于测试单核srtp加密性能，对比逐个加密与一次flush批量加密
+//用法: test_srtp_bench [每帧rtp个数(默认32)] [rtp大小(默认1200)] [每项测试时长秒(默认2)]
+int main(int argc, char *argv[]) {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+
+    size_t frame_size = argc > 1 ? atoi(argv[1]) : 32;
+    size_t rtp_size = argc > 2 ? atoi(argv[2]) : 1200;
+    uint64_t duration_ms = (argc > 3 ? atoi(argv[3]) : 2) * 1000;
+    if (!frame_size || rtp_size < 12) {
+        cerr << "invalid arguments" << endl;
+        return 1;
+    }
+
+    auto frame = makeRtpList(frame_size, rtp_size);
+    bool failed = false;
+    for (auto &info : kSuites) {
+        if (!SrtpSession::IsCryptoSuiteSupported(info.suite)) {
+            cout << info.name << ": not supported by libsrtp" << endl;
+            continue;
+        }
+        auto key_str = makeRandStr(info.key_len, false);
+        auto key = (uint8_t *)&key_str[0];
+        if (!verify(info, key, frame, rtp_size)) {
+            cerr << info.name << ": verify failed" << endl;
+            failed = true;
+            continue;
+        }
+        auto single = bench(info, key, frame, rtp_size, false, duration_ms);
+        auto batch = bench(info, key, frame, rtp_size, true, duration_ms);
+        cout << info.name << ", " << frame_size << " x " << rtp_size << " bytes per frame" << endl;
+        cout << "  single: " << (uint64_t)single << " pps, " << single * rtp_size * 8 / 1000000000 << " Gbps" << endl;
+        cout << "  batch : " << (uint64_t)batch << " pps, " << batch * rtp_size * 8 / 1000000000 << " Gbps, speedup " << batch / single << "x" << endl;
+    }
+    return failed ? 1 : 0;
+}
@@ -405,7 +405,11 @@ namespace RTC
              it != DtlsTransport::srtpCryptoSuites.end();
              ++it)
         {
-            if (it != DtlsTransport::srtpCryptoSuites.begin())
+            // libsrtp未启用openssl时不支持AES-GCM，不能协商该套件
+            if (!RTC::SrtpSession::IsCryptoSuiteSupported(it->cryptoSuite))
+                continue;
+
+            if (!dtlsSrtpCryptoSuites.empty())
                 dtlsSrtpCryptoSuites += ":";
 
             SrtpCryptoSuiteMapEntry* cryptoSuiteEntry = std::addressof(*it);
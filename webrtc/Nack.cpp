@@ -8,6 +8,7 @@
  * may be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <mutex>
 #include "Nack.h"
 #include "Common/config.h"
 
@@ -49,28 +50,76 @@ static onceToken token([]() {
 
 } // namespace Rtc
 
-void NackList::pushBack(RtpPacket::Ptr rtp) {
-    GET_CONFIG(uint32_t, max_rtp_cache_ms, Rtc::kMaxRtpCacheMS);
+static mutex s_nack_list_mtx;
+static unordered_map<string, weak_ptr<NackList>> s_nack_list_map;
+
+NackList::Ptr NackList::getShared(const string &key) {
+    lock_guard<mutex> lck(s_nack_list_mtx);
+    auto &weak_list = s_nack_list_map[key];
+    auto ret = weak_list.lock();
+    if (!ret) {
+        ret = std::make_shared<NackList>();
+        ret->_key = key;
+        weak_list = ret;
+    }
+    return ret;
+}
+
+NackList::NackList() {
     GET_CONFIG(uint32_t, max_rtp_cache_size, Rtc::kMaxRtpCacheSize);
+    // 按seq直接映射，取2的幂；不超过seq回环范围的一半，避免新旧seq混淆
+    size_t size = 1;
+    while (size < max_rtp_cache_size && size < 0x8000) {
+        size <<= 1;
+    }
+    _rtp_cache.resize(size);
+}
 
-    // 记录rtp
-    auto seq = rtp->getSeq();
-    _nack_cache_seq.emplace_back(seq);
-    _nack_cache_pkt.emplace(seq, std::move(rtp));
+NackList::~NackList() {
+    if (_key.empty()) {
+        return;
+    }
+    lock_guard<mutex> lck(s_nack_list_mtx);
+    auto it = s_nack_list_map.find(_key);
+    // 可能已经被同key的新对象替换
+    if (it != s_nack_list_map.end() && it->second.expired()) {
+        s_nack_list_map.erase(it);
+    }
+}
 
-    // 限制rtp缓存最大个数
-    if (_nack_cache_seq.size() > max_rtp_cache_size) {
-        popFront();
+void NackList::pushBack(RtpPacket::Ptr rtp) {
+    auto seq = rtp->getSeq();
+    auto &slot = _rtp_cache[seq & (_rtp_cache.size() - 1)];
+    if (slot == rtp) {
+        // 共享该对象的其他播放器已经记录过该rtp
+        return;
     }
+    auto stamp = rtp->getStampMS(true);
+    if (stamp > _last_stamp) {
+        _last_stamp = stamp;
+    }
+    if (!slot) {
+        ++_size;
+    }
+    slot = std::move(rtp);
 
     if (++_cache_ms_check < 100) {
         // 每100个rtp包检测下缓存长度，节省cpu资源
         return;
     }
     _cache_ms_check = 0;
-    // 限制rtp缓存最大时长
-    while (getCacheMS() >= max_rtp_cache_ms) {
-        popFront();
+    // 从最旧的rtp开始清理超时的rtp，释放内存
+    GET_CONFIG(uint32_t, max_rtp_cache_ms, Rtc::kMaxRtpCacheMS);
+    for (size_t i = 0; i < _rtp_cache.size() && _size; ++i) {
+        auto &oldest = _rtp_cache[(seq + 1 + i) & (_rtp_cache.size() - 1)];
+        if (!oldest) {
+            continue;
+        }
+        if (!isExpired(oldest, max_rtp_cache_ms)) {
+            break;
+        }
+        oldest = nullptr;
+        --_size;
     }
 }
 
@@ -79,61 +128,26 @@ void NackList::forEach(const FCI_NACK &nack, const function<void(const RtpPacket
     for (auto bit : nack.getBitArray()) {
         if (bit) {
             // 丢包
-            RtpPacket::Ptr *ptr = getRtp(seq);
-            if (ptr) {
-                func(*ptr);
+            if (auto rtp = get(seq)) {
+                func(rtp);
             }
         }
         ++seq;
     }
 }
 
-void NackList::popFront() {
-    if (_nack_cache_seq.empty()) {
-        return;
-    }
-    _nack_cache_pkt.erase(_nack_cache_seq.front());
-    _nack_cache_seq.pop_front();
-}
-
-RtpPacket::Ptr *NackList::getRtp(uint16_t seq) {
-    auto it = _nack_cache_pkt.find(seq);
-    if (it == _nack_cache_pkt.end()) {
-        return nullptr;
-    }
-    return &it->second;
-}
-
-uint32_t NackList::getCacheMS() {
-    while (_nack_cache_seq.size() > 2) {
-        auto back_stamp = getNtpStamp(_nack_cache_seq.back());
-        if (back_stamp == -1) {
-            _nack_cache_seq.pop_back();
-            continue;
-        }
-
-        auto front_stamp = getNtpStamp(_nack_cache_seq.front());
-        if (front_stamp == -1) {
-            _nack_cache_seq.pop_front();
-            continue;
-        }
-
-        if (back_stamp >= front_stamp) {
-            return back_stamp - front_stamp;
-        }
-        // ntp时间戳回退了，非法数据，丢掉
-        _nack_cache_seq.pop_front();
+RtpPacket::Ptr NackList::get(uint16_t seq) const {
+    GET_CONFIG(uint32_t, max_rtp_cache_ms, Rtc::kMaxRtpCacheMS);
+    auto &rtp = _rtp_cache[seq & (_rtp_cache.size() - 1)];
+    if (rtp && rtp->getSeq() == seq && !isExpired(rtp, max_rtp_cache_ms)) {
+        return rtp;
     }
-    return 0;
+    return nullptr;
 }
 
-int64_t NackList::getNtpStamp(uint16_t seq) {
-    auto it = _nack_cache_pkt.find(seq);
-    if (it == _nack_cache_pkt.end()) {
-        return -1;
-    }
-    // 使用ntp时间戳，不会回退
-    return it->second->getStampMS(true);
+bool NackList::isExpired(const RtpPacket::Ptr &rtp, uint32_t max_ms) const {
+    // 使用ntp时间戳，不会回退；_last_stamp为已记录rtp的最大时间戳
+    return _last_stamp - rtp->getStampMS(true) >= max_ms;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
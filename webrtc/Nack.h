@@ -14,6 +14,7 @@
 #include <set>
 #include <map>
 #include <deque>
+#include <vector>
 #include <unordered_map>
 #include "Rtsp/Rtsp.h"
 #include "Rtcp/RtcpFCI.h"
@@ -29,21 +30,40 @@ extern const std::string kNackMaxSize;
 extern const std::string kNackMaxMS;
 } // namespace Rtc
 
+/**
+ * rtp重传缓存，按seq直接映射
+ * 重复记录同一个rtp包时忽略，播放同一个源的多个播放器可以共享同一个对象
+ * 该对象只能在一个线程内访问
+ */
 class NackList {
 public:
+    using Ptr = std::shared_ptr<NackList>;
+
+    NackList();
+    ~NackList();
+
+    /**
+     * 获取共享的重传缓存，key相同的调用者获取到同一个对象
+     * @param key 由源、poller、track类型组成的唯一标识
+     */
+    static Ptr getShared(const std::string &key);
+
     void pushBack(RtpPacket::Ptr rtp);
     void forEach(const FCI_NACK &nack, const std::function<void(const RtpPacket::Ptr &rtp)> &cb);
+    /**
+     * 获取未过期的rtp，不存在时返回nullptr
+     */
+    RtpPacket::Ptr get(uint16_t seq) const;
 
 private:
-    void popFront();
-    uint32_t getCacheMS();
-    int64_t getNtpStamp(uint16_t seq);
-    RtpPacket::Ptr *getRtp(uint16_t seq);
+    bool isExpired(const RtpPacket::Ptr &rtp, uint32_t max_ms) const;
 
 private:
     uint32_t _cache_ms_check = 0;
-    std::deque<uint16_t> _nack_cache_seq;
-    std::unordered_map<uint16_t, RtpPacket::Ptr> _nack_cache_pkt;
+    size_t _size = 0;
+    uint64_t _last_stamp = 0;
+    std::string _key;
+    std::vector<RtpPacket::Ptr> _rtp_cache;
 };
 
 class NackContext {
@@ -192,6 +192,93 @@ map<uint8_t/*id*/, RtpExt/*data*/> RtpExt::getExtValue(const RtpHeader *header)
     return ret;
 }
 
+template<typename Type>
+static uint8_t *findExtData(uint8_t *ptr, const uint8_t *end, uint8_t ext_id, size_t size) {
+    while (ptr < end) {
+        auto ext = reinterpret_cast<Type *>(ptr);
+        if (ext->getId() == (uint8_t) RtpExtType::padding) {
+            ++ptr;
+            continue;
+        }
+        if (ptr + Type::kMinSize > end || ext->getData() + ext->getSize() > end) {
+            return nullptr;
+        }
+        if (ext->getId() == ext_id) {
+            return ext->getSize() == size ? ext->getData() : nullptr;
+        }
+        ptr += Type::kMinSize + ext->getSize();
+    }
+    return nullptr;
+}
+
+bool RtpExt::setTransportCCSeq(RtpHeader *header, int &len, uint8_t ext_id, uint16_t seq) {
+    auto rtp_end = (uint8_t *)header + len;
+    auto insert_pos = header->getPayloadData();
+    if (insert_pos > rtp_end || !ext_id) {
+        return false;
+    }
+    bool one_byte = ext_id < (uint8_t) RtpExtType::reserved;
+    if (header->ext) {
+        auto reserved = header->getExtReserved();
+        auto ptr = header->getExtData();
+        uint8_t *data = nullptr;
+        if (reserved == kOneByteHeader) {
+            data = findExtData<RtpExtOneByte>(ptr, insert_pos, ext_id, 2);
+            one_byte = true;
+        } else if ((reserved & 0xFFF0) == kTwoByteHeader) {
+            data = findExtData<RtpExtTwoByte>(ptr, insert_pos, ext_id, 2);
+            one_byte = false;
+        } else {
+            // 未知的扩展格式
+            return false;
+        }
+        if (data) {
+            // 已经存在该扩展，直接修改序号
+            data[0] = seq >> 8;
+            data[1] = seq & 0xFF;
+            return true;
+        }
+        if (one_byte && ext_id >= (uint8_t) RtpExtType::reserved) {
+            // one byte扩展不支持该id
+            return false;
+        }
+    }
+
+    // 在扩展末尾追加4个字节: 扩展元素 + 序号
+    auto add_size = header->ext ? 4 : 8;
+    memmove(insert_pos + add_size, insert_pos, rtp_end - insert_pos);
+    auto ptr = insert_pos;
+    if (!header->ext) {
+        // 新增扩展头，长度为1个字(4字节)
+        auto reserved = one_byte ? kOneByteHeader : kTwoByteHeader;
+        ptr[0] = reserved >> 8;
+        ptr[1] = reserved & 0xFF;
+        ptr[2] = 0;
+        ptr[3] = 1;
+        ptr += 4;
+        header->ext = 1;
+    } else {
+        auto ext_len = (header->getExtSize() >> 2) + 1;
+        auto len_ptr = header->getExtData() - 2;
+        len_ptr[0] = ext_len >> 8;
+        len_ptr[1] = ext_len & 0xFF;
+    }
+    if (one_byte) {
+        // id(4bit) + (长度-1)(4bit), 最后一个字节为padding
+        ptr[0] = (ext_id << 4) | 0x01;
+        ptr[1] = seq >> 8;
+        ptr[2] = seq & 0xFF;
+        ptr[3] = 0;
+    } else {
+        ptr[0] = ext_id;
+        ptr[1] = 2;
+        ptr[2] = seq >> 8;
+        ptr[3] = seq & 0xFF;
+    }
+    len += add_size;
+    return true;
+}
+
 #define XX(type, url) {RtpExtType::type , url},
 static map<RtpExtType/*id*/, string/*ext*/> s_type_to_url = {RTP_EXT_MAP(XX)};
 #undef XX
@@ -576,6 +663,19 @@ void RtpExtContext::setRid(uint32_t ssrc, const string &rid) {
     _ssrc_to_rid[ssrc] = rid;
 }
 
+uint8_t RtpExtContext::getSendExtId(RtpExtType type) const {
+    auto it = _rtp_ext_type_to_id.find(type);
+    return it == _rtp_ext_type_to_id.end() ? 0 : it->second;
+}
+
+string RtpExtContext::getSendExtIdKey() const {
+    string ret;
+    for (auto &pr : _rtp_ext_type_to_id) {
+        ret += to_string((int)pr.first) + ':' + to_string((int)pr.second) + ';';
+    }
+    return ret;
+}
+
 RtpExt RtpExtContext::changeRtpExtId(const RtpHeader *header, bool is_recv, string *rid_ptr, RtpExtType type) {
     string rid, repaired_rid;
     RtpExt ret;
@@ -55,6 +55,16 @@ public:
     friend class RtpExtContext;
 
     static std::map<uint8_t/*id*/, RtpExt/*data*/> getExtValue(const RtpHeader *header);
+    /**
+     * 设置transport-cc扩展序号，rtp中无该扩展时追加之
+     * 追加时rtp长度最多增加8个字节，调用者须确保内存足够
+     * @param header rtp头
+     * @param len rtp长度，追加扩展后会被修改
+     * @param ext_id transport-cc扩展id
+     * @param seq transport-cc序号
+     * @return 是否设置成功
+     */
+    static bool setTransportCCSeq(RtpHeader *header, int &len, uint8_t ext_id, uint16_t seq);
     static RtpExtType getExtType(const std::string &url);
     static const std::string& getExtUrl(RtpExtType type);
     static const char *getExtName(RtpExtType type);
@@ -122,6 +132,10 @@ public:
     void setOnGetRtp(OnGetRtp cb);
     std::string getRid(uint32_t ssrc) const;
     void setRid(uint32_t ssrc, const std::string &rid);
+    //发送rtp时ext类型与id的映射关系，映射相同则改写结果相同
+    std::string getSendExtIdKey() const;
+    //获取协商后发送rtp时ext类型对应的id，未协商时返回0
+    uint8_t getSendExtId(RtpExtType type) const;
     RtpExt changeRtpExtId(const RtpHeader *header, bool is_recv, std::string *rid_ptr = nullptr, RtpExtType type = RtpExtType::padding);
 
 private:
@@ -0,0 +1,339 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <cmath>
+#include <algorithm>
+#include "SendSideBwe.h"
+#include "Common/config.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+// 发送记录个数，按transport-cc序号直接映射，须为2的幂
+static constexpr size_t kHistorySize = 8192;
+// 发送时间间隔在该值内的rtp视为一组突发
+static constexpr uint64_t kBurstDeltaUS = 5 * 1000;
+// 趋势线窗口大小
+static constexpr size_t kTrendWindowSize = 20;
+// 累计时延平滑系数
+static constexpr double kSmoothingCoef = 0.9;
+// 趋势线增益
+static constexpr double kThresholdGain = 4.0;
+// 统计确认码率的时间窗口
+static constexpr int64_t kAckedWindowUS = 500 * 1000;
+// 码率增长速度，每秒8%
+static constexpr double kIncreaseFactor = 1.08;
+// 过载时降低到确认码率的倍数
+static constexpr double kDecreaseFactor = 0.85;
+
+SendSideBwe::SendSideBwe(uint32_t start_bps, uint32_t min_bps, uint32_t max_bps) {
+    _min_bps = min_bps;
+    _max_bps = max(min_bps, max_bps);
+    _estimate_bps = min(max(start_bps, _min_bps), _max_bps);
+    _delay_based_bps = _estimate_bps;
+    _loss_based_bps = _estimate_bps;
+    _history.resize(kHistorySize);
+}
+
+void SendSideBwe::onSendPacket(uint16_t twcc_seq, size_t bytes, uint64_t send_us) {
+    auto &pkt = _history[twcc_seq & (kHistorySize - 1)];
+    pkt.valid = true;
+    pkt.seq = twcc_seq;
+    pkt.size = (uint32_t)bytes;
+    pkt.send_us = send_us;
+}
+
+void SendSideBwe::onTwccFeedback(const FCI_TWCC &fci, size_t fci_size, uint64_t now_us) {
+    auto status = fci.getPacketChunkList(fci_size);
+    // 参考时间单位64ms，后续每个recv delta单位250us，均相对前一个收到的包
+    int64_t recv_us = (int64_t)fci.getReferenceTime() * 64 * 1000;
+    auto seq = fci.getBaseSeq();
+    auto count = fci.getPacketCount();
+    size_t total = 0, lost = 0;
+    for (uint16_t i = 0; i < count; ++i, ++seq) {
+        auto it = status.find(seq);
+        if (it == status.end()) {
+            continue;
+        }
+        auto &pkt = _history[seq & (kHistorySize - 1)];
+        auto known = pkt.valid && pkt.seq == seq;
+        auto symbol = it->second.first;
+        if (symbol == SymbolStatus::not_received || symbol == SymbolStatus::reserved) {
+            if (known) {
+                // 不置为无效，后续反馈可能确认收到
+                ++total;
+                ++lost;
+            }
+            continue;
+        }
+        recv_us += (int64_t)it->second.second * 250;
+        if (!known) {
+            continue;
+        }
+        ++total;
+        onPacketAcked(pkt, recv_us);
+        pkt.valid = false;
+    }
+    if (total) {
+        _loss_rate = (float)lost / total;
+    }
+    updateEstimate(now_us, total ? _loss_rate : 0);
+}
+
+void SendSideBwe::onPacketAcked(const SentPacket &pkt, int64_t recv_us) {
+    updateAckedBitrate(recv_us, pkt.size);
+    if (_cur_group.empty) {
+        _cur_group.empty = false;
+        _cur_group.first_send_us = _cur_group.last_send_us = pkt.send_us;
+        _cur_group.last_recv_us = recv_us;
+        return;
+    }
+    if (pkt.send_us > _cur_group.first_send_us + kBurstDeltaUS) {
+        // 新的一组突发，计算前两组的时延梯度
+        if (!_prev_group.empty) {
+            onGroupComplete(_cur_group);
+        }
+        _prev_group = _cur_group;
+        _cur_group.first_send_us = _cur_group.last_send_us = pkt.send_us;
+        _cur_group.last_recv_us = recv_us;
+        return;
+    }
+    _cur_group.last_send_us = max(_cur_group.last_send_us, pkt.send_us);
+    _cur_group.last_recv_us = max(_cur_group.last_recv_us, recv_us);
+}
+
+void SendSideBwe::onGroupComplete(const PacketGroup &group) {
+    auto send_delta_ms = ((int64_t)group.last_send_us - (int64_t)_prev_group.last_send_us) / 1000.0;
+    auto recv_delta_ms = (group.last_recv_us - _prev_group.last_recv_us) / 1000.0;
+    updateTrend(recv_delta_ms, recv_delta_ms - send_delta_ms, group.last_recv_us);
+}
+
+void SendSideBwe::updateTrend(double recv_delta_ms, double delay_ms, int64_t recv_us) {
+    if (_first_recv_us < 0) {
+        _first_recv_us = recv_us;
+    }
+    _num_deltas = min<size_t>(_num_deltas + 1, 1000);
+    _accumulated_delay += delay_ms;
+    _smoothed_delay = kSmoothingCoef * _smoothed_delay + (1 - kSmoothingCoef) * _accumulated_delay;
+    _delay_hist.emplace_back((recv_us - _first_recv_us) / 1000.0, _smoothed_delay);
+    if (_delay_hist.size() > kTrendWindowSize) {
+        _delay_hist.pop_front();
+    }
+    auto prev_trend = _trend;
+    if (_delay_hist.size() == kTrendWindowSize) {
+        // 线性回归求排队时延的斜率
+        double sum_x = 0, sum_y = 0;
+        for (auto &pr : _delay_hist) {
+            sum_x += pr.first;
+            sum_y += pr.second;
+        }
+        auto avg_x = sum_x / kTrendWindowSize;
+        auto avg_y = sum_y / kTrendWindowSize;
+        double numerator = 0, denominator = 0;
+        for (auto &pr : _delay_hist) {
+            numerator += (pr.first - avg_x) * (pr.second - avg_y);
+            denominator += (pr.first - avg_x) * (pr.first - avg_x);
+        }
+        if (denominator != 0) {
+            _trend = numerator / denominator;
+        }
+    }
+
+    auto modified_trend = min<size_t>(_num_deltas, 60) * _trend * kThresholdGain;
+    if (modified_trend > _threshold) {
+        // 时延持续增加才认为过载
+        _usage = _trend >= prev_trend ? BandwidthUsage::overusing : _usage;
+    } else if (modified_trend < -_threshold) {
+        _usage = BandwidthUsage::underusing;
+    } else {
+        _usage = BandwidthUsage::normal;
+    }
+    updateThreshold(modified_trend, recv_us);
+}
+
+void SendSideBwe::updateThreshold(double trend, int64_t recv_us) {
+    if (_last_threshold_update_us < 0) {
+        _last_threshold_update_us = recv_us;
+    }
+    auto abs_trend = fabs(trend);
+    if (abs_trend > _threshold + 15) {
+        // 突变不参与阈值调整
+        _last_threshold_update_us = recv_us;
+        return;
+    }
+    auto k = abs_trend < _threshold ? 0.039 : 0.0087;
+    auto dt_ms = min<int64_t>((recv_us - _last_threshold_update_us) / 1000, 100);
+    _threshold += k * (abs_trend - _threshold) * dt_ms;
+    _threshold = min(max(_threshold, 6.0), 600.0);
+    _last_threshold_update_us = recv_us;
+}
+
+void SendSideBwe::updateAckedBitrate(int64_t recv_us, uint32_t bytes) {
+    _acked_hist.emplace_back(recv_us, bytes);
+    _acked_bytes += bytes;
+    while (_acked_hist.size() > 1 && _acked_hist.front().first + kAckedWindowUS < recv_us) {
+        _acked_bytes -= _acked_hist.front().second;
+        _acked_hist.pop_front();
+    }
+    auto span = _acked_hist.back().first - _acked_hist.front().first;
+    if (span >= kAckedWindowUS / 2) {
+        _acked_bps = (uint32_t)(_acked_bytes * 8 * 1000 * 1000 / span);
+    }
+}
+
+void SendSideBwe::updateEstimate(uint64_t now_us, float loss) {
+    auto dt_s = _last_update_us ? min<uint64_t>(now_us - _last_update_us, 1000 * 1000) / 1000000.0 : 0;
+    _last_update_us = now_us;
+
+    // 基于时延
+    switch (_usage) {
+        case BandwidthUsage::overusing: {
+            if (now_us - _last_decrease_us > 200 * 1000) {
+                auto base = _acked_bps ? _acked_bps : _delay_based_bps;
+                _delay_based_bps = (uint32_t)(base * kDecreaseFactor);
+                _last_decrease_us = now_us;
+            }
+            break;
+        }
+        case BandwidthUsage::normal: {
+            auto increased = _delay_based_bps * pow(kIncreaseFactor, dt_s);
+            if (_acked_bps) {
+                // 发送码率受限于源码率时，估算值不应无限增长
+                auto cap = 1.5 * _acked_bps + 10 * 1000;
+                increased = max(min(increased, cap), (double)_delay_based_bps);
+            }
+            _delay_based_bps = (uint32_t)min(increased, (double)_max_bps);
+            break;
+        }
+        default: break;
+    }
+
+    // 基于丢包
+    if (loss > 0.1f) {
+        if (now_us - _last_decrease_us > 300 * 1000) {
+            _loss_based_bps = (uint32_t)(_estimate_bps * (1 - 0.5 * loss));
+            // 源码率无法降低时丢包会持续存在，不低于实际送达的码率
+            _loss_based_bps = max(_loss_based_bps, (uint32_t)(_acked_bps * kDecreaseFactor));
+            _last_decrease_us = now_us;
+        }
+    } else if (loss < 0.02f) {
+        _loss_based_bps = (uint32_t)min(_loss_based_bps * pow(kIncreaseFactor, dt_s), (double)_max_bps);
+    }
+
+    _delay_based_bps = max(_delay_based_bps, _min_bps);
+    _loss_based_bps = max(_loss_based_bps, _min_bps);
+    _estimate_bps = min(max(min(_delay_based_bps, _loss_based_bps), _min_bps), _max_bps);
+}
+
+uint32_t SendSideBwe::getEstimateBitrate() const {
+    return _estimate_bps;
+}
+
+uint32_t SendSideBwe::getAckedBitrate() const {
+    return _acked_bps;
+}
+
+float SendSideBwe::getLossRate() const {
+    return _loss_rate;
+}
+
+double SendSideBwe::getDelayTrend() const {
+    return _trend;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+// 定时发送间隔
+static constexpr uint64_t kPacerIntervalMS = 5;
+// 空闲时最多累积的发送预算时长，限制突发大小
+static constexpr uint64_t kPacerMaxBurstMS = 20;
+
+RtpPacer::RtpPacer(EventPoller::Ptr poller, onSendCB cb) {
+    _poller = std::move(poller);
+    _cb = std::move(cb);
+}
+
+void RtpPacer::setPacingRate(uint32_t bps) {
+    _pacing_bps = bps;
+}
+
+size_t RtpPacer::getQueueBytes() const {
+    return _queue_bytes;
+}
+
+uint64_t RtpPacer::getQueueDelayMS() const {
+    if (_queue.empty()) {
+        return 0;
+    }
+    return (getCurrentMicrosecond() - _queue.front().enqueue_us) / 1000;
+}
+
+void RtpPacer::refillBudget(uint64_t now_us) {
+    GET_CONFIG(uint32_t, max_queue_ms, Rtc::kPacerMaxQueueMS);
+    if (!_last_refill_us) {
+        _last_refill_us = now_us;
+    }
+    auto elapsed_us = now_us - _last_refill_us;
+    _last_refill_us = now_us;
+
+    double rate = _pacing_bps;
+    if (!_queue.empty()) {
+        // 排队过久时提高发送速度，确保队列在最大排队时长内发送完毕
+        auto wait_us = now_us - _queue.front().enqueue_us;
+        auto remain_us = max<int64_t>((int64_t)max_queue_ms * 1000 - (int64_t)wait_us, kPacerIntervalMS * 1000);
+        rate = max(rate, _queue_bytes * 8.0 * 1000 * 1000 / remain_us);
+    }
+    _budget += (int64_t)(rate * elapsed_us / 8 / 1000 / 1000);
+    _budget = min(_budget, (int64_t)(rate * kPacerMaxBurstMS / 8 / 1000));
+}
+
+void RtpPacer::send(Buffer::Ptr buf, bool flush, int twcc_seq) {
+    refillBudget(getCurrentMicrosecond());
+    if (_queue.empty() && _budget > 0) {
+        _budget -= buf->size();
+        _cb(std::move(buf), flush, twcc_seq);
+        return;
+    }
+    _queue_bytes += buf->size();
+    _queue.emplace_back(Item { std::move(buf), twcc_seq, getCurrentMicrosecond() });
+    if (_timer_started) {
+        return;
+    }
+    _timer_started = true;
+    weak_ptr<RtpPacer> weak_self = shared_from_this();
+    _poller->doDelayTask(kPacerIntervalMS, [weak_self]() -> uint64_t {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return 0;
+        }
+        return strong_self->onTimer();
+    });
+}
+
+uint64_t RtpPacer::onTimer() {
+    refillBudget(getCurrentMicrosecond());
+    while (!_queue.empty() && _budget > 0) {
+        auto item = std::move(_queue.front());
+        _queue.pop_front();
+        _queue_bytes -= item.buf->size();
+        _budget -= item.buf->size();
+        // 本轮最后一个包flush socket
+        _cb(std::move(item.buf), _queue.empty() || _budget <= 0, item.twcc_seq);
+    }
+    if (_queue.empty()) {
+        _timer_started = false;
+        return 0;
+    }
+    return kPacerIntervalMS;
+}
+
+} // namespace mediakit
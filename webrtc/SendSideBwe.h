@@ -0,0 +1,174 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_SENDSIDEBWE_H
+#define ZLMEDIAKIT_SENDSIDEBWE_H
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include "Rtcp/RtcpFCI.h"
+#include "Network/Buffer.h"
+#include "Poller/EventPoller.h"
+
+namespace mediakit {
+
+// RTC配置项目
+namespace Rtc {
+// 是否开启rtc播放时的发送端拥塞控制(基于transport-cc反馈估算带宽并平滑发送)
+extern const std::string kSendCongestionControl;
+// 平滑发送队列最大排队时长，超过后加速发送，单位毫秒
+extern const std::string kPacerMaxQueueMS;
+} // namespace Rtc
+
+/**
+ * 基于transport-cc反馈的发送端带宽估算
+ * 时延部分使用到达时延梯度的趋势线检测过载，丢包部分根据丢包率调整，取二者最小值
+ */
+class SendSideBwe {
+public:
+    using Ptr = std::shared_ptr<SendSideBwe>;
+
+    SendSideBwe(uint32_t start_bps, uint32_t min_bps, uint32_t max_bps);
+
+    /**
+     * 记录实际发送的rtp包
+     * @param twcc_seq transport-cc序号
+     * @param bytes 包大小
+     * @param send_us 发送时间，单位微秒
+     */
+    void onSendPacket(uint16_t twcc_seq, size_t bytes, uint64_t send_us);
+
+    /**
+     * 收到transport-cc反馈
+     * @param fci transport-cc fci
+     * @param fci_size fci长度
+     * @param now_us 当前时间，单位微秒
+     */
+    void onTwccFeedback(const FCI_TWCC &fci, size_t fci_size, uint64_t now_us);
+
+    // 带宽估算值，单位bps
+    uint32_t getEstimateBitrate() const;
+    // 对端确认接收的码率，单位bps
+    uint32_t getAckedBitrate() const;
+    // 最近一次反馈的丢包率
+    float getLossRate() const;
+    // 时延梯度趋势，大于0说明排队时延在增加
+    double getDelayTrend() const;
+
+private:
+    enum class BandwidthUsage { normal, overusing, underusing };
+
+    struct SentPacket {
+        bool valid = false;
+        uint16_t seq = 0;
+        uint32_t size = 0;
+        uint64_t send_us = 0;
+    };
+
+    struct PacketGroup {
+        uint64_t first_send_us = 0;
+        uint64_t last_send_us = 0;
+        int64_t last_recv_us = 0;
+        bool empty = true;
+    };
+
+    void onPacketAcked(const SentPacket &pkt, int64_t recv_us);
+    void onGroupComplete(const PacketGroup &group);
+    void updateTrend(double recv_delta_ms, double delay_ms, int64_t recv_us);
+    void updateThreshold(double trend, int64_t recv_us);
+    void updateAckedBitrate(int64_t recv_us, uint32_t bytes);
+    void updateEstimate(uint64_t now_us, float loss);
+
+private:
+    uint32_t _min_bps;
+    uint32_t _max_bps;
+    uint32_t _estimate_bps;
+    uint32_t _delay_based_bps;
+    uint32_t _loss_based_bps;
+    uint32_t _acked_bps = 0;
+    float _loss_rate = 0;
+    uint64_t _last_update_us = 0;
+    uint64_t _last_decrease_us = 0;
+    BandwidthUsage _usage = BandwidthUsage::normal;
+
+    std::vector<SentPacket> _history;
+
+    // 到达时延梯度
+    PacketGroup _cur_group;
+    PacketGroup _prev_group;
+    int64_t _first_recv_us = -1;
+    size_t _num_deltas = 0;
+    double _accumulated_delay = 0;
+    double _smoothed_delay = 0;
+    double _trend = 0;
+    double _threshold = 12.5;
+    int64_t _last_threshold_update_us = -1;
+    std::deque<std::pair<double /*recv ms*/, double /*smoothed delay ms*/>> _delay_hist;
+
+    // 确认码率统计窗口
+    std::deque<std::pair<int64_t /*recv us*/, uint32_t /*bytes*/>> _acked_hist;
+    uint64_t _acked_bytes = 0;
+};
+
+/**
+ * rtp平滑发送队列，按照设置的码率匀速发送，避免关键帧突发导致丢包
+ * 该对象只能在所属poller线程访问
+ */
+class RtpPacer : public std::enable_shared_from_this<RtpPacer> {
+public:
+    using Ptr = std::shared_ptr<RtpPacer>;
+    using onSendCB = std::function<void(toolkit::Buffer::Ptr buf, bool flush, int twcc_seq)>;
+
+    RtpPacer(toolkit::EventPoller::Ptr poller, onSendCB cb);
+
+    /**
+     * 设置发送码率，单位bps
+     */
+    void setPacingRate(uint32_t bps);
+
+    /**
+     * 发送rtp，发送预算不足时排队
+     * @param buf 加密后的rtp
+     * @param flush 是否flush socket
+     * @param twcc_seq transport-cc序号，-1表示无
+     */
+    void send(toolkit::Buffer::Ptr buf, bool flush, int twcc_seq);
+
+    // 排队中的字节数
+    size_t getQueueBytes() const;
+    // 队首rtp的排队时长，单位毫秒
+    uint64_t getQueueDelayMS() const;
+
+private:
+    void refillBudget(uint64_t now_us);
+    uint64_t onTimer();
+
+private:
+    struct Item {
+        toolkit::Buffer::Ptr buf;
+        int twcc_seq;
+        uint64_t enqueue_us;
+    };
+
+    bool _timer_started = false;
+    uint32_t _pacing_bps = 0;
+    int64_t _budget = 0;
+    uint64_t _last_refill_us = 0;
+    size_t _queue_bytes = 0;
+    std::deque<Item> _queue;
+    onSendCB _cb;
+    toolkit::EventPoller::Ptr _poller;
+};
+
+} // namespace mediakit
+
+#endif // ZLMEDIAKIT_SENDSIDEBWE_H
@@ -0,0 +1,88 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <mutex>
+#include <unordered_map>
+#include "SharedRtpCache.h"
+#include "Common/config.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+constexpr size_t SharedRtpCache::kCacheSize;
+
+static mutex s_mtx;
+static unordered_map<string, weak_ptr<SharedRtpCache>> s_cache_map;
+// 已销毁缓存的累计统计
+static atomic<uint64_t> s_retired_hit { 0 };
+static atomic<uint64_t> s_retired_miss { 0 };
+
+SharedRtpCache::SharedRtpCache(string key) {
+    _key = std::move(key);
+    _items.resize(kCacheSize);
+    for (auto &item : _items) {
+        item.buf = BufferRaw::create();
+    }
+}
+
+SharedRtpCache::~SharedRtpCache() {
+    s_retired_hit += _hit;
+    s_retired_miss += _miss;
+    lock_guard<mutex> lck(s_mtx);
+    auto it = s_cache_map.find(_key);
+    // 可能已经被同key的新缓存替换
+    if (it != s_cache_map.end() && it->second.expired()) {
+        s_cache_map.erase(it);
+    }
+}
+
+SharedRtpCache::Ptr SharedRtpCache::get(const string &key) {
+    lock_guard<mutex> lck(s_mtx);
+    auto &weak_cache = s_cache_map[key];
+    auto ret = weak_cache.lock();
+    if (!ret) {
+        ret.reset(new SharedRtpCache(key));
+        weak_cache = ret;
+    }
+    return ret;
+}
+
+static vector<SharedRtpCache::Ptr> getAllCache() {
+    vector<SharedRtpCache::Ptr> ret;
+    lock_guard<mutex> lck(s_mtx);
+    ret.reserve(s_cache_map.size());
+    for (auto &pr : s_cache_map) {
+        if (auto cache = pr.second.lock()) {
+            ret.emplace_back(std::move(cache));
+        }
+    }
+    // 缓存可能在锁外析构，析构时会再次加锁
+    return ret;
+}
+
+uint64_t SharedRtpCache::getTotalHit() {
+    uint64_t ret = s_retired_hit;
+    for (auto &cache : getAllCache()) {
+        ret += cache->_hit;
+    }
+    return ret;
+}
+
+uint64_t SharedRtpCache::getTotalMiss() {
+    uint64_t ret = s_retired_miss;
+    for (auto &cache : getAllCache()) {
+        ret += cache->_miss;
+    }
+    return ret;
+}
+
+} // namespace mediakit
@@ -0,0 +1,95 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_SHAREDRTPCACHE_H
+#define ZLMEDIAKIT_SHAREDRTPCACHE_H
+
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cstring>
+#include "Rtsp/Rtsp.h"
+#include "Network/Buffer.h"
+
+namespace mediakit {
+
+// RTC配置项目
+namespace Rtc {
+// 是否在协商参数相同的rtc播放器间共享改写后的rtp明文
+extern const std::string kShareRtpCache;
+} // namespace Rtc
+
+/**
+ * 播放同一个源、位于同一个poller线程、且协商结果(pt、ssrc、rtp ext id)一致的rtc播放器，
+ * 发送rtp前对rtp头的改写结果完全相同，该缓存使这些播放器共享改写后的rtp明文，
+ * 每个播放器只需拷贝明文并做srtp加密
+ * 缓存只在所属poller线程访问，无需加锁
+ */
+class SharedRtpCache {
+public:
+    using Ptr = std::shared_ptr<SharedRtpCache>;
+
+    ~SharedRtpCache();
+
+    /**
+     * 获取共享缓存，key相同的调用者获取到同一个对象
+     * @param key 由源、poller、协商参数组成的唯一标识
+     */
+    static Ptr get(const std::string &key);
+
+    /**
+     * 获取rtp包改写后的明文(不含rtp over tcp头)，未命中时拷贝并调用rewrite改写
+     * @param rtp 从环形缓存读取的rtp包
+     * @param rewrite 改写rtp头的函数，原型为void(char *buf, int &len)
+     */
+    template <typename FUNC>
+    const toolkit::BufferRaw &fetch(const RtpPacket::Ptr &rtp, FUNC &&rewrite) {
+        auto &item = _items[rtp->getSeq() & (kCacheSize - 1)];
+        if (item.rtp == rtp) {
+            _hit.fetch_add(1, std::memory_order_relaxed);
+            return *item.buf;
+        }
+        _miss.fetch_add(1, std::memory_order_relaxed);
+        auto len = (int)(rtp->size() - RtpPacket::kRtpTcpHeaderSize);
+        item.rtp = rtp;
+        item.buf->setCapacity(len);
+        memcpy(item.buf->data(), rtp->data() + RtpPacket::kRtpTcpHeaderSize, len);
+        rewrite(item.buf->data(), len);
+        item.buf->setSize(len);
+        return *item.buf;
+    }
+
+    /**
+     * 所有共享缓存的累计命中与未命中次数
+     */
+    static uint64_t getTotalHit();
+    static uint64_t getTotalMiss();
+
+private:
+    SharedRtpCache(std::string key);
+
+private:
+    // 按seq直接映射，须为2的幂；同一poller上的播放器按顺序消费同一批rtp，缓存只需大于单帧rtp个数
+    static constexpr size_t kCacheSize = 1024;
+
+    struct Item {
+        RtpPacket::Ptr rtp;
+        toolkit::BufferRaw::Ptr buf;
+    };
+
+    std::string _key;
+    std::vector<Item> _items;
+    std::atomic<uint64_t> _hit { 0 };
+    std::atomic<uint64_t> _miss { 0 };
+};
+
+} // namespace mediakit
+
+#endif // ZLMEDIAKIT_SHAREDRTPCACHE_H
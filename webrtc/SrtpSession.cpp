@@ -28,6 +28,7 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include <srtp2/srtp.h>
 
 #include <cstring> // std::memset(), std::memcpy()
+#include <map>
 #include <vector>
 
 using namespace toolkit;
@@ -142,26 +143,16 @@ DepLibSRTP::~DepLibSRTP() {
 
 /////////////////////////////////////////////////////////////////////////////////////
 
-/* Instance methods. */
-
-SrtpSession::SrtpSession(Type type, CryptoSuite cryptoSuite, uint8_t *key, size_t keyLen) {
-    _env = DepLibSRTP::Instance().shared_from_this();
-    MS_TRACE();
-
-    srtp_policy_t policy; // NOLINT(cppcoreguidelines-pro-type-member-init)
-
-    // Set all policy fields to 0.
-    std::memset(&policy, 0, sizeof(srtp_policy_t));
-
+static void SetCryptoPolicy(srtp_policy_t &policy, SrtpSession::CryptoSuite cryptoSuite) {
     switch (cryptoSuite) {
-    case CryptoSuite::AES_CM_128_HMAC_SHA1_80: {
+    case SrtpSession::CryptoSuite::AES_CM_128_HMAC_SHA1_80: {
         srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy.rtp);
         srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy.rtcp);
 
         break;
     }
 
-    case CryptoSuite::AES_CM_128_HMAC_SHA1_32: {
+    case SrtpSession::CryptoSuite::AES_CM_128_HMAC_SHA1_32: {
         srtp_crypto_policy_set_aes_cm_128_hmac_sha1_32(&policy.rtp);
         // NOTE: Must be 80 for RTCP.
         srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy.rtcp);
@@ -169,14 +160,14 @@ SrtpSession::SrtpSession(Type type, CryptoSuite cryptoSuite, uint8_t *key, size_
         break;
     }
 
-    case CryptoSuite::AEAD_AES_256_GCM: {
+    case SrtpSession::CryptoSuite::AEAD_AES_256_GCM: {
         srtp_crypto_policy_set_aes_gcm_256_16_auth(&policy.rtp);
         srtp_crypto_policy_set_aes_gcm_256_16_auth(&policy.rtcp);
 
         break;
     }
 
-    case CryptoSuite::AEAD_AES_128_GCM: {
+    case SrtpSession::CryptoSuite::AEAD_AES_128_GCM: {
         srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy.rtp);
         srtp_crypto_policy_set_aes_gcm_128_16_auth(&policy.rtcp);
 
@@ -187,6 +178,47 @@ SrtpSession::SrtpSession(Type type, CryptoSuite cryptoSuite, uint8_t *key, size_
         MS_ABORT("unknown SRTP crypto suite");
     }
     }
+}
+
+bool SrtpSession::IsCryptoSuiteSupported(CryptoSuite cryptoSuite) {
+    // AES-GCM需要libsrtp编译时启用openssl(或nss)加密库，openssl同时提供AES-NI硬件加速
+    static auto s_supported = []() {
+        auto env = DepLibSRTP::Instance().shared_from_this();
+        std::map<CryptoSuite, bool> ret;
+        for (auto suite : { CryptoSuite::AES_CM_128_HMAC_SHA1_80, CryptoSuite::AES_CM_128_HMAC_SHA1_32,
+                            CryptoSuite::AEAD_AES_256_GCM, CryptoSuite::AEAD_AES_128_GCM }) {
+            srtp_policy_t policy;
+            std::memset(&policy, 0, sizeof(srtp_policy_t));
+            SetCryptoPolicy(policy, suite);
+            uint8_t key[SRTP_MAX_KEY_LEN] = { 0 };
+            policy.ssrc.type = ssrc_any_outbound;
+            policy.key = key;
+            srtp_t session = nullptr;
+            auto supported = !DepLibSRTP::IsError(srtp_create(&session, &policy));
+            if (session) {
+                srtp_dealloc(session);
+            }
+            ret[suite] = supported;
+            InfoL << "srtp crypto suite " << (int)suite << " supported: " << supported;
+        }
+        return ret;
+    }();
+    auto it = s_supported.find(cryptoSuite);
+    return it != s_supported.end() && it->second;
+}
+
+/* Instance methods. */
+
+SrtpSession::SrtpSession(Type type, CryptoSuite cryptoSuite, uint8_t *key, size_t keyLen) {
+    _env = DepLibSRTP::Instance().shared_from_this();
+    MS_TRACE();
+
+    srtp_policy_t policy; // NOLINT(cppcoreguidelines-pro-type-member-init)
+
+    // Set all policy fields to 0.
+    std::memset(&policy, 0, sizeof(srtp_policy_t));
+
+    SetCryptoPolicy(policy, cryptoSuite);
 
     MS_ASSERT((int)keyLen == policy.rtp.cipher_key_len, "given keyLen does not match policy.rtp.cipher_keyLen");
 
@@ -237,6 +269,26 @@ bool SrtpSession::EncryptRtp(uint8_t *data, int *len) {
     return true;
 }
 
+size_t SrtpSession::EncryptRtpList(uint8_t **data, int *len, size_t count) {
+    MS_TRACE();
+    size_t ret = 0;
+    srtp_err_status_t last_err = srtp_err_status_ok;
+    for (size_t i = 0; i < count; ++i) {
+        srtp_err_status_t err = srtp_protect(this->session, static_cast<void *>(data[i]), reinterpret_cast<int *>(len + i));
+        if (DepLibSRTP::IsError(err)) {
+            last_err = err;
+            len[i] = 0;
+            continue;
+        }
+        ++ret;
+    }
+    if (ret != count) {
+        // 一批只打印一次日志
+        WarnL << "srtp_protect() failed " << count - ret << "/" << count << ":" << DepLibSRTP::GetErrorString(last_err);
+    }
+    return ret;
+}
+
 bool SrtpSession::DecryptSrtp(uint8_t *data, int *len) {
     MS_TRACE();
 
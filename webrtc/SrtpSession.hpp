@@ -22,6 +22,7 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "Utils.hpp"
 
 #include <memory>
+#include <cstddef>
 
 typedef struct srtp_ctx_t_ *srtp_t;
 
@@ -46,8 +47,21 @@ public:
     SrtpSession(Type type, CryptoSuite cryptoSuite, uint8_t *key, size_t keyLen);
     ~SrtpSession();
 
+    /**
+     * 当前libsrtp是否支持该加密套件
+     */
+    static bool IsCryptoSuiteSupported(CryptoSuite cryptoSuite);
+
 public:
     bool EncryptRtp(uint8_t *data, int *len);
+    /**
+     * 批量加密一次flush的多个rtp，每个rtp须预留SRTP_MAX_TRAILER_LEN字节
+     * @param data 各rtp数据指针
+     * @param len 输入为明文长度，输出为密文长度，加密失败时置为0
+     * @param count rtp个数
+     * @return 加密成功的个数
+     */
+    size_t EncryptRtpList(uint8_t **data, int *len, size_t count);
     bool DecryptSrtp(uint8_t *data, int *len);
     bool EncryptRtcp(uint8_t *data, int *len);
     bool DecryptSrtcp(uint8_t *data, int *len);
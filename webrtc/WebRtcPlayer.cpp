@@ -8,16 +8,76 @@
  * may be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <algorithm>
 #include "WebRtcPlayer.h"
 
 #include "Common/config.h"
 #include "Extension/Factory.h"
 #include "Util/base64.h"
+#include "WebRtcPusher.h"
 
 using namespace std;
 
 namespace mediakit {
 
+// 等待新层关键帧的超时时间
+static constexpr uint64_t kLayerPendingTimeoutMS = 10 * 1000;
+// 两次自动切换层的最小间隔
+static constexpr uint64_t kLayerSwitchIntervalMS = 2 * 1000;
+// 自动升层前无拥塞的持续时间，升层失败后加倍
+static constexpr uint64_t kLayerUpWaitMS = 5 * 1000;
+static constexpr uint64_t kLayerUpWaitMaxMS = 60 * 1000;
+
+// 根据rtp负载判断是否为关键帧的第一个rtp，用于rtp解码器无法判断的编码格式
+static bool isKeyFrameStart(CodecId codec, const RtpPacket::Ptr &rtp) {
+    auto payload = rtp->getPayload();
+    auto size = rtp->getPayloadSize();
+    if (size < 1) {
+        return false;
+    }
+    switch (codec) {
+        case CodecVP8: {
+            // https://datatracker.ietf.org/doc/html/rfc7741#section-4.2
+            // 分区的开始(S=1, PID=0)，且vp8负载头P位为0时为关键帧
+            if ((payload[0] & 0x17) != 0x10) {
+                return false;
+            }
+            size_t offset = 1;
+            if (payload[0] & 0x80) {
+                if (size < 2) {
+                    return false;
+                }
+                auto ext = payload[1];
+                offset = 2;
+                if (ext & 0x80) {
+                    // PictureID, M位为1时占两个字节
+                    offset += (size > offset && (payload[offset] & 0x80)) ? 2 : 1;
+                }
+                if (ext & 0x40) {
+                    // TL0PICIDX
+                    ++offset;
+                }
+                if (ext & 0x30) {
+                    // TID/KEYIDX
+                    ++offset;
+                }
+            }
+            return size > offset && !(payload[offset] & 0x01);
+        }
+        case CodecVP9: {
+            // https://datatracker.ietf.org/doc/html/draft-ietf-payload-vp9-16#section-4.2
+            // 帧的开始(B=1)且非帧间预测(P=0)
+            return (payload[0] & 0x48) == 0x08;
+        }
+        case CodecAV1: {
+            // https://aomediacodec.github.io/av1-rtp-spec/#44-av1-aggregation-header
+            // N=1表示新的编码视频序列的第一个包
+            return payload[0] & 0x08;
+        }
+        default: return false;
+    }
+}
+
 WebRtcPlayer::Ptr WebRtcPlayer::create(const EventPoller::Ptr &poller,
                                        const RtspMediaSource::Ptr &src,
                                        const MediaInfo &info) {
@@ -48,57 +108,288 @@ void WebRtcPlayer::onStartWebRTC() {
     }
     WebRtcTransportImp::onStartWebRTC();
     if (canSendRtp()) {
+        // 同一poller内播放该源的播放器共享rtp重传缓存，协商参数相同时还共享改写后的rtp
+        shareSendCache(playSrc.get());
+        // 根据transport-cc反馈估算带宽并平滑发送
+        enableSendCongestionControl();
         playSrc->pause(false);
-        _reader = playSrc->getRing()->attach(getPoller(), true);
-        weak_ptr<WebRtcPlayer> weak_self = static_pointer_cast<WebRtcPlayer>(shared_from_this());
-        weak_ptr<Session> weak_session = static_pointer_cast<Session>(getSession());
-        _reader->setGetInfoCB([weak_session]() {
-            Any ret;
-            ret.set(static_pointer_cast<SockInfo>(weak_session.lock()));
-            return ret;
-        });
-        _reader->setReadCB([weak_self](const RtspMediaSource::RingDataType &pkt) {
-            auto strong_self = weak_self.lock();
-            if (!strong_self) {
-                return;
-            }
+        _reader = attachReader(playSrc, true);
+        startSimulcast(playSrc);
+    }
+}
 
-            if (strong_self->_send_config_frames_once && !pkt->empty()) {
-                const auto &first_rtp = pkt->front();
-                strong_self->sendConfigFrames(first_rtp->getSeq(), first_rtp->sample_rate, first_rtp->getStamp(), first_rtp->ntp_stamp);
-                strong_self->_send_config_frames_once = false;
-            }
+RtspMediaSource::RingType::RingReader::Ptr WebRtcPlayer::attachReader(const RtspMediaSource::Ptr &src, bool use_cache) {
+    auto reader = src->getRing()->attach(getPoller(), use_cache);
+    // 切换simulcast层时可能同时存在两个reader，回调中根据reader区分
+    auto reader_ptr = reader.get();
+    weak_ptr<WebRtcPlayer> weak_self = static_pointer_cast<WebRtcPlayer>(shared_from_this());
+    weak_ptr<Session> weak_session = static_pointer_cast<Session>(getSession());
+    reader->setGetInfoCB([weak_session]() {
+        Any ret;
+        ret.set(static_pointer_cast<SockInfo>(weak_session.lock()));
+        return ret;
+    });
+    reader->setReadCB([weak_self, reader_ptr](const RtspMediaSource::RingDataType &pkt) {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return;
+        }
+        if (reader_ptr == strong_self->_reader.get()) {
+            strong_self->sendRtpList(pkt);
+        } else if (strong_self->_pending_layer && reader_ptr == strong_self->_pending_layer->reader.get()) {
+            strong_self->onPendingLayerRtp(pkt);
+        }
+    });
+    reader->setDetachCB([weak_self, reader_ptr]() {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return;
+        }
+        if (reader_ptr == strong_self->_reader.get()) {
+            strong_self->onShutdown(SockException(Err_shutdown, "rtsp ring buffer detached"));
+        } else if (strong_self->_pending_layer && reader_ptr == strong_self->_pending_layer->reader.get()) {
+            // 不能在reader的回调中销毁reader
+            strong_self->getPoller()->async([weak_self]() {
+                if (auto strong_self = weak_self.lock()) {
+                    strong_self->_pending_layer = nullptr;
+                }
+            }, false);
+        }
+    });
 
-            size_t i = 0;
-            pkt->for_each([&](const RtpPacket::Ptr &rtp) {
-                //TraceL<<"send track type:"<<rtp->type<<" ts:"<<rtp->getStamp()<<" ntp:"<<rtp->ntp_stamp<<" size:"<<rtp->getPayloadSize()<<" i:"<<i;
-                strong_self->onSendRtp(rtp, ++i == pkt->size());
-            });
-        });
-        _reader->setDetachCB([weak_self]() {
-            auto strong_self = weak_self.lock();
-            if (!strong_self) {
+    reader->setMessageCB([weak_self] (const toolkit::Any &data) {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return;
+        }
+        if (data.is<Buffer>()) {
+            auto &buffer = data.get<Buffer>();
+            // PPID 51: 文本string
+            // PPID 53: 二进制
+            strong_self->sendDatachannel(0, 51, buffer.data(), buffer.size());
+        } else {
+            WarnL << "Send unknown message type to webrtc player: " << data.type_name();
+        }
+    });
+    return reader;
+}
+
+void WebRtcPlayer::sendRtpList(const RtspMediaSource::RingDataType &pkt) {
+    if (_send_config_frames_once && !pkt->empty()) {
+        const auto &first_rtp = pkt->front();
+        sendConfigFrames(first_rtp->getSeq(), first_rtp->sample_rate, first_rtp->getStamp(), first_rtp->ntp_stamp);
+        _send_config_frames_once = false;
+    }
+
+    size_t i = 0;
+    pkt->for_each([&](const RtpPacket::Ptr &rtp) {
+        //TraceL<<"send track type:"<<rtp->type<<" ts:"<<rtp->getStamp()<<" ntp:"<<rtp->ntp_stamp<<" size:"<<rtp->getPayloadSize()<<" i:"<<i;
+        sendRtp(rtp, ++i == pkt->size());
+    });
+    // 最后一个rtp可能被跳过，确保本次的rtp都已发送
+    flushRtp();
+}
+
+void WebRtcPlayer::sendRtp(const RtpPacket::Ptr &rtp, bool flush) {
+    if (rtp->type == TrackAudio) {
+        // 各simulcast层共用同一路音频，切换层后跳过已经发送过的音频
+        if (_check_audio_seq && (int16_t)(rtp->getSeq() - _last_audio_seq) <= 0) {
+            return;
+        }
+        _check_audio_seq = false;
+        _last_audio_seq = rtp->getSeq();
+    }
+    onSendRtp(rtp, flush);
+}
+
+void WebRtcPlayer::startSimulcast(const RtspMediaSource::Ptr &src) {
+    auto pusher = WebRtcPusher::findSimulcast(src->getMediaTuple());
+    if (!pusher) {
+        return;
+    }
+    for (auto &pr : pusher->getSimulcastLayers()) {
+        if (pr.second == src) {
+            _layer_rid = pr.first;
+            break;
+        }
+    }
+    _simulcast_pusher = pusher;
+    _layer_up_wait_ms = kLayerUpWaitMS;
+    InfoL << "play simulcast layer, rid:" << _layer_rid;
+
+    weak_ptr<WebRtcPlayer> weak_self = static_pointer_cast<WebRtcPlayer>(shared_from_this());
+    _layer_timer = std::make_shared<Timer>(1.0f, [weak_self]() {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return false;
+        }
+        strong_self->checkLayer();
+        return true;
+    }, getPoller());
+}
+
+bool WebRtcPlayer::setLayer(const string &rid) {
+    if (rid.empty()) {
+        // 恢复自动切换
+        _layer_pinned = false;
+        return true;
+    }
+    auto pusher = _simulcast_pusher.lock();
+    if (!pusher) {
+        return false;
+    }
+    auto layers = pusher->getSimulcastLayers();
+    auto it = layers.find(rid);
+    if (it == layers.end()) {
+        return false;
+    }
+    _layer_pinned = true;
+    switchLayer(rid, it->second, false);
+    return true;
+}
+
+const string &WebRtcPlayer::getLayer() const {
+    return _layer_rid;
+}
+
+void WebRtcPlayer::switchLayer(const string &rid, const RtspMediaSource::Ptr &src, bool up) {
+    if (rid == _layer_rid) {
+        _pending_layer = nullptr;
+        return;
+    }
+    if (_pending_layer && _pending_layer->rid == rid) {
+        return;
+    }
+    SdpParser parser(src->getSdp());
+    auto video_sdp = parser.getTrack(TrackVideo);
+    if (!video_sdp) {
+        return;
+    }
+    auto pending = std::make_shared<PendingLayer>();
+    pending->rid = rid;
+    pending->src = src;
+    pending->up = up;
+    pending->codec = getCodecId(video_sdp->_codec);
+    // h264/h265由rtp解码器判断关键帧
+    pending->decoder = Factory::getRtpDecoderByCodecId(pending->codec);
+    _pending_layer = pending;
+    pending->reader = attachReader(src, false);
+
+    if (auto pusher = _simulcast_pusher.lock()) {
+        pusher->requestKeyFrame(rid);
+    }
+    InfoL << "switch simulcast layer: " << _layer_rid << " -> " << rid;
+}
+
+void WebRtcPlayer::onPendingLayerRtp(const RtspMediaSource::RingDataType &pkt) {
+    auto pending = _pending_layer;
+    auto src = pending->src.lock();
+    if (!src) {
+        // 源注销后reader会触发detach回调
+        return;
+    }
+    size_t i = 0;
+    bool switched = false;
+    pkt->for_each([&](const RtpPacket::Ptr &rtp) {
+        ++i;
+        if (!switched) {
+            if (rtp->type != TrackVideo) {
                 return;
             }
-            strong_self->onShutdown(SockException(Err_shutdown, "rtsp ring buffer detached"));
-        });
-
-        _reader->setMessageCB([weak_self] (const toolkit::Any &data) {
-            auto strong_self = weak_self.lock();
-            if (!strong_self) {
+            auto key_pos = pending->decoder ? pending->decoder->inputRtp(rtp, false) : isKeyFrameStart(pending->codec, rtp);
+            if (!key_pos) {
                 return;
             }
-            if (data.is<Buffer>()) {
-                auto &buffer = data.get<Buffer>();
-                // PPID 51: 文本string
-                // PPID 53: 二进制
-                strong_self->sendDatachannel(0, 51, buffer.data(), buffer.size());
-            } else {
-                WarnL << "Send unknown message type to webrtc player: " << data.type_name();
+            // 在关键帧处切换，新层的rtp接着上一层的seq和时间戳发送
+            switched = true;
+            // 先记录上一层的重传缓存和偏移，再计算新层的偏移
+            shareSendCache(src.get());
+            resetSendOffset(rtp);
+            _reader = std::move(pending->reader);
+            _play_src = src;
+            _layer_rid = pending->rid;
+            _check_audio_seq = true;
+            if (!pending->up && _layer_up && _layer_ticker.elapsedTime() < kLayerPendingTimeoutMS) {
+                // 升层后很快又降层，说明带宽不足，推迟下次升层
+                _layer_up_wait_ms = std::min(_layer_up_wait_ms * 2, kLayerUpWaitMaxMS);
+            }
+            _layer_up = pending->up;
+            _layer_ticker.resetTime();
+            InfoL << "simulcast layer switched to rid:" << _layer_rid;
+        }
+        sendRtp(rtp, i == pkt->size());
+    });
+    // 最后一个rtp可能被跳过，确保本次的rtp都已发送
+    flushRtp();
+    if (switched) {
+        _pending_layer = nullptr;
+    }
+}
+
+void WebRtcPlayer::checkLayer() {
+    if (_pending_layer) {
+        if (_pending_layer->ticker.elapsedTime() > kLayerPendingTimeoutMS) {
+            WarnL << "wait key frame of simulcast layer timeout, rid:" << _layer_rid << " -> " << _pending_layer->rid;
+            _pending_layer = nullptr;
+        }
+        return;
+    }
+    if (_layer_ticker.elapsedTime() > kLayerUpWaitMaxMS) {
+        // 长时间未切换，恢复升层等待时间
+        _layer_up_wait_ms = kLayerUpWaitMS;
+    }
+    GET_CONFIG(bool, auto_switch, Rtc::kSimulcastAutoSwitch);
+    auto pusher = _simulcast_pusher.lock();
+    auto &bwe = getSendBwe();
+    if (!auto_switch || _layer_pinned || !pusher || !bwe || _layer_ticker.elapsedTime() < kLayerSwitchIntervalMS) {
+        return;
+    }
+
+    // 按视频码率从低到高排序
+    auto layers = pusher->getSimulcastLayers();
+    std::vector<std::pair<uint32_t /*bps*/, std::string /*rid*/>> bitrates;
+    uint32_t cur_bitrate = 0;
+    for (auto &pr : layers) {
+        uint32_t bitrate = pr.second->getBytesSpeed(TrackVideo) * 8;
+        if (!bitrate) {
+            // 推流端可能因为带宽不足停发了该层
+            continue;
+        }
+        bitrates.emplace_back(bitrate, pr.first);
+        if (pr.first == _layer_rid) {
+            cur_bitrate = bitrate;
+        }
+    }
+    if (bitrates.size() < 2 || !cur_bitrate) {
+        return;
+    }
+    std::sort(bitrates.begin(), bitrates.end());
+
+    auto estimate = bwe->getEstimateBitrate();
+    string target;
+    if (cur_bitrate > estimate) {
+        // 带宽不足，切换到估算带宽能承载的最高层
+        target = bitrates.front().second;
+        for (auto &pr : bitrates) {
+            if (pr.first < estimate * 0.9) {
+                target = pr.second;
+            }
+        }
+    } else if (estimate > cur_bitrate * 1.2 && bwe->getLossRate() < 0.02f && _layer_ticker.elapsedTime() > _layer_up_wait_ms) {
+        // 转发时估算码率受限于实际发送码率，无法预知更高层是否可行，无拥塞一段时间后尝试升一层，失败会很快降回
+        for (auto &pr : bitrates) {
+            if (pr.first > cur_bitrate) {
+                target = pr.second;
+                break;
             }
-        });
+        }
     }
+    if (target.empty() || target == _layer_rid) {
+        return;
+    }
+    switchLayer(target, layers[target], estimate > cur_bitrate);
 }
+
 void WebRtcPlayer::onDestory() {
     auto duration = getDuration();
     auto bytes_usage = getBytesUsage();
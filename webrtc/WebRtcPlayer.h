@@ -13,15 +13,35 @@
 
 #include "WebRtcTransport.h"
 #include "Rtsp/RtspMediaSource.h"
+#include "Rtsp/RtpCodec.h"
 
 namespace mediakit {
 
+// RTC配置项目
+namespace Rtc {
+// 播放simulcast推流时，是否根据带宽估算自动切换层
+extern const std::string kSimulcastAutoSwitch;
+} // namespace Rtc
+
+class WebRtcPusher;
 class WebRtcPlayer : public WebRtcTransportImp {
 public:
     using Ptr = std::shared_ptr<WebRtcPlayer>;
     static Ptr create(const EventPoller::Ptr &poller, const RtspMediaSource::Ptr &src, const MediaInfo &info);
     MediaInfo getMediaInfo() { return _media_info; }
 
+    /**
+     * 指定播放的simulcast层，在新层的关键帧处切换，须在poller线程调用
+     * @param rid simulcast层的rid，为空时恢复根据带宽自动切换
+     * @return 是否找到该层
+     */
+    bool setLayer(const std::string &rid);
+
+    /**
+     * 当前播放的simulcast层的rid
+     */
+    const std::string &getLayer() const;
+
 protected:
     ///////WebRtcTransportImp override///////
     void onStartWebRTC() override;
@@ -32,6 +52,14 @@ private:
     WebRtcPlayer(const EventPoller::Ptr &poller, const RtspMediaSource::Ptr &src, const MediaInfo &info);
 
     void sendConfigFrames(uint32_t before_seq, uint32_t sample_rate, uint32_t timestamp, uint64_t ntp_timestamp);
+    RtspMediaSource::RingType::RingReader::Ptr attachReader(const RtspMediaSource::Ptr &src, bool use_cache);
+    void sendRtpList(const RtspMediaSource::RingDataType &pkt);
+    void sendRtp(const RtpPacket::Ptr &rtp, bool flush);
+
+    void startSimulcast(const RtspMediaSource::Ptr &src);
+    void switchLayer(const std::string &rid, const RtspMediaSource::Ptr &src, bool up);
+    void onPendingLayerRtp(const RtspMediaSource::RingDataType &pkt);
+    void checkLayer();
 
 private:
     //媒体相关元数据
@@ -44,6 +72,33 @@ private:
 
     //播放rtsp源的reader对象
     RtspMediaSource::RingType::RingReader::Ptr _reader;
+
+    //等待关键帧以切换的simulcast层
+    struct PendingLayer {
+        bool up;
+        CodecId codec;
+        std::string rid;
+        std::weak_ptr<RtspMediaSource> src;
+        RtspMediaSource::RingType::RingReader::Ptr reader;
+        RtpCodec::Ptr decoder;
+        toolkit::Ticker ticker;
+    };
+    std::shared_ptr<PendingLayer> _pending_layer;
+    //simulcast推流器
+    std::weak_ptr<WebRtcPusher> _simulcast_pusher;
+    //当前播放的simulcast层
+    std::string _layer_rid;
+    //通过api指定层后不再自动切换
+    bool _layer_pinned = false;
+    //上次切换是否为升层
+    bool _layer_up = false;
+    uint64_t _layer_up_wait_ms = 0;
+    //距离上次切换层的时间
+    toolkit::Ticker _layer_ticker;
+    toolkit::Timer::Ptr _layer_timer;
+    //各层共用同一路音频，切换层后需要跳过已经发送的音频
+    bool _check_audio_seq = false;
+    uint16_t _last_audio_seq = 0;
 };
 
 }// namespace mediakit
@@ -16,6 +16,21 @@ using namespace std;
 
 namespace mediakit {
 
+// simulcast各层源与推流器的对应关系，方便播放器在各层间切换
+static mutex s_simulcast_mtx;
+static unordered_map<string /*vhost/app/stream*/, weak_ptr<WebRtcPusher>> s_simulcast_map;
+
+WebRtcPusher::Ptr WebRtcPusher::findSimulcast(const MediaTuple &tuple) {
+    lock_guard<mutex> lck(s_simulcast_mtx);
+    auto it = s_simulcast_map.find(tuple.shortUrl());
+    return it == s_simulcast_map.end() ? nullptr : it->second.lock();
+}
+
+unordered_map<string, RtspMediaSource::Ptr> WebRtcPusher::getSimulcastLayers() {
+    std::lock_guard<std::recursive_mutex> lock(_mtx);
+    return _push_src_sim;
+}
+
 WebRtcPusher::Ptr WebRtcPusher::create(const EventPoller::Ptr &poller,
                                        const RtspMediaSource::Ptr &src,
                                        const std::shared_ptr<void> &ownership,
@@ -105,6 +120,8 @@ void WebRtcPusher::onRecvRtp(MediaTrack &track, const string &rid, RtpPacket::Pt
             _push_src_sim_ownership[rid] = src_imp->getOwnership();
             src_imp->setListener(static_pointer_cast<WebRtcPusher>(shared_from_this()));
             src = src_imp;
+            lock_guard<mutex> lck(s_simulcast_mtx);
+            s_simulcast_map[src->getMediaTuple().shortUrl()] = static_pointer_cast<WebRtcPusher>(shared_from_this());
         }
         src->onWrite(std::move(rtp), false);
     }
@@ -131,6 +148,18 @@ void WebRtcPusher::onDestory() {
         }
     }
 
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mtx);
+        lock_guard<mutex> lck(s_simulcast_mtx);
+        for (auto &pr : _push_src_sim) {
+            auto it = s_simulcast_map.find(pr.second->getMediaTuple().shortUrl());
+            // 同名流可能已经被新的推流器注册
+            if (it != s_simulcast_map.end() && it->second.expired()) {
+                s_simulcast_map.erase(it);
+            }
+        }
+    }
+
     if (_push_src && _continue_push_ms) {
         //取消所有权
         _push_src_ownership = nullptr;
@@ -22,6 +22,17 @@ public:
     static Ptr create(const EventPoller::Ptr &poller, const RtspMediaSource::Ptr &src,
                       const std::shared_ptr<void> &ownership, const MediaInfo &info, const ProtocolOption &option);
 
+    /**
+     * 根据simulcast某一层的源查找推流器
+     * @param tuple 某一层源的MediaTuple
+     */
+    static Ptr findSimulcast(const MediaTuple &tuple);
+
+    /**
+     * 获取simulcast各层的源，可在任意线程调用
+     */
+    std::unordered_map<std::string/*rid*/, RtspMediaSource::Ptr> getSimulcastLayers();
+
 protected:
     ///////WebRtcTransportImp override///////
     void onStartWebRTC() override;
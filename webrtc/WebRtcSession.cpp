@@ -11,6 +11,7 @@
 #include "WebRtcSession.h"
 #include "Util/util.h"
 #include "Network/TcpServer.h"
+#include "Network/sockutil.h"
 #include "Common/config.h"
 #include "IceServer.hpp"
 #include "WebRtcTransport.h"
@@ -36,12 +37,12 @@ static string getUserName(const char *buf, size_t len) {
     return vec[0];
 }
 
-EventPoller::Ptr WebRtcSession::queryPoller(const Buffer::Ptr &buffer) {
+EventPoller::Ptr WebRtcSession::queryPoller(const Buffer::Ptr &buffer, const struct sockaddr *peer) {
     auto user_name = getUserName(buffer->data(), buffer->size());
     if (user_name.empty()) {
         return nullptr;
     }
-    auto ret = WebRtcTransportManager::Instance().getItem(user_name);
+    auto ret = WebRtcTransportManager::Instance().getItem(user_name, peer);
     return ret ? ret->getPoller() : nullptr;
 }
 
@@ -60,7 +61,14 @@ void WebRtcSession::onRecv_l(const char *data, size_t len) {
         // 只允许寻找一次transport
         _find_transport = false;
         auto user_name = getUserName(data, len);
-        auto transport = WebRtcTransportManager::Instance().getItem(user_name);
+        WebRtcTransportImp::Ptr transport;
+        if (_over_tcp) {
+            transport = WebRtcTransportManager::Instance().getItem(user_name);
+        } else {
+            //udp会话的首包通常刚在queryPoller中查找过(开启udp分发时位于同一线程)，可命中查找缓存
+            auto peer = SockUtil::make_sockaddr(get_peer_ip().data(), get_peer_port());
+            transport = WebRtcTransportManager::Instance().getItem(user_name, (struct sockaddr *)&peer);
+        }
         CHECK(transport);
 
         //WebRtcTransport在其他poller线程上，需要切换poller线程并重新创建WebRtcSession对象
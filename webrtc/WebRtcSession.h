@@ -32,7 +32,8 @@ public:
     void onRecv(const Buffer::Ptr &) override;
     void onError(const SockException &err) override;
     void onManager() override;
-    static EventPoller::Ptr queryPoller(const Buffer::Ptr &buffer);
+    static EventPoller::Ptr queryPoller(const Buffer::Ptr &buffer, const struct sockaddr *peer = nullptr);
+    const WebRtcTransportImp::Ptr &getTransport() const { return _transport; }
 
 protected:
     WebRtcTransportImp::Ptr _transport;
@@ -25,6 +25,7 @@
 #include "WebRtcEchoTest.h"
 #include "WebRtcPlayer.h"
 #include "WebRtcPusher.h"
+#include "WebRtcUdpSteering.h"
 #include "Rtsp/RtspMediaSourceImp.h"
 
 #define RTP_SSRC_OFFSET 1
@@ -58,6 +59,23 @@ const string kMinBitrate = RTC_FIELD "min_bitrate";
 // 数据通道设置
 const string kDataChannelEcho = RTC_FIELD "datachannel_echo";
 
+// rtc播放时是否批量srtp加密一次flush的rtp
+const string kSrtpBatch = RTC_FIELD "srtpBatch";
+
+// 是否在协商参数相同的rtc播放器间共享改写后的rtp明文
+const string kShareRtpCache = RTC_FIELD "shareRtpCache";
+
+// 是否开启rtc播放时的发送端拥塞控制(基于transport-cc反馈估算带宽并平滑发送)
+const string kSendCongestionControl = RTC_FIELD "sendCongestionControl";
+// 平滑发送队列最大排队时长，超过后加速发送，单位毫秒
+const string kPacerMaxQueueMS = RTC_FIELD "pacerMaxQueueMS";
+
+// 播放simulcast推流时，是否根据带宽估算自动切换层
+const string kSimulcastAutoSwitch = RTC_FIELD "simulcastAutoSwitch";
+
+// 是否根据ice ufrag把rtc udp数据直接分发到所属poller的SO_REUSEPORT socket(仅linux)
+const string kUdpSteering = RTC_FIELD "udpSteering";
+
 static onceToken token([]() {
     mINI::Instance()[kTimeOutSec] = 15;
     mINI::Instance()[kExternIP] = "";
@@ -70,6 +88,17 @@ static onceToken token([]() {
     mINI::Instance()[kMinBitrate] = 0;
 
     mINI::Instance()[kDataChannelEcho] = true;
+
+    mINI::Instance()[kSrtpBatch] = 1;
+
+    mINI::Instance()[kShareRtpCache] = 0;
+
+    mINI::Instance()[kSendCongestionControl] = 1;
+    mINI::Instance()[kPacerMaxQueueMS] = 500;
+
+    mINI::Instance()[kSimulcastAutoSwitch] = 1;
+
+    mINI::Instance()[kUdpSteering] = 0;
 });
 
 } // namespace RTC
@@ -95,6 +124,7 @@ static std::string getServerPrefix() {
     //stun_user_name格式: base64(ip+udp_port+tcp_port) + _ + number
     //其中ip为二进制char[4], udp_port/tcp_port为大端 uint16.
     //number为自增长数，确保短时间内唯一
+    //开启rtc.udpSteering时，number前还有一个字符的poller标记，参考WebRtcUdpSteering
     GET_CONFIG(uint16_t, udp_port, Rtc::kPort);
     GET_CONFIG(uint16_t, tcp_port, Rtc::kTcpPort);
     char buf[8];
@@ -127,7 +157,8 @@ const char* sockTypeStr(Session* session) {
 WebRtcTransport::WebRtcTransport(const EventPoller::Ptr &poller) {
     _poller = poller;
     static auto prefix = getServerPrefix();
-    _identifier = prefix + to_string(++s_key);
+    //开启udp分发时在number前插入poller标记，使stun包直接投递到本poller的socket
+    _identifier = prefix + WebRtcUdpSteering::Instance().getUfragTag(poller) + to_string(++s_key);
     _packet_pool.setSize(64);
 }
 
@@ -429,6 +460,9 @@ std::string WebRtcTransport::getAnswerSdp(const string &offer) {
     }
 }
 
+// 平滑发送码率相对带宽估算值的倍数，留出余量避免关键帧排队过久
+static constexpr double kPacingFactor = 2.5;
+
 static bool isDtls(char *buf) {
     return ((*buf > 19) && (*buf < 64));
 }
@@ -469,20 +503,54 @@ void WebRtcTransport::inputSockData(char *buf, int len, RTC::TransportTuple *tup
     }
 }
 
+BufferRaw::Ptr WebRtcTransport::prepareRtpPacket(const char *buf, int len, void *ctx) {
+    auto pkt = _packet_pool.obtain2();
+    // 预留rtx加入的两个字节，以及transport-cc扩展的8个字节
+    pkt->setCapacity((size_t)len + SRTP_MAX_TRAILER_LEN + 2 + 8);
+    memcpy(pkt->data(), buf, len);
+    onBeforeEncryptRtp(pkt->data(), len, ctx);
+    pkt->setSize(len);
+    return pkt;
+}
+
 void WebRtcTransport::sendRtpPacket(const char *buf, int len, bool flush, void *ctx) {
     if (_srtp_session_send) {
-        auto pkt = _packet_pool.obtain2();
-        // 预留rtx加入的两个字节
-        pkt->setCapacity((size_t)len + SRTP_MAX_TRAILER_LEN + 2);
-        memcpy(pkt->data(), buf, len);
-        onBeforeEncryptRtp(pkt->data(), len, ctx);
+        auto pkt = prepareRtpPacket(buf, len, ctx);
+        len = (int)pkt->size();
         if (_srtp_session_send->EncryptRtp(reinterpret_cast<uint8_t *>(pkt->data()), &len)) {
             pkt->setSize(len);
-            onSendSockData(std::move(pkt), flush);
+            onSendEncryptedRtp(std::move(pkt), flush, ctx);
         }
     }
 }
 
+void WebRtcTransport::sendRtpPacketList(std::vector<BufferRaw::Ptr> &pkts, void *const *ctxs, bool flush) {
+    if (!_srtp_session_send || pkts.empty()) {
+        return;
+    }
+    auto count = pkts.size();
+    _batch_data.resize(count);
+    _batch_len.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        _batch_data[i] = reinterpret_cast<uint8_t *>(pkts[i]->data());
+        _batch_len[i] = (int)pkts[i]->size();
+    }
+    _srtp_session_send->EncryptRtpList(_batch_data.data(), _batch_len.data(), count);
+    // 最后一个加密成功的rtp负责flush
+    auto last = count;
+    while (last > 0 && !_batch_len[last - 1]) {
+        --last;
+    }
+    for (size_t i = 0; i < last; ++i) {
+        if (!_batch_len[i]) {
+            // 加密失败
+            continue;
+        }
+        pkts[i]->setSize(_batch_len[i]);
+        onSendEncryptedRtp(std::move(pkts[i]), flush && i + 1 == last, ctxs[i]);
+    }
+}
+
 void WebRtcTransport::sendRtcpPacket(const char *buf, int len, bool flush, void *ctx) {
     if (_srtp_session_send) {
         auto pkt = _packet_pool.obtain2();
@@ -533,6 +601,8 @@ void WebRtcTransportImp::OnDtlsTransportApplicationDataReceived(const RTC::DtlsT
 
 WebRtcTransportImp::WebRtcTransportImp(const EventPoller::Ptr &poller) : WebRtcTransport(poller) {
     InfoL << getIdentifier();
+    GET_CONFIG(bool, srtp_batch, Rtc::kSrtpBatch);
+    _srtp_batch = srtp_batch;
 }
 
 WebRtcTransportImp::~WebRtcTransportImp() {
@@ -553,6 +623,23 @@ void WebRtcTransportImp::onSendSockData(Buffer::Ptr buf, bool flush, RTC::Transp
         }
     }
 
+    GET_CONFIG(int, udp_batch_send, Rtp::kUdpBatchSend);
+    if (udp_batch_send != UdpBatchSender::kModeOff && tuple->getSock()->sockType() == SockNum::Sock_UDP) {
+        // 一次flush的数据通过一次sendmmsg发送
+        if (!_udp_batch_sender || _udp_batch_sender->getSock() != tuple->getSock()) {
+            if (_udp_batch_sender) {
+                // 链接迁移，先发送旧链路上缓存的数据
+                _udp_batch_sender->flush();
+            }
+            _udp_batch_sender = std::make_shared<UdpBatchSender>(tuple->getSock());
+        }
+        _udp_batch_sender->input(std::move(buf));
+        if (flush) {
+            _udp_batch_sender->flush();
+        }
+        return;
+    }
+
     // 一次性发送一帧的rtp数据，提高网络io性能
     if (tuple->getSock()->sockType() == SockNum::Sock_TCP) {
         // 增加tcp两字节头
@@ -606,6 +693,7 @@ void WebRtcTransportImp::onStartWebRTC() {
         track->plan_rtp = &m_answer.plan[0];
         track->plan_rtx = m_answer.getRelatedRtxPlan(track->plan_rtp->pt);
         track->rtcp_context_send = std::make_shared<RtcpContextForSend>();
+        track->nack_list = std::make_shared<NackList>();
 
         // rtp track type --> MediaTrack
         if (m_answer.direction == RtpDirection::sendonly || m_answer.direction == RtpDirection::sendrecv) {
@@ -659,6 +747,91 @@ void WebRtcTransportImp::onStartWebRTC() {
     }
 }
 
+void WebRtcTransportImp::shareSendCache(const void *owner) {
+    GET_CONFIG(bool, share_rtp_cache, Rtc::kShareRtpCache);
+    for (auto &track : _type_to_track) {
+        if (!track) {
+            continue;
+        }
+        // 缓存只在同一poller线程内共享，无需加锁
+        _StrPrinter key;
+        key << owner << '/' << getPoller().get() << '/' << track->media->type;
+        if (track->nack_list && track->rtp_sent) {
+            // 切换rtp源，保留上一个源的重传缓存，用于重传切换前发送的rtp
+            track->prev_nack_list = std::move(track->nack_list);
+            track->prev_seq_switched = track->seq_switched;
+            track->prev_seq_begin = track->seq_begin;
+            track->prev_seq_offset = track->seq_offset;
+            track->prev_stamp_offset = track->stamp_offset;
+            track->seq_switched = true;
+            track->seq_begin = track->last_send_seq + 1;
+        }
+        // 重传的是源rtp包，与协商参数无关
+        track->nack_list = NackList::getShared(key);
+        if (share_rtp_cache) {
+            // 改写rtp头只取决于pt、ssrc和rtp ext id映射
+            key << '/' << (int)track->plan_rtp->pt << '/' << track->answer_ssrc_rtp << '/' << track->rtp_ext_ctx->getSendExtIdKey();
+            track->rtp_cache = SharedRtpCache::get(key);
+        }
+    }
+}
+
+void WebRtcTransportImp::enableSendCongestionControl() {
+    GET_CONFIG(bool, send_congestion_control, Rtc::kSendCongestionControl);
+    if (!send_congestion_control) {
+        return;
+    }
+    bool has_twcc = false;
+    for (auto &track : _type_to_track) {
+        if (track) {
+            track->twcc_ext_id = track->rtp_ext_ctx->getSendExtId(RtpExtType::transport_cc);
+            has_twcc = has_twcc || track->twcc_ext_id;
+        }
+    }
+    if (!has_twcc) {
+        // 对方不支持transport-cc，无法估算带宽
+        return;
+    }
+
+    GET_CONFIG(uint32_t, max_bitrate, Rtc::kMaxBitrate);
+    GET_CONFIG(uint32_t, min_bitrate, Rtc::kMinBitrate);
+    GET_CONFIG(uint32_t, start_bitrate, Rtc::kStartBitrate);
+    // 配置单位为kbps，未配置时使用默认值
+    _send_bwe = std::make_shared<SendSideBwe>(start_bitrate ? start_bitrate * 1000 : 2 * 1000 * 1000,
+                                              min_bitrate ? min_bitrate * 1000 : 100 * 1000,
+                                              max_bitrate ? max_bitrate * 1000 : 100 * 1000 * 1000);
+    _pacer = std::make_shared<RtpPacer>(getPoller(), [this](Buffer::Ptr buf, bool flush, int twcc_seq) {
+        if (twcc_seq >= 0) {
+            _send_bwe->onSendPacket(twcc_seq, buf->size(), getCurrentMicrosecond());
+        }
+        onSendSockData(std::move(buf), flush);
+    });
+    _pacer->setPacingRate(_send_bwe->getEstimateBitrate() * kPacingFactor);
+}
+
+void WebRtcTransportImp::resetSendOffset(const RtpPacket::Ptr &rtp) {
+    auto &track = _type_to_track[rtp->type];
+    if (!track || !track->rtp_sent) {
+        return;
+    }
+    // 根据ntp时间戳计算与上次发送的rtp的时间差，异常时按一帧间隔估算
+    auto diff_ms = (int64_t)rtp->ntp_stamp - (int64_t)track->last_send_ntp;
+    if (diff_ms <= 0 || diff_ms > 1000) {
+        diff_ms = 40;
+    }
+    auto stamp = track->last_send_stamp + (uint32_t)(diff_ms * rtp->sample_rate / 1000);
+    track->stamp_offset = stamp - rtp->getStamp();
+    track->seq_offset = track->last_send_seq + 1 - rtp->getSeq();
+}
+
+const SendSideBwe::Ptr &WebRtcTransportImp::getSendBwe() const {
+    return _send_bwe;
+}
+
+const RtpPacer::Ptr &WebRtcTransportImp::getPacer() const {
+    return _pacer;
+}
+
 void WebRtcTransportImp::onCheckAnswer(RtcSession &sdp) {
     // 修改answer sdp的ip、端口信息
     GET_CONFIG_FUNC(std::vector<std::string>, extern_ips, Rtc::kExternIP, [](string str) {
@@ -960,12 +1133,11 @@ void WebRtcTransportImp::onRtcp(const char *buf, size_t len) {
                     WarnL << "未识别的 rtcp包:" << rtcp->dumpString();
                     return;
                 }
-                auto &track = it->second;
-                auto &fci = fb->getFci<FCI_NACK>();
-                track->nack_list.forEach(fci, [&](const RtpPacket::Ptr &rtp) {
-                    // rtp重传
-                    onSendRtp(rtp, true, true);
-                });
+                onRecvNack(*it->second, fb->getFci<FCI_NACK>());
+                break;
+            }
+            case RTPFBType::RTCP_RTPFB_TWCC: {
+                onRecvTwcc((RtcpFB *)rtcp);
                 break;
             }
             default:
@@ -1014,6 +1186,27 @@ void WebRtcTransportImp::createRtpChannel(const string &rid, uint32_t ssrc, Medi
     InfoL << "create rtp receiver of ssrc:" << ssrc << ", rid:" << rid << ", codec:" << track.plan_rtp->codec;
 }
 
+void WebRtcTransportImp::requestKeyFrame(const string &rid) {
+    weak_ptr<WebRtcTransportImp> weak_self = static_pointer_cast<WebRtcTransportImp>(shared_from_this());
+    getPoller()->async([weak_self, rid]() {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return;
+        }
+        for (auto &pr : strong_self->_ssrc_to_track) {
+            auto &track = pr.second;
+            if (track->media->type != TrackVideo) {
+                continue;
+            }
+            auto it = track->rtp_channel.find(rid);
+            if (it != track->rtp_channel.end()) {
+                strong_self->sendRtcpPli(it->second->getSSRC());
+                return;
+            }
+        }
+    }, false);
+}
+
 void WebRtcTransportImp::updateTicker() {
     _alive_ticker.resetTime();
 }
@@ -1128,18 +1321,60 @@ void WebRtcTransportImp::onSortedRtp(MediaTrack &track, const string &rid, RtpPa
 
 ///////////////////////////////////////////////////////////////////
 
+// 单次批量加密的最大rtp个数
+static constexpr size_t kMaxRtpBatch = 256;
+
+void WebRtcTransportImp::onRecvNack(MediaTrack &track, const FCI_NACK &fci) {
+    if (!track.seq_switched) {
+        track.nack_list->forEach(fci, [&](const RtpPacket::Ptr &rtp) {
+            // rtp重传
+            onSendRtp(rtp, true, true);
+        });
+        return;
+    }
+    // 切换过rtp源，nack的seq需要按发送时所属的源还原为源rtp的seq
+    auto seq = fci.getPid();
+    for (auto bit : fci.getBitArray()) {
+        if (bit) {
+            RtpPacket::Ptr rtp;
+            if ((int16_t)(seq - track.seq_begin) >= 0) {
+                rtp = track.nack_list->get(seq - track.seq_offset);
+                if (rtp) {
+                    onSendRtp_l(rtp, true, true, track.seq_offset, track.stamp_offset);
+                }
+            } else if (track.prev_nack_list && (!track.prev_seq_switched || (int16_t)(seq - track.prev_seq_begin) >= 0)) {
+                rtp = track.prev_nack_list->get(seq - track.prev_seq_offset);
+                if (rtp) {
+                    onSendRtp_l(rtp, true, true, track.prev_seq_offset, track.prev_stamp_offset);
+                }
+            }
+            // 更早的rtp已无法确定来源，不重传，避免用本播放器的ssrc发送无关的rtp
+        }
+        ++seq;
+    }
+}
+
 void WebRtcTransportImp::onSendRtp(const RtpPacket::Ptr &rtp, bool flush, bool rtx) {
     auto &track = _type_to_track[rtp->type];
     if (!track) {
         // 忽略，对方不支持该编码类型
         return;
     }
+    onSendRtp_l(rtp, flush, rtx, track->seq_offset, track->stamp_offset);
+}
+
+void WebRtcTransportImp::onSendRtp_l(const RtpPacket::Ptr &rtp, bool flush, bool rtx, uint16_t seq_offset, uint32_t stamp_offset) {
+    auto &track = _type_to_track[rtp->type];
     if (!rtx) {
         // 统计rtp发送情况，好做sr汇报
-        track->rtcp_context_send->onRtp(
-            rtp->getSeq(), rtp->getStamp(), rtp->ntp_stamp, rtp->sample_rate,
-            rtp->size() - RtpPacket::kRtpTcpHeaderSize);
-        track->nack_list.pushBack(rtp);
+        auto seq = (uint16_t)(rtp->getSeq() + seq_offset);
+        auto stamp = rtp->getStamp() + stamp_offset;
+        track->rtcp_context_send->onRtp(seq, stamp, rtp->ntp_stamp, rtp->sample_rate, rtp->size() - RtpPacket::kRtpTcpHeaderSize);
+        track->rtp_sent = true;
+        track->last_send_seq = seq;
+        track->last_send_stamp = stamp;
+        track->last_send_ntp = rtp->ntp_stamp;
+        track->nack_list->pushBack(rtp);
 #if 0
         //此处模拟发送丢包
         if (rtp->type == TrackVideo && rtp->getSeq() % 100 == 0) {
@@ -1150,36 +1385,95 @@ void WebRtcTransportImp::onSendRtp(const RtpPacket::Ptr &rtp, bool flush, bool r
         // 发送rtx重传包
         // TraceL << "send rtx rtp:" << rtp->getSeq();
     }
-    pair<bool /*rtx*/, MediaTrack *> ctx { rtx, track.get() };
-    sendRtpPacket(rtp->data() + RtpPacket::kRtpTcpHeaderSize, rtp->size() - RtpPacket::kRtpTcpHeaderSize, flush, &ctx);
+    SendRtpContext ctx { rtx, track.get(), seq_offset, stamp_offset };
+    const char *data = rtp->data() + RtpPacket::kRtpTcpHeaderSize;
+    auto len = (int)(rtp->size() - RtpPacket::kRtpTcpHeaderSize);
+    if (!rtx && track->rtp_cache) {
+        // 改写rtp头的结果与其他播放器共享，本播放器只做srtp加密
+        auto &buf = track->rtp_cache->fetch(rtp, [&](char *data, int &len) { rewriteRtpHeader(data, len, false, *track, seq_offset); });
+        ctx.rewritten = true;
+        data = buf.data();
+        len = (int)buf.size();
+    }
     _bytes_usage += rtp->size() - RtpPacket::kRtpTcpHeaderSize;
+    if (!_srtp_batch) {
+        sendRtpPacket(data, len, flush, &ctx);
+        return;
+    }
+    // 一次flush的rtp先改写头部并缓存，flush时一次性加密并发送
+    _rtp_batch_ctx.emplace_back(ctx);
+    _rtp_batch.emplace_back(prepareRtpPacket(data, len, &_rtp_batch_ctx.back()));
+    if (flush || _rtp_batch.size() >= kMaxRtpBatch) {
+        flushRtpBatch(flush);
+    }
+}
+
+void WebRtcTransportImp::flushRtpBatch(bool flush) {
+    _rtp_batch_ctx_ptr.clear();
+    for (auto &ctx : _rtp_batch_ctx) {
+        _rtp_batch_ctx_ptr.emplace_back(&ctx);
+    }
+    sendRtpPacketList(_rtp_batch, _rtp_batch_ctx_ptr.data(), flush);
+    _rtp_batch.clear();
+    _rtp_batch_ctx.clear();
+}
+
+void WebRtcTransportImp::flushRtp() {
+    if (!_rtp_batch.empty()) {
+        flushRtpBatch(true);
+    } else if (_udp_batch_sender) {
+        _udp_batch_sender->flush();
+    }
 }
 
 void WebRtcTransportImp::onBeforeEncryptRtp(const char *buf, int &len, void *ctx) {
-    auto pr = (pair<bool /*rtx*/, MediaTrack *> *)ctx;
+    auto send_ctx = (SendRtpContext *)ctx;
+    if (!send_ctx) {
+        return;
+    }
+    auto &track = *send_ctx->track;
+    if (!send_ctx->rewritten) {
+        rewriteRtpHeader(buf, len, send_ctx->rtx, track, send_ctx->seq_offset);
+    }
+    if (send_ctx->seq_offset || send_ctx->stamp_offset) {
+        // 切换过rtp源，保持seq和时间戳连续；rtx的seq已经单独生成
+        auto header = (RtpHeader *)buf;
+        if (!send_ctx->rtx || !track.plan_rtx) {
+            header->seq = htons(ntohs(header->seq) + send_ctx->seq_offset);
+        }
+        header->stamp = htonl(ntohl(header->stamp) + send_ctx->stamp_offset);
+    }
+    if (_send_bwe && send_ctx->track->twcc_ext_id) {
+        // 每个发送的rtp(包括rtx)都分配transport-cc序号，用于对端反馈接收情况
+        send_ctx->twcc_seq = _twcc_send_seq++;
+        RtpExt::setTransportCCSeq((RtpHeader *)buf, len, send_ctx->track->twcc_ext_id, send_ctx->twcc_seq);
+    }
+}
+
+void WebRtcTransportImp::rewriteRtpHeader(const char *buf, int &len, bool rtx, MediaTrack &track, uint16_t seq_offset) {
     auto header = (RtpHeader *)buf;
 
-    if (!pr->first || !pr->second->plan_rtx) {
+    if (!rtx || !track.plan_rtx) {
         // 普通的rtp,或者不支持rtx, 修改目标pt和ssrc
-        pr->second->rtp_ext_ctx->changeRtpExtId(header, false);
-        header->pt = pr->second->plan_rtp->pt;
-        header->ssrc = htonl(pr->second->answer_ssrc_rtp);
+        track.rtp_ext_ctx->changeRtpExtId(header, false);
+        header->pt = track.plan_rtp->pt;
+        header->ssrc = htonl(track.answer_ssrc_rtp);
     } else {
         // 重传的rtp, rtx
-        pr->second->rtp_ext_ctx->changeRtpExtId(header, false);
-        header->pt = pr->second->plan_rtx->pt;
-        if (pr->second->answer_ssrc_rtx) {
+        track.rtp_ext_ctx->changeRtpExtId(header, false);
+        header->pt = track.plan_rtx->pt;
+        if (track.answer_ssrc_rtx) {
             // 有rtx单独的ssrc,有些情况下，浏览器支持rtx，但是未指定rtx单独的ssrc
-            header->ssrc = htonl(pr->second->answer_ssrc_rtx);
+            header->ssrc = htonl(track.answer_ssrc_rtx);
         } else {
             // 未单独指定rtx的ssrc，那么使用rtp的ssrc
-            header->ssrc = htonl(pr->second->answer_ssrc_rtp);
+            header->ssrc = htonl(track.answer_ssrc_rtp);
         }
 
-        auto origin_seq = ntohs(header->seq);
+        auto origin_seq = (uint16_t)(ntohs(header->seq) + seq_offset);
         // seq跟原来的不一样
-        header->seq = htons(_rtx_seq[pr->second->media->type]);
-        ++_rtx_seq[pr->second->media->type];
+        header->seq = htons(_rtx_seq[track.media->type]);
+        ++_rtx_seq[track.media->type];
 
         auto payload = header->getPayloadData();
         auto payload_size = header->getPayloadSize(len);
@@ -1194,6 +1488,28 @@ void WebRtcTransportImp::onBeforeEncryptRtp(const char *buf, int &len, void *ctx
     }
 }
 
+void WebRtcTransportImp::onSendEncryptedRtp(Buffer::Ptr buf, bool flush, void *ctx) {
+    if (!_pacer) {
+        onSendSockData(std::move(buf), flush);
+        return;
+    }
+    auto send_ctx = (SendRtpContext *)ctx;
+    _pacer->send(std::move(buf), flush, send_ctx ? send_ctx->twcc_seq : -1);
+}
+
+void WebRtcTransportImp::onRecvTwcc(const RtcpFB *fb) {
+    if (!_send_bwe) {
+        return;
+    }
+    try {
+        _send_bwe->onTwccFeedback(fb->getFci<FCI_TWCC>(), fb->getFciSize(), getCurrentMicrosecond());
+    } catch (std::exception &ex) {
+        WarnL << "解析twcc rtcp失败:" << ex.what();
+        return;
+    }
+    _pacer->setPacingRate(_send_bwe->getEstimateBitrate() * kPacingFactor);
+}
+
 void WebRtcTransportImp::safeShutdown(const SockException &ex) {
     std::weak_ptr<WebRtcTransportImp> weak_self = static_pointer_cast<WebRtcTransportImp>(shared_from_this());
     getPoller()->async([ex, weak_self]() {
@@ -1231,6 +1547,7 @@ void WebRtcTransportImp::onRtcpBye(){}
 void WebRtcTransportImp::registerSelf() {
     _self = static_pointer_cast<WebRtcTransportImp>(shared_from_this());
     WebRtcTransportManager::Instance().addItem(getIdentifier(), _self);
+    _registered = true;
 }
 
 void WebRtcTransportImp::unrefSelf() {
@@ -1239,34 +1556,132 @@ void WebRtcTransportImp::unrefSelf() {
 
 void WebRtcTransportImp::unregisterSelf() {
     unrefSelf();
+    //先使各线程的查找缓存失效
+    _registered = false;
     WebRtcTransportManager::Instance().removeItem(getIdentifier());
 }
 
+/**
+ * WebRtcTransport注册表分片
+ * 写时复制：注册/注销在分片锁内复制并替换整个map，收包线程查找时只需原子获取当前快照，不阻塞写入
+ */
+class WebRtcTransportShard {
+public:
+    using Map = unordered_map<string, weak_ptr<WebRtcTransportImp>>;
+    using MapPtr = shared_ptr<const Map>;
+
+    MapPtr snapshot() const { return atomic_load(&_map); }
+
+    void modify(const function<void(Map &map)> &cb) {
+        lock_guard<mutex> lck(_mtx);
+        auto map = std::make_shared<Map>(*_map);
+        cb(*map);
+        atomic_store(&_map, MapPtr(std::move(map)));
+    }
+
+private:
+    mutex _mtx;
+    MapPtr _map = std::make_shared<Map>();
+};
+
+// 分片个数，2的幂
+static constexpr size_t kWebRtcTransportShards = 64;
+static WebRtcTransportShard s_transport_shards[kWebRtcTransportShards];
+
+static WebRtcTransportShard &getTransportShard(const string &key) {
+    return s_transport_shards[std::hash<string>()(key) & (kWebRtcTransportShards - 1)];
+}
+
+/**
+ * 按对端地址直接映射的查找缓存，每个线程一份
+ */
+struct TransportTupleCache {
+    struct sockaddr_storage addr;
+    string key;
+    weak_ptr<WebRtcTransportImp> transport;
+
+    TransportTupleCache() { memset(&addr, 0, sizeof(addr)); }
+};
+
+// 缓存个数，2的幂
+static constexpr size_t kTransportTupleCacheSize = 256;
+static thread_local TransportTupleCache s_tuple_cache[kTransportTupleCacheSize];
+
+static size_t hashPeer(const struct sockaddr *addr) {
+    if (addr->sa_family == AF_INET) {
+        auto in = reinterpret_cast<const struct sockaddr_in *>(addr);
+        return in->sin_addr.s_addr * 31 + in->sin_port;
+    }
+    auto in6 = reinterpret_cast<const struct sockaddr_in6 *>(addr);
+    uint32_t words[4];
+    memcpy(words, &in6->sin6_addr, sizeof(words));
+    return ((words[0] * 31 + words[1]) * 31 + words[2]) * 31 + words[3] + in6->sin6_port;
+}
+
+static bool samePeer(const struct sockaddr *addr, const struct sockaddr_storage &cached) {
+    if (addr->sa_family != cached.ss_family) {
+        return false;
+    }
+    if (addr->sa_family == AF_INET) {
+        auto a = reinterpret_cast<const struct sockaddr_in *>(addr);
+        auto b = reinterpret_cast<const struct sockaddr_in *>(&cached);
+        return a->sin_port == b->sin_port && a->sin_addr.s_addr == b->sin_addr.s_addr;
+    }
+    auto a = reinterpret_cast<const struct sockaddr_in6 *>(addr);
+    auto b = reinterpret_cast<const struct sockaddr_in6 *>(&cached);
+    return a->sin6_port == b->sin6_port && memcmp(&a->sin6_addr, &b->sin6_addr, sizeof(a->sin6_addr)) == 0;
+}
+
 WebRtcTransportManager &WebRtcTransportManager::Instance() {
     static WebRtcTransportManager s_instance;
     return s_instance;
 }
 
 void WebRtcTransportManager::addItem(const string &key, const WebRtcTransportImp::Ptr &ptr) {
-    lock_guard<mutex> lck(_mtx);
-    _map[key] = ptr;
+    getTransportShard(key).modify([&](WebRtcTransportShard::Map &map) {
+        map[key] = ptr;
+    });
 }
 
 WebRtcTransportImp::Ptr WebRtcTransportManager::getItem(const string &key) {
     if (key.empty()) {
         return nullptr;
     }
-    lock_guard<mutex> lck(_mtx);
-    auto it = _map.find(key);
-    if (it == _map.end()) {
+    auto map = getTransportShard(key).snapshot();
+    auto it = map->find(key);
+    if (it == map->end()) {
         return nullptr;
     }
     return it->second.lock();
 }
 
+WebRtcTransportImp::Ptr WebRtcTransportManager::getItem(const string &key, const struct sockaddr *peer) {
+    if (key.empty()) {
+        return nullptr;
+    }
+    if (!peer || (peer->sa_family != AF_INET && peer->sa_family != AF_INET6)) {
+        return getItem(key);
+    }
+    auto &cache = s_tuple_cache[hashPeer(peer) & (kTransportTupleCacheSize - 1)];
+    if (samePeer(peer, cache.addr) && cache.key == key) {
+        auto ret = cache.transport.lock();
+        if (ret && ret->_registered) {
+            return ret;
+        }
+    }
+    auto ret = getItem(key);
+    if (ret) {
+        memcpy(&cache.addr, peer, SockUtil::get_sock_len(peer));
+        cache.key = key;
+        cache.transport = ret;
+    }
+    return ret;
+}
+
 void WebRtcTransportManager::removeItem(const string &key) {
-    lock_guard<mutex> lck(_mtx);
-    _map.erase(key);
+    getTransportShard(key).modify([&](WebRtcTransportShard::Map &map) {
+        map.erase(key);
+    });
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include "DtlsTransport.hpp"
@@ -23,8 +24,11 @@
 #include "Network/Session.h"
 #include "Nack.h"
 #include "TwccContext.h"
+#include "SharedRtpCache.h"
+#include "SendSideBwe.h"
 #include "SctpAssociation.hpp"
 #include "Rtcp/RtcpContext.h"
+#include "Common/UdpBatchSender.h"
 
 namespace mediakit {
 
@@ -33,6 +37,8 @@ namespace Rtc {
 extern const std::string kPort;
 extern const std::string kTcpPort;
 extern const std::string kTimeOutSec;
+// rtc播放时是否批量srtp加密一次flush的rtp
+extern const std::string kSrtpBatch;
 }//namespace RTC
 
 class WebRtcInterface {
@@ -160,11 +166,29 @@ protected:
     virtual void onBeforeEncryptRtp(const char *buf, int &len, void *ctx) = 0;
     virtual void onBeforeEncryptRtcp(const char *buf, int &len, void *ctx) = 0;
     virtual void onRtcpBye() = 0;
+    // 加密后的rtp发送前回调，默认直接发送，可重载实现平滑发送
+    virtual void onSendEncryptedRtp(Buffer::Ptr buf, bool flush, void *ctx) { onSendSockData(std::move(buf), flush); }
 
 protected:
     void sendRtcpRemb(uint32_t ssrc, size_t bit_rate);
     void sendRtcpPli(uint32_t ssrc);
 
+    /**
+     * 拷贝rtp并回调onBeforeEncryptRtp，得到待加密的明文，与sendRtpPacketList配合实现批量加密
+     * @param buf rtp内容
+     * @param len rtp长度
+     * @param ctx 用户指针
+     */
+    BufferRaw::Ptr prepareRtpPacket(const char *buf, int len, void *ctx);
+
+    /**
+     * 一次性srtp加密多个rtp，并依次回调onSendEncryptedRtp
+     * @param pkts prepareRtpPacket返回的明文，加密后原地修改
+     * @param ctxs 与pkts一一对应的用户指针
+     * @param flush 最后一个rtp是否flush socket
+     */
+    void sendRtpPacketList(std::vector<BufferRaw::Ptr> &pkts, void *const *ctxs, bool flush);
+
 private:
     void sendSockData(const char *buf, size_t len, RTC::TransportTuple *tuple);
     void setRemoteDtlsFingerprint(const RtcSession &remote);
@@ -184,6 +208,9 @@ private:
     Ticker _ticker;
     // 循环池
     ResourcePool<BufferRaw> _packet_pool;
+    // 批量加密参数
+    std::vector<uint8_t *> _batch_data;
+    std::vector<int> _batch_len;
 
 #ifdef ENABLE_SCTP
     RTC::SctpAssociationImp::Ptr _sctp;
@@ -204,8 +231,29 @@ public:
     RtpExtContext::Ptr rtp_ext_ctx;
 
     //for send rtp
-    NackList nack_list;
+    NackList::Ptr nack_list;
     RtcpContext::Ptr rtcp_context_send;
+    //与其他播放器共享的改写后rtp明文缓存
+    SharedRtpCache::Ptr rtp_cache;
+    //发送rtp的transport-cc扩展id，0表示未协商
+    uint8_t twcc_ext_id = 0;
+    //切换rtp源(simulcast切换层)后，发送的seq和时间戳相对源rtp的偏移，保证连续
+    uint16_t seq_offset = 0;
+    uint32_t stamp_offset = 0;
+    //切换过rtp源后，当前seq偏移和重传缓存从该发送seq开始生效
+    bool seq_switched = false;
+    uint16_t seq_begin = 0;
+    //上一个rtp源的重传缓存及偏移，用于重传切换前发送的rtp；更早的rtp不再重传
+    NackList::Ptr prev_nack_list;
+    bool prev_seq_switched = false;
+    uint16_t prev_seq_begin = 0;
+    uint16_t prev_seq_offset = 0;
+    uint32_t prev_stamp_offset = 0;
+    //最近一次发送的rtp信息(已加上偏移)
+    bool rtp_sent = false;
+    uint16_t last_send_seq = 0;
+    uint32_t last_send_stamp = 0;
+    uint64_t last_send_ntp = 0;
 
     //for recv rtp
     std::unordered_map<std::string/*rid*/, std::shared_ptr<RtpChannel> > rtp_channel;
@@ -239,6 +287,7 @@ struct WrappedRtpTrack : public WrappedMediaTrack {
 
 class WebRtcTransportImp : public WebRtcTransport {
 public:
+    friend class WebRtcTransportManager;
     using Ptr = std::shared_ptr<WebRtcTransportImp>;
     ~WebRtcTransportImp() override;
 
@@ -256,6 +305,15 @@ public:
     void setLocalIp(std::string local_ip) override;
     void setIceCandidate(std::vector<SdpAttrCandidate> cands) override;
 
+    const SendSideBwe::Ptr &getSendBwe() const;
+    const RtpPacer::Ptr &getPacer() const;
+
+    /**
+     * 请求推流端发送指定simulcast层的关键帧，可在任意线程调用
+     * @param rid simulcast层的rid
+     */
+    void requestKeyFrame(const std::string &rid);
+
 protected:
     void OnIceServerSelectedTuple(const RTC::IceServer *iceServer, RTC::TransportTuple *tuple) override;
     WebRtcTransportImp(const EventPoller::Ptr &poller);
@@ -275,12 +333,51 @@ protected:
     virtual void onRecvRtp(MediaTrack &track, const std::string &rid, RtpPacket::Ptr rtp) {}
     void updateTicker();
     float getLossRate(TrackType type);
+    /**
+     * 与播放同一个源的其他rtc播放器共享rtp重传缓存和改写后的rtp明文
+     * @param owner 播放的源，用于区分缓存
+     */
+    void shareSendCache(const void *owner);
+    /**
+     * 开启发送端拥塞控制，根据transport-cc反馈估算带宽并平滑发送rtp
+     */
+    void enableSendCongestionControl();
+    /**
+     * 切换rtp源后调用，使后续发送的rtp的seq和时间戳与之前发送的连续
+     * @param rtp 新源的第一个rtp
+     */
+    void resetSendOffset(const RtpPacket::Ptr &rtp);
     void onRtcpBye() override;
+    void onSendEncryptedRtp(Buffer::Ptr buf, bool flush, void *ctx) override;
+    /**
+     * 发送所有等待批量加密的rtp，一次flush的最后一个rtp被跳过时调用
+     */
+    void flushRtp();
 
 private:
+    // 发送rtp时透传给onBeforeEncryptRtp和onSendEncryptedRtp的上下文
+    struct SendRtpContext {
+        SendRtpContext(bool rtx, MediaTrack *track, uint16_t seq_offset, uint32_t stamp_offset)
+            : rtx(rtx), track(track), seq_offset(seq_offset), stamp_offset(stamp_offset) {}
+        bool rtx;
+        MediaTrack *track;
+        // 该rtp发送时使用的seq和时间戳偏移，重传切换rtp源前的rtp时为上一个源的偏移
+        uint16_t seq_offset;
+        uint32_t stamp_offset;
+        // rtp头是否已经改写(来自共享缓存)
+        bool rewritten = false;
+        // 分配的transport-cc序号，-1表示无
+        int twcc_seq = -1;
+    };
+
     void onSortedRtp(MediaTrack &track, const std::string &rid, RtpPacket::Ptr rtp);
     void onSendNack(MediaTrack &track, const FCI_NACK &nack, uint32_t ssrc);
     void onSendTwcc(uint32_t ssrc, const std::string &twcc_fci);
+    void onRecvTwcc(const RtcpFB *fb);
+    void rewriteRtpHeader(const char *buf, int &len, bool rtx, MediaTrack &track, uint16_t seq_offset);
+    void onSendRtp_l(const RtpPacket::Ptr &rtp, bool flush, bool rtx, uint16_t seq_offset, uint32_t stamp_offset);
+    void onRecvNack(MediaTrack &track, const FCI_NACK &fci);
+    void flushRtpBatch(bool flush);
 
     void registerSelf();
     void unregisterSelf();
@@ -294,6 +391,8 @@ private:
     uint64_t _bytes_usage = 0;
     //保持自我强引用
     Ptr _self;
+    //是否已注册到WebRtcTransportManager，供跨线程的查找缓存校验
+    std::atomic<bool> _registered { false };
     //检测超时的定时器
     Timer::Ptr _timer;
     //刷新计时器
@@ -302,6 +401,20 @@ private:
     Ticker _pli_ticker;
     //twcc rtcp发送上下文对象
     TwccContext _twcc_ctx;
+    //发送rtp的transport-cc序号
+    uint16_t _twcc_send_seq = 0;
+    //发送端带宽估算
+    SendSideBwe::Ptr _send_bwe;
+    //rtp平滑发送队列
+    RtpPacer::Ptr _pacer;
+    //是否批量srtp加密
+    bool _srtp_batch = false;
+    //等待批量加密的rtp明文及其发送上下文
+    std::vector<BufferRaw::Ptr> _rtp_batch;
+    std::vector<SendRtpContext> _rtp_batch_ctx;
+    std::vector<void *> _rtp_batch_ctx_ptr;
+    //udp批量发送
+    UdpBatchSender::Ptr _udp_batch_sender;
     //根据发送rtp的track类型获取相关信息
     MediaTrack::Ptr _type_to_track[2];
     //根据rtcp的ssrc获取相关信息，收发rtp和rtx的ssrc都会记录
@@ -319,14 +432,18 @@ public:
     static WebRtcTransportManager &Instance();
     WebRtcTransportImp::Ptr getItem(const std::string &key);
 
+    /**
+     * 查找transport，并按对端地址缓存查找结果
+     * 缓存为线程局部，同一地址重复的stun(连通性检查重传、网络切换后的重连)无需访问全局表
+     * @param key ice用户名
+     * @param peer 对端地址，为空时不使用缓存
+     */
+    WebRtcTransportImp::Ptr getItem(const std::string &key, const struct sockaddr *peer);
+
 private:
     WebRtcTransportManager() = default;
     void addItem(const std::string &key, const WebRtcTransportImp::Ptr &ptr);
     void removeItem(const std::string &key);
-
-private:
-    mutable std::mutex _mtx;
-    std::unordered_map<std::string, std::weak_ptr<WebRtcTransportImp> > _map;
 };
 
 class WebRtcArgs : public std::enable_shared_from_this<WebRtcArgs> {
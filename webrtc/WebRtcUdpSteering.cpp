@@ -0,0 +1,258 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <cstring>
+#include <algorithm>
+#include "WebRtcUdpSteering.h"
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "Util/uv_errno.h"
+#include "Network/sockutil.h"
+#include "Common/config.h"
+#include "Common/ReuseportFilter.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <linux/filter.h>
+#endif
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+constexpr size_t WebRtcUdpSteering::kUfragTagPos;
+constexpr size_t WebRtcUdpSteering::kStunTagOffset;
+constexpr size_t WebRtcUdpSteering::kMaxSocket;
+
+// 校准探测包的username前缀，长度须为kUfragTagPos，不会与base64前缀冲突
+static const char kProbeUser[] = "zlm-rtc-probe";
+static_assert(sizeof(kProbeUser) - 1 == WebRtcUdpSteering::kUfragTagPos, "probe user prefix size mismatch");
+
+WebRtcUdpSteering &WebRtcUdpSteering::Instance() {
+    static WebRtcUdpSteering s_instance;
+    return s_instance;
+}
+
+char WebRtcUdpSteering::indexToTag(size_t index) {
+    if (index < 26) {
+        return 'A' + index;
+    }
+    if (index < kMaxSocket) {
+        return 'a' + (index - 26);
+    }
+    // 数字标记不参与分发，由内核hash
+    return '0';
+}
+
+int WebRtcUdpSteering::tagToIndex(char tag) {
+    if (tag >= 'A' && tag <= 'Z') {
+        return tag - 'A';
+    }
+    if (tag >= 'a' && tag <= 'z') {
+        return tag - 'a' + 26;
+    }
+    return -1;
+}
+
+string WebRtcUdpSteering::makeBindingRequest(char tag, const string &user_prefix, const char *transaction_id) {
+    auto user_name = user_prefix + tag + ":probe";
+    auto padding = (4 - user_name.size() % 4) % 4;
+    auto attr_len = 4 + user_name.size() + padding;
+    string ret(20 + attr_len, '\0');
+    auto ptr = (uint8_t *)&ret[0];
+    // binding request
+    ptr[1] = 0x01;
+    ptr[2] = (attr_len >> 8) & 0xFF;
+    ptr[3] = attr_len & 0xFF;
+    // magic cookie
+    ptr[4] = 0x21;
+    ptr[5] = 0x12;
+    ptr[6] = 0xA4;
+    ptr[7] = 0x42;
+    memcpy(ptr + 8, transaction_id, 12);
+    // username属性
+    ptr[21] = 0x06;
+    ptr[22] = (user_name.size() >> 8) & 0xFF;
+    ptr[23] = user_name.size() & 0xFF;
+    memcpy(ptr + 24, user_name.data(), user_name.size());
+    return ret;
+}
+
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+
+/**
+ * reuseport cbpf程序，输入为udp负载，返回值为组内socket下标，越界时内核回退到hash分发
+ * 浏览器发送的binding request中username总是第一个属性，只处理该情况
+ */
+static ReuseportFilter makeFilter(size_t count) {
+    // 跳转目标
+    enum { kLower = 14, kCheck = 17, kFallback = 19 };
+    ReuseportFilter ret;
+    // 越界读取会直接返回0，必须先检查长度
+    ret.stmt(BPF_LD | BPF_W | BPF_LEN, 0);
+    ret.jump(BPF_JMP | BPF_JGE | BPF_K, WebRtcUdpSteering::kStunTagOffset + 1, -1, kFallback);
+    // binding request
+    ret.stmt(BPF_LD | BPF_H | BPF_ABS, 0);
+    ret.jump(BPF_JMP | BPF_JEQ | BPF_K, 0x0001, -1, kFallback);
+    // magic cookie
+    ret.stmt(BPF_LD | BPF_W | BPF_ABS, 4);
+    ret.jump(BPF_JMP | BPF_JEQ | BPF_K, 0x2112A442, -1, kFallback);
+    // 第一个属性为username
+    ret.stmt(BPF_LD | BPF_H | BPF_ABS, 20);
+    ret.jump(BPF_JMP | BPF_JEQ | BPF_K, 0x0006, -1, kFallback);
+    // 读取poller标记
+    ret.stmt(BPF_LD | BPF_B | BPF_ABS, WebRtcUdpSteering::kStunTagOffset);
+    ret.jump(BPF_JMP | BPF_JGE | BPF_K, 'a', kLower, -1);
+    ret.jump(BPF_JMP | BPF_JGE | BPF_K, 'A', -1, kFallback);
+    ret.jump(BPF_JMP | BPF_JGT | BPF_K, 'Z', kFallback, -1);
+    ret.stmt(BPF_ALU | BPF_SUB | BPF_K, 'A');
+    // 无条件跳转的偏移为k，同样相对下一条指令
+    ret.stmt(BPF_JMP | BPF_JA, kCheck - kLower);
+    // kLower
+    ret.jump(BPF_JMP | BPF_JGT | BPF_K, 'z', kFallback, -1);
+    ret.stmt(BPF_ALU | BPF_SUB | BPF_K, 'a');
+    ret.stmt(BPF_ALU | BPF_ADD | BPF_K, 26);
+    // kCheck
+    ret.jump(BPF_JMP | BPF_JGE | BPF_K, (uint32_t)count, kFallback, -1);
+    ret.stmt(BPF_RET | BPF_A, 0);
+    // kFallback
+    ret.stmt(BPF_RET | BPF_K, 0xFFFFFFFF);
+    return ret;
+}
+
+bool WebRtcUdpSteering::attachFilter(int fd, size_t count) {
+    return makeFilter(count).attach(fd);
+}
+
+bool WebRtcUdpSteering::start(uint16_t port, const string &local_ip) {
+    GET_CONFIG(bool, enable, Rtc::kUdpSteering);
+    if (!enable || _enabled) {
+        return false;
+    }
+    auto count = std::min(EventPollerPool::Instance().getExecutorSize(), kMaxSocket);
+    if (!makeFilter(count).attach(port, local_ip)) {
+        return false;
+    }
+    if (!calibrate(port, local_ip, count)) {
+        return false;
+    }
+    _enabled = true;
+    InfoL << "WebRtc udp steering enabled, socket count: " << count << ", calibrated: " << _poller_tag.size();
+    return true;
+}
+
+bool WebRtcUdpSteering::calibrate(uint16_t port, const string &local_ip, size_t count) {
+    // 各poller上的socket绑定顺序不确定，通过向每个下标发送探测包确定其所属poller
+    auto nonce = makeRandStr(sizeof(_nonce), false);
+    memcpy(_nonce, nonce.data(), sizeof(_nonce));
+    {
+        lock_guard<mutex> lck(_mtx);
+        _found = 0;
+        _index_poller.assign(count, nullptr);
+    }
+    _calibrating = true;
+
+    string dst_ip = local_ip;
+    if (dst_ip == "::") {
+        dst_ip = "::1";
+    } else if (dst_ip == "0.0.0.0") {
+        dst_ip = "127.0.0.1";
+    }
+    auto dst = SockUtil::make_sockaddr(dst_ip.data(), port);
+    auto fd = (int)socket(dst.ss_family, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd == -1) {
+        _calibrating = false;
+        WarnL << "Create probe socket failed: " << get_uv_errmsg(true);
+        return false;
+    }
+
+    unique_lock<mutex> lck(_mtx);
+    for (int retry = 0; retry < 3 && _found < count; ++retry) {
+        for (size_t i = 0; i < count; ++i) {
+            if (_index_poller[i]) {
+                continue;
+            }
+            auto probe = makeBindingRequest(indexToTag(i), kProbeUser, _nonce);
+            ::sendto(fd, probe.data(), probe.size(), 0, (struct sockaddr *)&dst, SockUtil::get_sock_len((struct sockaddr *)&dst));
+        }
+        _cond.wait_for(lck, chrono::milliseconds(200), [&]() { return _found == count; });
+    }
+    _calibrating = false;
+    close(fd);
+
+    _poller_tag.clear();
+    for (size_t i = 0; i < count; ++i) {
+        auto poller = _index_poller[i];
+        if (!poller) {
+            // 未校准的下标不分发，其poller上的ufrag使用不参与分发的标记
+            WarnL << "Probe of rtc udp socket " << i << " timeout";
+            continue;
+        }
+        if (!_poller_tag.emplace(poller, indexToTag(i)).second) {
+            // 同一poller出现在多个下标，说明reuseport组内存在其他socket
+            WarnL << "Rtc udp socket group is not as expected, steering disabled";
+            _poller_tag.clear();
+            return false;
+        }
+    }
+    return !_poller_tag.empty();
+}
+
+#else
+
+bool WebRtcUdpSteering::attachFilter(int fd, size_t count) {
+    return false;
+}
+
+bool WebRtcUdpSteering::start(uint16_t port, const string &local_ip) {
+    GET_CONFIG(bool, enable, Rtc::kUdpSteering);
+    if (enable) {
+        WarnL << "WebRtc udp steering is only supported on linux";
+    }
+    return false;
+}
+
+bool WebRtcUdpSteering::calibrate(uint16_t port, const string &local_ip, size_t count) {
+    return false;
+}
+
+#endif // defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+
+bool WebRtcUdpSteering::onProbe(const Buffer::Ptr &buf) {
+    if (!_calibrating.load(memory_order_relaxed)) {
+        return false;
+    }
+    if (buf->size() <= kStunTagOffset || memcmp(buf->data() + 8, _nonce, sizeof(_nonce)) ||
+        memcmp(buf->data() + 24, kProbeUser, kUfragTagPos)) {
+        return false;
+    }
+    // 创建会话时传入的poller是负载最低的poller，收包socket所属poller为当前线程
+    auto poller = EventPoller::getCurrentPoller();
+    auto index = tagToIndex(buf->data()[kStunTagOffset]);
+    lock_guard<mutex> lck(_mtx);
+    if (poller && index >= 0 && (size_t)index < _index_poller.size() && !_index_poller[index]) {
+        _index_poller[index] = poller.get();
+        if (++_found == _index_poller.size()) {
+            _cond.notify_one();
+        }
+    }
+    return true;
+}
+
+string WebRtcUdpSteering::getUfragTag(const EventPoller::Ptr &poller) const {
+    if (!_enabled.load(memory_order_acquire)) {
+        return "";
+    }
+    auto it = _poller_tag.find(poller.get());
+    return string(1, it == _poller_tag.end() ? indexToTag(kMaxSocket) : it->second);
+}
+
+} // namespace mediakit
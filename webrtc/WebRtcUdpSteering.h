@@ -0,0 +1,112 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_WEBRTCUDPSTEERING_H
+#define ZLMEDIAKIT_WEBRTCUDPSTEERING_H
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <condition_variable>
+#include "Network/Buffer.h"
+#include "Poller/EventPoller.h"
+
+namespace mediakit {
+
+// RTC配置项目
+namespace Rtc {
+// 是否根据ice ufrag把rtc udp数据直接分发到所属poller的SO_REUSEPORT socket(仅linux)
+extern const std::string kUdpSteering;
+} // namespace Rtc
+
+/**
+ * rtc udp端口在每个poller线程上都有一个SO_REUSEPORT socket，
+ * 默认由内核按四元组hash选择socket，新连接的第一个stun包大概率落在其他线程，需要再切换到WebRtcTransport所在poller。
+ * 开启后在reuseport组上挂载cbpf程序，读取stun binding request中ufrag携带的poller标记，
+ * 把数据包直接投递到WebRtcTransport所在poller的socket上，不能识别的数据包仍按hash分发
+ */
+class WebRtcUdpSteering {
+public:
+    // ufrag中poller标记所在位置，ufrag格式: base64(8字节，12个字符) + '_' + 标记 + number
+    static constexpr size_t kUfragTagPos = 13;
+    // 标记在stun包中的偏移: stun头(20字节) + 第一个属性(username)头(4字节)
+    static constexpr size_t kStunTagOffset = 24 + kUfragTagPos;
+    // 标记使用A-Z、a-z，最多区分52个socket
+    static constexpr size_t kMaxSocket = 52;
+
+    static WebRtcUdpSteering &Instance();
+
+    /**
+     * socket下标转ufrag标记，超出范围时返回不参与分发的标记
+     */
+    static char indexToTag(size_t index);
+
+    /**
+     * ufrag标记转socket下标，不合法时返回-1
+     */
+    static int tagToIndex(char tag);
+
+    /**
+     * 在fd所在的reuseport组上挂载分发程序
+     * @param fd 已绑定端口的SO_REUSEPORT udp socket
+     * @param count 参与分发的socket个数，即组内前count个socket
+     * @return 是否成功
+     */
+    static bool attachFilter(int fd, size_t count);
+
+    /**
+     * 生成以标记开头的stun binding request，用于校准或测试
+     * @param tag ufrag标记
+     * @param user_prefix username中标记之前的部分，长度必须为kUfragTagPos
+     * @param transaction_id 12字节事务id
+     */
+    static std::string makeBindingRequest(char tag, const std::string &user_prefix, const char *transaction_id);
+
+    /**
+     * rtc udp服务器启动后调用，挂载分发程序并校准socket下标与poller的对应关系
+     * @param port rtc udp端口
+     * @param local_ip 监听ip
+     * @return 是否开启成功
+     */
+    bool start(uint16_t port, const std::string &local_ip);
+
+    /**
+     * udp服务器收到新客户端数据时在收包线程调用，识别并消费校准探测包
+     * @return 是否为探测包
+     */
+    bool onProbe(const toolkit::Buffer::Ptr &buf);
+
+    /**
+     * 获取poller对应的ufrag标记，未开启时返回空
+     */
+    std::string getUfragTag(const toolkit::EventPoller::Ptr &poller) const;
+
+private:
+    WebRtcUdpSteering() = default;
+
+    bool calibrate(uint16_t port, const std::string &local_ip, size_t count);
+
+private:
+    std::atomic<bool> _enabled { false };
+    std::atomic<bool> _calibrating { false };
+    char _nonce[12];
+    size_t _found = 0;
+    std::mutex _mtx;
+    std::condition_variable _cond;
+    std::vector<toolkit::EventPoller *> _index_poller;
+    // 开启后只读
+    std::unordered_map<toolkit::EventPoller *, char> _poller_tag;
+};
+
+} // namespace mediakit
+
+#endif // ZLMEDIAKIT_WEBRTCUDPSTEERING_H